@@ -18,19 +18,39 @@ src/autoroute/autorouter.h \
 src/autoroute/autorouteprogressdialog.h \
 src/autoroute/autoroutersettingsdialog.h \
 src/autoroute/checker.h  \
+src/autoroute/clearanceindex.h  \
+src/autoroute/copperclearance.h  \
 src/autoroute/binpacking/Rect.h  \
 src/autoroute/binpacking/GuillotineBinPack.h  \
 src/autoroute/mazerouter/mazerouter.h  \
+src/autoroute/mazerouter/gridqueue.h  \
+src/autoroute/mazerouter/cellscan.h  \
+src/autoroute/mazerouter/gridtiles.h  \
+src/autoroute/mazerouter/searchstages.h  \
+src/autoroute/mazerouter/orderingqueue.h  \
+src/autoroute/mazerouter/displaytiles.h  \
 src/autoroute/zoomcontrols.h \
 src/autoroute/drc.h \
+src/autoroute/livedrc.h \
+src/autoroute/pixelscan.h \
 
 SOURCES += \
 src/autoroute/autorouter.cpp \
 src/autoroute/autorouteprogressdialog.cpp \
 src/autoroute/autoroutersettingsdialog.cpp \
 src/autoroute/checker.cpp  \
+src/autoroute/clearanceindex.cpp  \
+src/autoroute/copperclearance.cpp  \
 src/autoroute/binpacking/Rect.cpp  \
 src/autoroute/binpacking/GuillotineBinPack.cpp  \
 src/autoroute/mazerouter/mazerouter.cpp  \
+src/autoroute/mazerouter/gridqueue.cpp  \
+src/autoroute/mazerouter/cellscan.cpp  \
+src/autoroute/mazerouter/gridtiles.cpp  \
+src/autoroute/mazerouter/searchstages.cpp  \
+src/autoroute/mazerouter/orderingqueue.cpp  \
+src/autoroute/mazerouter/displaytiles.cpp  \
 src/autoroute/zoomcontrols.cpp \
 src/autoroute/drc.cpp \
+src/autoroute/livedrc.cpp \
+src/autoroute/pixelscan.cpp \
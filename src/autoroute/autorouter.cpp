@@ -36,6 +36,16 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 #include <QSettings>
 
 const QString Autorouter::MaxCyclesName("cmrouter/maxcycles");
+const QString Autorouter::WorkerCountName("cmrouter/workers");
+const QString Autorouter::LookaheadName("cmrouter/lookahead");
+const QString Autorouter::FrontierName("cmrouter/frontier");
+const QString Autorouter::RasterizerName("cmrouter/rasterizer");
+const QString Autorouter::ShortcutCheckName("cmrouter/shortcuts");
+const QString Autorouter::StrategyName("cmrouter/strategy");
+const QString Autorouter::CorridorName("cmrouter/corridors");
+const QString Autorouter::RegionName("cmrouter/regions");
+const QString Autorouter::NodeBudgetName("cmrouter/nodebudget");
+const QString Autorouter::MemoryBudgetName("cmrouter/memorybudget");
 
 Autorouter::Autorouter(PCBSketchWidget * sketchWidget) : m_sketchWidget(sketchWidget)
 {
@@ -111,10 +121,11 @@ void Autorouter::useBest() {
 	m_useBest = m_stopTracing = true;
 }
 
-void Autorouter::initUndo(QUndoCommand * parentCommand)
+void Autorouter::initUndo(QUndoCommand * parentCommand, const QSet<ItemBase *> * ripUp)
 {
 	// autoroutable traces, jumpers and vias are saved on the undo command and deleted
 	// non-autoroutable traces, jumpers and via are not deleted
+	// given ripUp, autoroutable items not in it are left alone as well, and stay autoroutable
 
 	QList<ItemBase *> toDelete;
 	QList<QGraphicsItem *> collidingItems;
@@ -125,6 +136,8 @@ void Autorouter::initUndo(QUndoCommand * parentCommand)
 			if (jumperItem == nullptr) continue;
 
 			if (jumperItem->getAutoroutable()) {
+				if (ripUp && !ripUp->contains(jumperItem)) continue;
+
 				addUndoConnection(false, jumperItem, parentCommand);
 				toDelete.append(jumperItem);
 				continue;
@@ -153,6 +166,8 @@ void Autorouter::initUndo(QUndoCommand * parentCommand)
 			if (via == nullptr) continue;
 
 			if (via->getAutoroutable()) {
+				if (ripUp && !ripUp->contains(via)) continue;
+
 				addUndoConnection(false, via, parentCommand);
 				toDelete.append(via);
 				continue;
@@ -185,6 +200,8 @@ void Autorouter::initUndo(QUndoCommand * parentCommand)
 			if (!netLabel->isOnlyNetLabel()) continue;
 
 			if (netLabel->getAutoroutable()) {
+				if (ripUp && !ripUp->contains(netLabel)) continue;
+
 				addUndoConnection(false, netLabel, parentCommand);
 				toDelete.append(netLabel);
 				continue;
@@ -231,6 +248,7 @@ void Autorouter::initUndo(QUndoCommand * parentCommand)
 		if (traceWire == nullptr) continue;
 		if (!traceWire->isTraceType(m_sketchWidget->getTraceFlag())) continue;
 		if (!traceWire->getAutoroutable()) continue;
+		if (ripUp && !ripUp->contains(traceWire)) continue;
 
 		toDelete.append(traceWire);
 		addUndoConnection(false, traceWire, parentCommand);
@@ -430,6 +448,22 @@ void Autorouter::addWireToUndo(Wire * wire, QUndoCommand * parentCommand)
 	new WireColorChangeCommand(m_sketchWidget, wire->id(), wire->colorString(), wire->colorString(), wire->opacity(), wire->opacity(), parentCommand);
 }
 
+void Autorouter::addWireToUndo(Wire * wire, AutorouteResultCommand * resultCommand)
+{
+	if (wire == nullptr) return;
+
+	AutorouteResultCommand::Item item;
+	item.moduleID = ModuleIDNames::WireModuleIDName;
+	item.viewLayerPlacement = wire->viewLayerPlacement();
+	item.viewGeometry = wire->getViewGeometry();
+	item.id = wire->id();
+	item.checkSticky = true;
+	item.wireWidth = wire->width();
+	item.wireColor = wire->colorString();
+	item.wireOpacity = wire->opacity();
+	resultCommand->addItem(item);
+}
+
 void Autorouter::setMaxCycles(int maxCycles)
 {
 	m_maxCycles = maxCycles;
@@ -23,6 +23,7 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QAction>
 #include <QHash>
+#include <QSet>
 #include <QVector>
 #include <QList>
 #include <QPointF>
@@ -31,6 +32,8 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 #include <QProgressDialog>
 #include <QUndoCommand>
 
+#include <atomic>
+
 #include "../viewgeometry.h"
 #include "../viewlayer.h"
 #include "../connectors/connectoritem.h"
@@ -52,13 +55,24 @@ public:
 
 public:
 	static const QString MaxCyclesName;
+	static const QString WorkerCountName;
+	static const QString LookaheadName;
+	static const QString FrontierName;
+	static const QString RasterizerName;
+	static const QString ShortcutCheckName;
+	static const QString StrategyName;
+	static const QString CorridorName;
+	static const QString RegionName;
+	static const QString NodeBudgetName;
+	static const QString MemoryBudgetName;
+	static constexpr int DefaultMemoryBudget = 1024;		// MB for the routing grids, 0 for no limit
 
 
 protected:
 	virtual void cleanUpNets();
 	virtual void updateRoutingStatus();
 	virtual class TraceWire * drawOneTrace(QPointF fromPos, QPointF toPos, double width, ViewLayer::ViewLayerPlacement);
-	void initUndo(QUndoCommand * parentCommand);
+	void initUndo(QUndoCommand * parentCommand, const QSet<ItemBase *> * ripUp = nullptr);
 	void addUndoConnection(bool connect, SymbolPaletteItem *, QUndoCommand * parentCommand);
 	void addUndoConnection(bool connect, JumperItem *, QUndoCommand * parentCommand);
 	void addUndoConnection(bool connect, Via *, QUndoCommand * parentCommand);
@@ -69,6 +83,7 @@ protected:
 	void clearTracesAndJumpers();
 	void addToUndo(QUndoCommand * parentCommand);
 	void addWireToUndo(Wire * wire, QUndoCommand * parentCommand);
+	void addWireToUndo(Wire * wire, AutorouteResultCommand * resultCommand);
 
 public Q_SLOTS:
 	virtual void cancel();
@@ -92,10 +107,11 @@ Q_SIGNALS:
 protected:
 	PCBSketchWidget * m_sketchWidget = nullptr;
 	QList< QList<ConnectorItem*>* > m_allPartConnectorItems;
-	bool m_cancelled = false;
-	bool m_cancelTrace = false;
-	bool m_stopTracing = false;
-	bool m_useBest = false;
+	// set from the GUI thread while the search runs on a pool thread
+	std::atomic<bool> m_cancelled { false };
+	std::atomic<bool> m_cancelTrace { false };
+	std::atomic<bool> m_stopTracing { false };
+	std::atomic<bool> m_useBest { false };
 	bool m_bothSidesNow = false;
 	int m_maximumProgressPart = 0;
 	int m_currentProgressPart = 0;
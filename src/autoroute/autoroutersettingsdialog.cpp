@@ -47,6 +47,7 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 #include "../utils/textutils.h"
 #include "../utils/graphicsutils.h"
 #include "drc.h"
+#include "autorouter.h"
 
 
 const QString AutorouterSettingsDialog::AutorouteTraceWidth = "autorouteTraceWidth";
@@ -110,6 +111,7 @@ AutorouterSettingsDialog::AutorouterSettingsDialog(QHash<QString, QString> & set
 	prodLayout->addWidget(m_customFrame);
 
 	windowLayout->addWidget(prodGroupBox);
+	windowLayout->addWidget(createMemoryWidget());
 
 	windowLayout->addSpacerItem(new QSpacerItem(1, 10, QSizePolicy::Preferred, QSizePolicy::Expanding));
 
@@ -303,6 +305,28 @@ QWidget * AutorouterSettingsDialog::createKeepoutWidget(const QString & keepoutS
 	return keepoutGroupBox;
 }
 
+QWidget * AutorouterSettingsDialog::createMemoryWidget() {
+	// not a per-sketch setting like the others: it depends on the machine, so it lives in QSettings only
+	auto * memoryGroupBox = new QGroupBox(tr("Memory"), this);
+	auto * vLayout = new QVBoxLayout();
+
+	auto * label = new QLabel(tr("A board whose routing grid needs more memory than this is routed in tiles,\nkeeping only the recently used ones in memory."));
+	vLayout->addWidget(label);
+
+	m_memoryBudgetSpinBox = new QSpinBox;
+	m_memoryBudgetSpinBox->setRange(0, 1024 * 1024);
+	m_memoryBudgetSpinBox->setSingleStep(256);
+	m_memoryBudgetSpinBox->setSuffix(" MB");
+	m_memoryBudgetSpinBox->setSpecialValueText(tr("no limit"));
+	QSettings settings;
+	m_memoryBudgetSpinBox->setValue(settings.value(Autorouter::MemoryBudgetName, Autorouter::DefaultMemoryBudget).toInt());
+	vLayout->addWidget(m_memoryBudgetSpinBox);
+
+	memoryGroupBox->setLayout(vLayout);
+
+	return memoryGroupBox;
+}
+
 QWidget * AutorouterSettingsDialog::createTraceWidget() {
 	auto * traceGroupBox = new QGroupBox(tr("Trace width"), this);
 	auto * traceLayout = new QVBoxLayout();
@@ -381,6 +405,13 @@ QHash<QString, QString> AutorouterSettingsDialog::getSettings() {
 	return settings;
 }
 
+void AutorouterSettingsDialog::accept() {
+	QSettings settings;
+	settings.setValue(Autorouter::MemoryBudgetName, m_memoryBudgetSpinBox->value());
+
+	QDialog::accept();
+}
+
 QString AutorouterSettingsDialog::getKeepoutString()
 {
 	double k = m_keepoutSpinBox->value();
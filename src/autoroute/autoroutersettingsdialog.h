@@ -27,6 +27,7 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 #include <QRadioButton>
 #include <QGroupBox>
 #include <QDoubleSpinBox>
+#include <QSpinBox>
 
 #include "../items/via.h"
 
@@ -40,6 +41,9 @@ public:
 
 	QHash<QString, QString> getSettings();
 
+public Q_SLOTS:
+	void accept() override;
+
 protected Q_SLOTS:
 	void production(bool);
 	void widthEntry(int index);
@@ -58,6 +62,7 @@ protected:
 	QWidget * createViaWidget();
 	QWidget * createTraceWidget();
 	QWidget * createKeepoutWidget(const QString & keepoutString);
+	QWidget * createMemoryWidget();
 	QString getKeepoutString();
 	void setDefaultKeepout();
 	void widthEntry(const QString &);
@@ -76,6 +81,7 @@ protected:
 	QDoubleSpinBox * m_keepoutSpinBox;
 	QRadioButton * m_inRadio;
 	QRadioButton * m_mmRadio;
+	QSpinBox * m_memoryBudgetSpinBox;
 
 public:
 	static const QString AutorouteTraceWidth;
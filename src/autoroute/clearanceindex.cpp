@@ -0,0 +1,161 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+#include "clearanceindex.h"
+
+#include <boost/geometry.hpp>
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/geometries/point.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
+#include <qmath.h>
+#include <iterator>
+#include <vector>
+
+namespace bg = boost::geometry;
+namespace bgi = boost::geometry::index;
+
+typedef bg::model::point<double, 2, bg::cs::cartesian> IndexPoint;
+typedef bg::model::box<IndexPoint> IndexBox;
+typedef std::pair<IndexBox, int> IndexEntry;
+
+static IndexBox toBox(const QRectF & r) {
+	return IndexBox(IndexPoint(r.left(), r.top()), IndexPoint(r.right(), r.bottom()));
+}
+
+struct ClearanceIndex::Tree {
+	bgi::rtree<IndexEntry, bgi::quadratic<16> > rtree;
+
+	template <typename Iterator>
+	Tree(Iterator begin, Iterator end) : rtree(begin, end) {}
+};
+
+////////////////////////////////////////////////////////////////////
+
+ClearanceIndex::ClearanceIndex()
+{
+}
+
+ClearanceIndex::~ClearanceIndex()
+{
+}
+
+void ClearanceIndex::clear() {
+	m_shapes.clear();
+	m_bounds.clear();
+	m_tree.reset();
+}
+
+int ClearanceIndex::count() const {
+	return m_shapes.count();
+}
+
+void ClearanceIndex::add(const Shape & shape, const QRectF & bounds) {
+	m_shapes.append(shape);
+	m_bounds.append(bounds);
+	m_tree.reset();
+}
+
+void ClearanceIndex::addSegment(const QLineF & line, double radius, int owner) {
+	Shape shape;
+	shape.line = line;
+	shape.radius = radius;
+	shape.owner = owner;
+	QRectF bounds = QRectF(line.p1(), line.p2()).normalized().adjusted(-radius, -radius, radius, radius);
+	add(shape, bounds);
+}
+
+void ClearanceIndex::addCircle(const QPointF & center, double radius, int owner) {
+	addSegment(QLineF(center, center), radius, owner);
+}
+
+void ClearanceIndex::addPolygon(const QPolygonF & polygon, Qt::FillRule fillRule, int owner) {
+	if (polygon.count() < 3) return;
+
+	Shape shape;
+	shape.polygon = polygon;
+	shape.fillRule = fillRule;
+	shape.owner = owner;
+	add(shape, polygon.boundingRect());
+}
+
+bool ClearanceIndex::clears(const QLineF & line, double halfWidth, int owner) const {
+	if (m_shapes.isEmpty()) return true;
+
+	if (!m_tree) {
+		// bulk loading packs the tree better than inserting one shape at a time
+		std::vector<IndexEntry> entries;
+		entries.reserve(m_shapes.count());
+		for (int i = 0; i < m_bounds.count(); i++) {
+			entries.push_back(std::make_pair(toBox(m_bounds.at(i)), i));
+		}
+		m_tree.reset(new Tree(entries.begin(), entries.end()));
+	}
+
+	QRectF area = QRectF(line.p1(), line.p2()).normalized().adjusted(-halfWidth, -halfWidth, halfWidth, halfWidth);
+	std::vector<IndexEntry> hits;
+	m_tree->rtree.query(bgi::intersects(toBox(area)), std::back_inserter(hits));
+	for (const IndexEntry & hit : hits) {
+		const Shape & shape = m_shapes.at(hit.second);
+		if (owner >= 0 && shape.owner == owner) continue;
+		if (touches(shape, line, halfWidth)) return false;
+	}
+
+	return true;
+}
+
+bool ClearanceIndex::touches(const Shape & shape, const QLineF & line, double halfWidth) const {
+	if (shape.polygon.isEmpty()) {
+		return segmentDistance(line, shape.line) < shape.radius + halfWidth;
+	}
+
+	// inside the polygon, or crossing or coming within halfWidth of one of its edges
+	if (shape.polygon.containsPoint(line.p1(), shape.fillRule)) return true;
+
+	int count = shape.polygon.count();
+	for (int i = 0; i < count; i++) {
+		QLineF edge(shape.polygon.at(i), shape.polygon.at((i + 1) % count));
+		if (segmentDistance(line, edge) < halfWidth) return true;
+	}
+
+	return false;
+}
+
+double ClearanceIndex::pointDistance(const QPointF & p, const QLineF & line) {
+	double dx = line.dx();
+	double dy = line.dy();
+	double lengthSquared = (dx * dx) + (dy * dy);
+	QPointF nearest = line.p1();
+	if (lengthSquared > 0) {
+		double t = ((p.x() - line.x1()) * dx + (p.y() - line.y1()) * dy) / lengthSquared;
+		t = qBound(0.0, t, 1.0);
+		nearest = QPointF(line.x1() + (t * dx), line.y1() + (t * dy));
+	}
+
+	return QLineF(p, nearest).length();
+}
+
+double ClearanceIndex::segmentDistance(const QLineF & a, const QLineF & b) {
+	if (a.length() > 0 && b.length() > 0 && a.intersects(b, nullptr) == QLineF::BoundedIntersection) return 0;
+
+	double d = qMin(pointDistance(a.p1(), b), pointDistance(a.p2(), b));
+	d = qMin(d, pointDistance(b.p1(), a));
+	return qMin(d, pointDistance(b.p2(), a));
+}
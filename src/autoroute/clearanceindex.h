@@ -0,0 +1,76 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+#ifndef CLEARANCEINDEX_H
+#define CLEARANCEINDEX_H
+
+#include <QLineF>
+#include <QPolygonF>
+#include <QRectF>
+#include <QVector>
+
+#include <memory>
+
+// Copper shapes, each already grown by the clearance it needs, kept in an R-tree.
+// clears() answers whether a straight trace of a given half width stays off all of them,
+// testing only the shapes whose bounding boxes are near the trace.
+// Every shape has an owner, normally a net index; a query made on behalf of an owner
+// ignores that owner's shapes.  Shapes with owner -1 are never ignored.
+
+class ClearanceIndex
+{
+public:
+	ClearanceIndex();
+	~ClearanceIndex();
+	ClearanceIndex(const ClearanceIndex &) = delete;
+	ClearanceIndex & operator=(const ClearanceIndex &) = delete;
+
+	void clear();
+	void addSegment(const QLineF &, double radius, int owner = -1);		// a trace with round caps
+	void addCircle(const QPointF & center, double radius, int owner = -1);
+	void addPolygon(const QPolygonF &, Qt::FillRule, int owner = -1);
+	int count() const;
+
+	bool clears(const QLineF &, double halfWidth, int owner = -1) const;
+
+	static double pointDistance(const QPointF &, const QLineF &);
+	static double segmentDistance(const QLineF &, const QLineF &);
+
+protected:
+	struct Shape {
+		QLineF line;			// capsule spine; p1 == p2 for a circle
+		double radius = 0;
+		QPolygonF polygon;		// not empty for a polygon, which has no radius
+		Qt::FillRule fillRule = Qt::OddEvenFill;
+		int owner = -1;
+	};
+
+	struct Tree;
+
+	void add(const Shape &, const QRectF & bounds);
+	bool touches(const Shape &, const QLineF &, double halfWidth) const;
+
+protected:
+	QVector<Shape> m_shapes;
+	QVector<QRectF> m_bounds;
+	mutable std::unique_ptr<Tree> m_tree;		// built by the first query after a change
+};
+
+#endif
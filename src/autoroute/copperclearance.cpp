@@ -0,0 +1,234 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+#include "copperclearance.h"
+
+#include <boost/geometry.hpp>
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/geometries/point.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+namespace bg = boost::geometry;
+namespace bgi = boost::geometry::index;
+
+typedef bg::model::point<double, 2, bg::cs::cartesian> IndexPoint;
+typedef bg::model::box<IndexPoint> IndexBox;
+typedef std::pair<IndexBox, int> IndexEntry;
+
+static constexpr double ArcTolerance = CopperClearance::Scale / 100;			// how far a round edge may stray from the arc
+static constexpr double MinOverlapArea = ArcTolerance * ArcTolerance;			// anything smaller is shapes just touching
+
+static ClipperLib::IntPoint toClipper(const QPointF & p) {
+	return ClipperLib::IntPoint((ClipperLib::cInt) qRound64(p.x() * CopperClearance::Scale), (ClipperLib::cInt) qRound64(p.y() * CopperClearance::Scale));
+}
+
+static QPolygonF fromClipper(const ClipperLib::Path & path) {
+	QPolygonF polygon;
+	for (const ClipperLib::IntPoint & p : path) {
+		polygon << QPointF(p.X / CopperClearance::Scale, p.Y / CopperClearance::Scale);
+	}
+	if (!polygon.isEmpty()) polygon << polygon.first();
+	return polygon;
+}
+
+static bool boundsOf(const ClipperLib::Paths & paths, IndexBox & box) {
+	bool any = false;
+	double minX = 0, minY = 0, maxX = 0, maxY = 0;
+	for (const ClipperLib::Path & path : paths) {
+		for (const ClipperLib::IntPoint & p : path) {
+			if (!any) {
+				minX = maxX = p.X;
+				minY = maxY = p.Y;
+				any = true;
+				continue;
+			}
+			minX = qMin(minX, (double) p.X);
+			maxX = qMax(maxX, (double) p.X);
+			minY = qMin(minY, (double) p.Y);
+			maxY = qMax(maxY, (double) p.Y);
+		}
+	}
+
+	box = IndexBox(IndexPoint(minX, minY), IndexPoint(maxX, maxY));
+	return any;
+}
+
+struct CopperClearance::Tree {
+	bgi::rtree<IndexEntry, bgi::quadratic<16> > rtree;
+	QHash<int, IndexBox> boxes;						// what each shape was inserted with, to take it out again
+};
+
+////////////////////////////////////////////////////////////////////
+
+CopperClearance::CopperClearance(double keepout) :
+	m_keepout(keepout),
+	m_tree(new Tree)
+{
+}
+
+CopperClearance::~CopperClearance()
+{
+}
+
+void CopperClearance::addSegment(const QLineF & line, double width, int owner) {
+	ClipperLib::Path spine;
+	spine << toClipper(line.p1()) << toClipper(line.p2());
+	ClipperLib::Paths paths;
+	paths << spine;
+	add(paths, true, width / 2, owner);
+}
+
+void CopperClearance::addPath(const QPainterPath & path, int owner) {
+	// union the subpaths first, so the offset sees simple outlines whatever the fill rule was
+	ClipperLib::Paths polygons;
+	Q_FOREACH (const QPolygonF & polygon, path.toFillPolygons()) {
+		ClipperLib::Path clipperPath;
+		for (const QPointF & p : polygon) {
+			clipperPath << toClipper(p);
+		}
+		polygons << clipperPath;
+	}
+
+	ClipperLib::Clipper clipper;
+	clipper.AddPaths(polygons, ClipperLib::ptSubject, true);
+	ClipperLib::PolyFillType fillType = path.fillRule() == Qt::WindingFill ? ClipperLib::pftNonZero : ClipperLib::pftEvenOdd;
+	ClipperLib::Paths outlines;
+	clipper.Execute(ClipperLib::ctUnion, outlines, fillType, fillType);
+	add(outlines, false, 0, owner);
+}
+
+void CopperClearance::add(const ClipperLib::Paths & paths, bool open, double radius, int owner) {
+	// two shapes are too close when they come within the keepout of each other,
+	// which is when they overlap after each has grown by half of it
+	Shape shape;
+	shape.owner = owner;
+	double delta = (radius + (m_keepout / 2)) * Scale;
+	if (!open && delta <= 0) {
+		shape.grown = paths;
+	}
+	else {
+		ClipperLib::ClipperOffset offset(2, ArcTolerance);
+		offset.AddPaths(paths, ClipperLib::jtRound, open ? ClipperLib::etOpenRound : ClipperLib::etClosedPolygon);
+		offset.Execute(shape.grown, delta);
+	}
+
+	int index = m_shapes.count();
+	m_shapes.append(shape);					// even when empty, so shape indexes follow the calls
+	m_ownerShapes.insert(owner, index);
+
+	IndexBox box;
+	if (boundsOf(shape.grown, box)) {
+		m_tree->rtree.insert(std::make_pair(box, index));
+		m_tree->boxes.insert(index, box);
+	}
+}
+
+void CopperClearance::removeOwner(int owner) {
+	// the slots stay, so the indexes of other shapes do not move
+	Q_FOREACH (int index, m_ownerShapes.values(owner)) {
+		Shape & shape = m_shapes[index];
+		shape.removed = true;
+		shape.grown.clear();
+		auto box = m_tree->boxes.find(index);
+		if (box != m_tree->boxes.end()) {
+			m_tree->rtree.remove(std::make_pair(box.value(), index));
+			m_tree->boxes.erase(box);
+		}
+	}
+	m_ownerShapes.remove(owner);
+}
+
+int CopperClearance::count() const {
+	return m_shapes.count();
+}
+
+int CopperClearance::owner(int shape) const {
+	return m_shapes.at(shape).owner;
+}
+
+double CopperClearance::keepout() const {
+	return m_keepout;
+}
+
+QList<CopperClearance::Overlap> CopperClearance::overlaps() const {
+	QList<Overlap> overlaps;
+	for (auto it = m_tree->boxes.constBegin(); it != m_tree->boxes.constEnd(); ++it) {
+		overlapsOf(it.key(), QSet<int>(), overlaps);
+	}
+
+	std::sort(overlaps.begin(), overlaps.end(), [](const Overlap & a, const Overlap & b) {
+		return a.first != b.first ? a.first < b.first : a.second < b.second;
+	});
+	return overlaps;
+}
+
+QList<CopperClearance::Overlap> CopperClearance::overlaps(const QSet<int> & owners) const {
+	QList<Overlap> overlaps;
+	Q_FOREACH (int owner, owners) {
+		Q_FOREACH (int index, m_ownerShapes.values(owner)) {
+			if (m_tree->boxes.contains(index)) overlapsOf(index, owners, overlaps);
+		}
+	}
+
+	std::sort(overlaps.begin(), overlaps.end(), [](const Overlap & a, const Overlap & b) {
+		return a.first != b.first ? a.first < b.first : a.second < b.second;
+	});
+	return overlaps;
+}
+
+void CopperClearance::overlapsOf(int i, const QSet<int> & owners, QList<Overlap> & overlaps) const {
+	// with no owners every shape is asked, so each pair is taken from its lower index;
+	// otherwise a pair is taken from its lower index only when both shapes are asked
+	std::vector<IndexEntry> hits;
+	m_tree->rtree.query(bgi::intersects(m_tree->boxes.value(i)), std::back_inserter(hits));
+	int owner = m_shapes.at(i).owner;
+	for (const IndexEntry & hit : hits) {
+		int j = hit.second;
+		if (j == i) continue;
+
+		const Shape & other = m_shapes.at(j);
+		if (other.owner == owner) continue;
+		if (j < i && (owners.isEmpty() || owners.contains(other.owner))) continue;
+
+		ClipperLib::Clipper clipper;
+		clipper.AddPaths(m_shapes.at(i).grown, ClipperLib::ptSubject, true);
+		clipper.AddPaths(other.grown, ClipperLib::ptClip, true);
+		ClipperLib::Paths intersection;
+		clipper.Execute(ClipperLib::ctIntersection, intersection, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+
+		double area = 0;
+		for (const ClipperLib::Path & path : intersection) {
+			area += ClipperLib::Area(path);
+		}
+		if (qAbs(area) < MinOverlapArea) continue;
+
+		Overlap overlap;
+		overlap.first = qMin(i, j);
+		overlap.second = qMax(i, j);
+		for (const ClipperLib::Path & path : intersection) {
+			overlap.region << fromClipper(path);
+		}
+		overlaps << overlap;
+	}
+}
@@ -0,0 +1,88 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+#ifndef COPPERCLEARANCE_H
+#define COPPERCLEARANCE_H
+
+#include <QLineF>
+#include <QList>
+#include <QMultiHash>
+#include <QPainterPath>
+#include <QPolygonF>
+#include <QSet>
+#include <QVector>
+
+#include <clipper.hpp>
+#include <memory>
+
+// The copper on one side of a board as polygons, for a DRC that does not depend on a
+// resolution.  Every shape is grown by half the keepout as it is added and goes into an
+// R-tree; overlaps() looks up the shapes whose boxes meet and keeps the pairs whose grown
+// shapes really intersect.  Every shape has an owner, normally a net index: shapes with the
+// same owner never collide, and owner -1 (copper on no net) collides with every owner but -1.
+// Owners can be taken out and put back, so a live check only redoes the nets that changed.
+
+class CopperClearance
+{
+public:
+	static constexpr double Scale = 1000;			// Clipper units per scene unit
+
+	struct Overlap {
+		int first;									// shape indexes, first < second
+		int second;
+		QList<QPolygonF> region;					// where the grown shapes meet, in scene units
+	};
+
+public:
+	CopperClearance(double keepout);
+	~CopperClearance();
+	CopperClearance(const CopperClearance &) = delete;
+	CopperClearance & operator=(const CopperClearance &) = delete;
+
+	void addSegment(const QLineF &, double width, int owner);	// a trace with round caps
+	void addPath(const QPainterPath &, int owner);				// filled, using the path's fill rule
+	void removeOwner(int owner);
+	int count() const;								// shapes added so far, removed ones included
+	int owner(int shape) const;
+	double keepout() const;
+
+	QList<Overlap> overlaps() const;							// sorted by first, then second
+	QList<Overlap> overlaps(const QSet<int> & owners) const;	// only pairs with a shape of one of these owners
+
+protected:
+	struct Shape {
+		ClipperLib::Paths grown;
+		int owner = -1;
+		bool removed = false;
+	};
+
+	struct Tree;
+
+	void add(const ClipperLib::Paths &, bool open, double radius, int owner);
+	void overlapsOf(int shape, const QSet<int> & owners, QList<Overlap> &) const;
+
+protected:
+	double m_keepout;
+	QVector<Shape> m_shapes;
+	QMultiHash<int, int> m_ownerShapes;
+	std::unique_ptr<Tree> m_tree;
+};
+
+#endif
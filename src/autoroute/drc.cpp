@@ -30,7 +30,11 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 #include "../fsvgrenderer.h"
 #include "../viewlayer.h"
 #include "../processeventblocker.h"
+#include "../items/pad.h"
 #include "src/items/wire.h"
+#include "copperclearance.h"
+#include "pixelscan.h"
+#include "../model/partcopper.h"
 
 #include <qmath.h>
 #include <QApplication>
@@ -44,6 +48,10 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 #include <QLabel>
 #include <QListWidget>
 #include <QRadioButton>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QThread>
+#include <QtConcurrentRun>
 
 ///////////////////////////////////////////
 //
@@ -61,32 +69,26 @@ const QString DRC::Net = "net";
 
 const uchar DRC::BitTable[] = { 128, 64, 32, 16, 8, 4, 2, 1 };
 
-bool pixelsCollide(QImage * image1, QImage * image2, QImage * image3, int x1, int y1, int x2, int y2, uint clr, QList<QPointF> & points) {
+static constexpr int MaxCollisionPoints = 1000;		// enough for findItemsAt() to tell what is there
+
+bool pixelsCollide(const QImage * image1, const QImage * image2, QImage * image3, int x1, int y1, int x2, int y2, uint clr, QList<QPointF> & points) {
+	// image3 may be null when only the answer is wanted
 	bool result = false;
-	const uchar * bits1 = image1->constScanLine(0);
-	const uchar * bits2 = image2->constScanLine(0);
+	x1 = qMax(x1, 0);
+	y1 = qMax(y1, 0);
+	x2 = qMin(x2, image1->width());
+	y2 = qMin(y2, image1->height());
 	int bytesPerLine = image1->bytesPerLine();
+	int xs[MaxCollisionPoints];
 	for (int y = y1; y < y2; y++) {
-		int offset = y * bytesPerLine;
-		for (int x = x1; x < x2; x++) {
-			//QRgb p1 = image1->pixel(x, y);
-			//if (p1 == 0xffffffff) continue;
-
-			//QRgb p2 = image2->pixel(x, y);
-			//if (p2 == 0xffffffff) continue;
-
-			int byteOffset = (x >> 3) + offset;
-			uchar mask = DRC::BitTable[x & 7];
-
-			if ((*(bits1 + byteOffset) & mask) != 0) continue;
-			if ((*(bits2 + byteOffset) & mask) != 0) continue;
-
-			image3->setPixel(x, y, clr);
-			//DebugDialog::debug(QString("p1:%1 p2:%2").arg(p1, 0, 16).arg(p2, 0, 16));
-			result = true;
-			if (points.count() < 1000) {
-				points.append(QPointF(x, y));
-			}
+		int maxXs = MaxCollisionPoints - points.count();
+		uchar * display = image3 ? image3->scanLine(y) : nullptr;
+		int count = PixelScan::collisions(image1->constScanLine(y), image2->constScanLine(y), bytesPerLine, x1, x2, display, (uchar) clr, xs, maxXs, false);
+		if (count == 0) continue;
+
+		result = true;
+		for (int i = 0; i < qMin(count, maxXs); i++) {
+			points.append(QPointF(xs[i], y));
 		}
 	}
 
@@ -214,11 +216,16 @@ void DRCResultsDialog::releasedSlot(QListWidgetItem * item) {
 
 const QString DRC::KeepoutSettingName("DRC_Keepout");
 const double DRC::KeepoutDefaultMils = 10;
+const QString DRC::VectorSettingName("DRC_Vector");
+const QString DRC::LiveSettingName("DRC_Live");
 
 ///////////////////////////////////////////////
 
 static QString CancelledMessage;
 
+static constexpr int NetCheckBatch = 4;				// nets per pool thread handed over at a time
+static constexpr int NetCheckPollInterval = 10;		// ms between checks on the pool threads
+
 ///////////////////////////////////////////
 
 DRC::DRC(PCBSketchWidget * sketchWidget, ItemBase * board) :
@@ -233,6 +240,8 @@ DRC::DRC(PCBSketchWidget * sketchWidget, ItemBase * board) :
     m_maxProgress(0)
 {
 	CancelledMessage = tr("DRC was cancelled.");
+	QSettings settings;
+	m_vector = settings.value(VectorSettingName, false).toBool();
 }
 
 DRC::~DRC()
@@ -296,52 +305,44 @@ QStringList DRC::start(bool showOkMessage, double keepoutMils) {
 	return messages;
 }
 
-bool DRC::startAux(QString & message, QStringList & messages, QList<CollidingThing *> & collidingThings, double keepoutMils) {
-	bool bothSidesNow = m_sketchWidget->boardLayers() == 2;
-
-	QList<ConnectorItem *> visited;
-	QList< QList<ConnectorItem *> > equis;
-	QList< QList<ConnectorItem *> > singletons;
-	Q_FOREACH (QGraphicsItem * item, m_sketchWidget->scene()->items()) {
-		auto * connectorItem = dynamic_cast<ConnectorItem *>(item);
-		if (connectorItem == nullptr) continue;
-		if (!connectorItem->attachedTo()->isEverVisible()) continue;
-		if (connectorItem->attachedTo()->getRatsnest()) continue;
-		if (visited.contains(connectorItem)) continue;
-
-		QList<ConnectorItem *> equi;
-		equi.append(connectorItem);
-		ConnectorItem::collectEqualPotential(
-					equi,
-					bothSidesNow,
-					(ViewGeometry::RatsnestFlag |
-					 ViewGeometry::NormalFlag |
-					 ViewGeometry::PCBTraceFlag |
-					 ViewGeometry::SchematicTraceFlag) ^ m_sketchWidget->getTraceFlag());
-		visited.append(equi);
+const DRCStats & DRC::stats() const {
+	return m_stats;
+}
 
-		if (equi.count() == 1) {
-			singletons.append(equi);
-			continue;
+void DRC::recordViolations(const QString & kind, const QStringList & messages, const QList<CollidingThing *> & collidingThings, double dpi) {
+	// everything reported since the last call is of this kind
+	for (int i = m_stats.violations.count(); i < messages.count(); i++) {
+		DRCViolation violation;
+		violation.kind = kind;
+		violation.message = messages.at(i);
+		CollidingThing * collidingThing = collidingThings.at(i);
+		if (!collidingThing->atPixels.isEmpty()) {
+			QPolygonF pixels(collidingThing->atPixels.toVector());
+			QRectF r = pixels.boundingRect();
+			violation.area = QRectF(r.left() / dpi, r.top() / dpi, (r.width() + 1) / dpi, (r.height() + 1) / dpi);
 		}
-
-		ItemBase * firstPart = connectorItem->attachedTo()->layerKinChief();
-		bool gotTwo = false;
-		Q_FOREACH (ConnectorItem * equ, equi) {
-			if (equ->attachedTo()->layerKinChief() != firstPart) {
-				gotTwo = true;
-				break;
-			}
+		if (collidingThing->nonConnectorItem != nullptr && collidingThing->nonConnectorItem->attachedTo() != nullptr) {
+			ItemBase * itemBase = collidingThing->nonConnectorItem->attachedTo()->layerKinChief();
+			violation.itemID = itemBase->id();
+			violation.title = itemBase->title();
+			violation.instanceTitle = itemBase->instanceTitle();
 		}
-		if (!gotTwo) {
-			singletons.append(equi);
-			continue;
-		}
-
-		equis.append(equi);
+		m_stats.violations << violation;
 	}
+}
+
+bool DRC::startAux(QString & message, QStringList & messages, QList<CollidingThing *> & collidingThings, double keepoutMils) {
+	bool bothSidesNow = m_sketchWidget->boardLayers() == 2;
 
-	m_maxProgress = equis.count() + singletons.count() + 1;
+	m_stats = DRCStats();
+	QElapsedTimer phaseTimer;
+	phaseTimer.start();
+
+	QList< QList<ConnectorItem *> > equis;
+	collectNets(m_sketchWidget, equis);
+	m_stats.netsMs = phaseTimer.restart();
+
+	m_maxProgress = equis.count() + 1;
 	if (bothSidesNow) m_maxProgress *= 2;
 	Q_EMIT setMaximumProgress(m_maxProgress);
 	int progress = 1;
@@ -369,6 +370,8 @@ bool DRC::startAux(QString & message, QStringList & messages, QList<CollidingThi
 	m_displayImage->setColor(2, 0xffffff00);
 	m_displayImage->fill(0);
 
+	m_netCheckImages.resize(m_vector ? 0 : qMax(1, QThread::idealThreadCount()));
+
 	if (!makeBoard(m_minusImage, sourceRes)) {
 		message = tr("Fritzing error: unable to render board svg.");
 		return false;
@@ -457,24 +460,8 @@ bool DRC::startAux(QString & message, QStringList & messages, QList<CollidingThi
 
 	}
 
-	// we are checking all the singletons at once
-	// but the DRC will miss it if any of them overlap each other
-
-	while (singletons.count() > 0) {
-		QList<ConnectorItem *> combined;
-		QList<ConnectorItem *> singleton = singletons.takeFirst();
-		ItemBase * chief = singleton.at(0)->attachedTo()->layerKinChief();
-		combined.append(singleton);
-		for (int ix = singletons.count() - 1; ix >= 0; ix--) {
-			QList<ConnectorItem *> candidate = singletons.at(ix);
-			if (candidate.at(0)->attachedTo()->layerKinChief() == chief) {
-				combined.append(candidate);
-				singletons.removeAt(ix);
-			}
-		}
-
-		equis.append(combined);
-	}
+	m_stats.bordersMs = phaseTimer.restart();
+	recordViolations("border", messages, collidingThings, dpi);
 
 	int index = 0;
 	Q_FOREACH (ViewLayer::ViewLayerPlacement viewLayerPlacement, layerSpecs) {
@@ -488,6 +475,48 @@ bool DRC::startAux(QString & message, QStringList & messages, QList<CollidingThi
 		viewLayerIDs.removeOne(ViewLayer::GroundPlane0);
 		viewLayerIDs.removeOne(ViewLayer::GroundPlane1);
 
+		if (m_vector) {
+			checkCopperVector(viewLayerPlacement, viewLayerIDs, equis, messages, collidingThings, keepoutMils, dpi);
+			progress += equis.count();
+			Q_EMIT setProgressValue(progress);
+			ProcessEventBlocker::processEvents();
+			if (m_cancelled) {
+				message = CancelledMessage;
+				return false;
+			}
+			continue;
+		}
+
+		// the nets are rendered and checked a batch at a time on the pool threads, then reported in the order they were split
+		QList<NetCheck> netChecks;
+		auto checkBatch = [&]() {
+			checkNets(netChecks, sourceRes, viewLayerPlacement);
+			bool hits = false;
+			Q_FOREACH (const NetCheck & netCheck, netChecks) {
+				for (int i = 0; i < netCheck.connectorItems.count(); i++) {
+					QList<QPointF> atPixels = netCheck.atPixels.at(i);
+					if (atPixels.isEmpty()) continue;
+
+					CollidingThing * collidingThing = findItemsAt(atPixels, m_board, viewLayerIDs, keepoutMils, dpi, false, netCheck.connectorItems.at(i));
+					QStringList names = getNames(collidingThing);
+					QString name0 = names.at(0);
+					QString msg = tr("%1 is overlapping (%2 layer)")
+								  .arg(name0)
+								  .arg(viewLayerPlacement == ViewLayer::NewTop ? ItemBase::TranslatedPropertyNames.value("top") : ItemBase::TranslatedPropertyNames.value("bottom"))
+								  ;
+					messages << msg;
+					collidingThings << collidingThing;
+					Q_EMIT setProgressMessage(msg);
+					hits = true;
+				}
+
+				Q_EMIT setProgressValue(progress++);
+			}
+			netChecks.clear();
+			if (hits) updateDisplay();
+			ProcessEventBlocker::processEvents();
+		};
+
 		Q_FOREACH (QList<ConnectorItem *> equi, equis) {
 			bool inLayer = false;
 			Q_FOREACH (ConnectorItem * equ, equi) {
@@ -502,27 +531,41 @@ bool DRC::startAux(QString & message, QStringList & messages, QList<CollidingThi
 			}
 
 			// we have a net;
-			m_plusImage->fill(0xffffffff);
-			m_minusImage->fill(0xffffffff);
-			splitNet(masterDoc, equi, m_minusImage, m_plusImage, sourceRes, viewLayerPlacement, index++, keepoutMils);
+			NetCheck netCheck;
+			netCheck.index = index++;
+			splitNet(masterDoc, equi, netCheck, keepoutMils);
 
-			QHash<ConnectorItem *, QRectF> rects;
 			QList<Wire *> wires;
 			Q_FOREACH (ConnectorItem * equ, equi) {
-				if (viewLayerIDs.contains(equ->attachedToViewLayerID())) {
-					if (equ->attachedToItemType() == ModelPart::Wire) {
-						Wire * wire = qobject_cast<Wire *>(equ->attachedTo());
-						if (!wires.contains(wire)) {
-							wires.append(wire);
-							// could break diagonal wires into a series of rects
-							rects.insert(equ, wire->sceneBoundingRect());
-						}
-					}
-					else {
-						rects.insert(equ, equ->sceneBoundingRect());
-					}
+				if (!viewLayerIDs.contains(equ->attachedToViewLayerID())) continue;
+
+				QRectF rect;
+				if (equ->attachedToItemType() == ModelPart::Wire) {
+					Wire * wire = qobject_cast<Wire *>(equ->attachedTo());
+					if (wires.contains(wire)) continue;
+
+					wires.append(wire);
+					// could break diagonal wires into a series of rects
+					rect = wire->sceneBoundingRect();
+				}
+				else {
+					rect = equ->sceneBoundingRect();
 				}
+
+				rect = rect.intersected(boardRect);
+				int l = (rect.left() - boardRect.left()) * dpi / GraphicsUtils::SVGDPI;
+				int t = (rect.top() - boardRect.top()) * dpi / GraphicsUtils::SVGDPI;
+				int r = (rect.right() - boardRect.left()) * dpi / GraphicsUtils::SVGDPI;
+				int b = (rect.bottom() - boardRect.top()) * dpi / GraphicsUtils::SVGDPI;
+				//DebugDialog::debug(QString("l:%1 t:%2 r:%3 b:%4").arg(l).arg(t).arg(r).arg(b));
+				QRect pixelRect(l, t, r - l, b - t);
+				netCheck.connectorItems << equ;
+				netCheck.rects << pixelRect;
+				if (!pixelRect.isEmpty()) netCheck.window |= pixelRect;
 			}
+			// the window is a whole number of pixels from the board's corner, so it renders exactly as that part of the board would
+			netCheck.window &= QRect(QPoint(0, 0), imgSize);
+			netChecks << netCheck;
 
 			ProcessEventBlocker::processEvents();
 			if (m_cancelled) {
@@ -530,50 +573,103 @@ bool DRC::startAux(QString & message, QStringList & messages, QList<CollidingThi
 				return false;
 			}
 
-			Q_FOREACH (ConnectorItem * equ, rects.keys()) {
-				QRectF rect = rects.value(equ).intersected(boardRect);
-				double l = (rect.left() - boardRect.left()) * dpi / GraphicsUtils::SVGDPI;
-				double t = (rect.top() - boardRect.top()) * dpi / GraphicsUtils::SVGDPI;
-				double r = (rect.right() - boardRect.left()) * dpi / GraphicsUtils::SVGDPI;
-				double b = (rect.bottom() - boardRect.top()) * dpi / GraphicsUtils::SVGDPI;
-				//DebugDialog::debug(QString("l:%1 t:%2 r:%3 b:%4").arg(l).arg(t).arg(r).arg(b));
-				QList<QPointF> atPixels;
-				if (pixelsCollide(m_plusImage, m_minusImage, m_displayImage, l, t, r, b, 1 /* 0x80ff0000 */, atPixels)) {
-
-#ifndef QT_NO_DEBUG
-					m_plusImage->save(FolderUtils::getTopLevelUserDataStorePath() + QString("/collidePlus%1_%2.png").arg(viewLayerPlacement).arg(index));
-					m_minusImage->save(FolderUtils::getTopLevelUserDataStorePath() + QString("/collideMinus%1_%2.png").arg(viewLayerPlacement).arg(index));
-#endif
-
-					CollidingThing * collidingThing = findItemsAt(atPixels, m_board, viewLayerIDs, keepoutMils, dpi, false, equ);
-					QStringList names = getNames(collidingThing);
-					QString name0 = names.at(0);
-					QString msg = tr("%1 is overlapping (%2 layer)")
-								  .arg(name0)
-								  .arg(viewLayerPlacement == ViewLayer::NewTop ? ItemBase::TranslatedPropertyNames.value("top") : ItemBase::TranslatedPropertyNames.value("bottom"))
-								  ;
-					messages << msg;
-					collidingThings << collidingThing;
-					Q_EMIT setProgressMessage(msg);
-					updateDisplay();
-				}
-			}
-
-			Q_EMIT setProgressValue(progress++);
+			if (netChecks.count() < m_netCheckImages.count() * NetCheckBatch) continue;
 
-			ProcessEventBlocker::processEvents();
+			checkBatch();
 			if (m_cancelled) {
 				message = CancelledMessage;
 				return false;
 			}
 		}
+
+		if (!netChecks.isEmpty()) checkBatch();
+		if (m_cancelled) {
+			message = CancelledMessage;
+			return false;
+		}
 	}
+	m_stats.netChecksMs = phaseTimer.restart();
+	recordViolations("overlap", messages, collidingThings, dpi);
+
 	checkHoles(messages, collidingThings,  dpi);
+	m_stats.holesMs = phaseTimer.restart();
+	recordViolations("hole", messages, collidingThings, dpi);
+
 	checkCopperBoth(messages, collidingThings, dpi);
+	m_stats.copperBothMs = phaseTimer.restart();
+	recordViolations("copperBoth", messages, collidingThings, dpi);
 
 	return true;
 }
 
+void DRC::collectNets(PCBSketchWidget * sketchWidget, QList< QList<ConnectorItem *> > & equis) {
+	// the nets to check: every set of connectors at equal potential spanning two parts or more,
+	// then, per part, its remaining connectors all together
+	bool bothSidesNow = sketchWidget->boardLayers() == 2;
+
+	QSet<ConnectorItem *> visited;
+	QList< QList<ConnectorItem *> > singletons;
+	Q_FOREACH (QGraphicsItem * item, sketchWidget->scene()->items()) {
+		auto * connectorItem = dynamic_cast<ConnectorItem *>(item);
+		if (connectorItem == nullptr) continue;
+		if (!connectorItem->attachedTo()->isEverVisible()) continue;
+		if (connectorItem->attachedTo()->getRatsnest()) continue;
+		if (visited.contains(connectorItem)) continue;
+
+		QList<ConnectorItem *> equi;
+		equi.append(connectorItem);
+		ConnectorItem::collectEqualPotential(
+					equi,
+					bothSidesNow,
+					(ViewGeometry::RatsnestFlag |
+					 ViewGeometry::NormalFlag |
+					 ViewGeometry::PCBTraceFlag |
+					 ViewGeometry::SchematicTraceFlag) ^ sketchWidget->getTraceFlag());
+		Q_FOREACH (ConnectorItem * equ, equi) {
+			visited.insert(equ);
+		}
+
+		if (equi.count() == 1) {
+			singletons.append(equi);
+			continue;
+		}
+
+		ItemBase * firstPart = connectorItem->attachedTo()->layerKinChief();
+		bool gotTwo = false;
+		Q_FOREACH (ConnectorItem * equ, equi) {
+			if (equ->attachedTo()->layerKinChief() != firstPart) {
+				gotTwo = true;
+				break;
+			}
+		}
+		if (!gotTwo) {
+			singletons.append(equi);
+			continue;
+		}
+
+		equis.append(equi);
+	}
+
+	// we are checking all the singletons at once
+	// but the DRC will miss it if any of them overlap each other
+
+	while (singletons.count() > 0) {
+		QList<ConnectorItem *> combined;
+		QList<ConnectorItem *> singleton = singletons.takeFirst();
+		ItemBase * chief = singleton.at(0)->attachedTo()->layerKinChief();
+		combined.append(singleton);
+		for (int ix = singletons.count() - 1; ix >= 0; ix--) {
+			QList<ConnectorItem *> candidate = singletons.at(ix);
+			if (candidate.at(0)->attachedTo()->layerKinChief() == chief) {
+				combined.append(candidate);
+				singletons.removeAt(ix);
+			}
+		}
+
+		equis.append(combined);
+	}
+}
+
 bool DRC::makeBoard(QImage * image, QRectF & sourceRes) {
 	LayerList viewLayerIDs;
 	viewLayerIDs << ViewLayer::Board;
@@ -612,7 +708,7 @@ bool DRC::makeBoard(QImage * image, QRectF & sourceRes) {
 	return true;
 }
 
-void DRC::splitNet(QDomDocument * masterDoc, QList<ConnectorItem *> & equi, QImage * minusImage, QImage * plusImage, QRectF & sourceRes, ViewLayer::ViewLayerPlacement viewLayerPlacement, int index, double keepoutMils) {
+void DRC::splitNet(QDomDocument * masterDoc, QList<ConnectorItem *> & equi, NetCheck & netCheck, double keepoutMils) {
 	// deal with connectors on the same part, even though they are not on the same net
 	// in other words, make sure there are no overlaps of connectors on the same part
 	QList<QDomElement> net;
@@ -629,20 +725,13 @@ void DRC::splitNet(QDomDocument * masterDoc, QList<ConnectorItem *> & equi, QIma
 		SvgFileSplitter::forceStrokeWidth(element, -2 * keepoutMils, "#000000", false, false);
 	}
 
-	ItemBase::renderOne(masterDoc, plusImage, sourceRes);
+	netCheck.plusSvg = masterDoc->toByteArray();
 
 	Q_FOREACH (QDomElement element, net) {
 		// restore to keepout size
 		SvgFileSplitter::forceStrokeWidth(element, 2 * keepoutMils, "#000000", false, false);
 	}
 
-#ifndef QT_NO_DEBUG
-	plusImage->save(FolderUtils::getTopLevelUserDataStorePath() + QString("/splitNetPlus%1_%2.png").arg(viewLayerPlacement).arg(index));
-#else
-	Q_UNUSED(viewLayerPlacement);
-	Q_UNUSED(index);
-#endif
-
 	// now want notnet
 	Q_FOREACH (QDomElement element, net) {
 		element.removeAttribute("net");
@@ -657,10 +746,7 @@ void DRC::splitNet(QDomDocument * masterDoc, QList<ConnectorItem *> & equi, QIma
 		element.removeAttribute("net");
 	}
 
-	ItemBase::renderOne(masterDoc, minusImage, sourceRes);
-#ifndef QT_NO_DEBUG
-	minusImage->save(FolderUtils::getTopLevelUserDataStorePath() + QString("/splitNetMinus%1_%2.png").arg(viewLayerPlacement).arg(index));
-#endif
+	netCheck.minusSvg = masterDoc->toByteArray();
 
 	// master doc restored to original state
 	Q_FOREACH (QDomElement element, net) {
@@ -669,19 +755,113 @@ void DRC::splitNet(QDomDocument * masterDoc, QList<ConnectorItem *> & equi, QIma
 
 }
 
+static QImage scratchImage(QImage & pool, const QSize & size, QImage::Format format = QImage::Format_Mono) {
+	// a window-sized image over the pool's memory, which only grows, so after the first few nets nothing is allocated
+	if (pool.width() < size.width() || pool.height() < size.height()) {
+		pool = QImage(size.expandedTo(pool.size()), format);
+	}
+	QImage image(pool.bits(), size.width(), size.height(), pool.bytesPerLine(), format);
+	image.setColorTable(pool.colorTable());
+	return image;
+}
+
+static void checkNet(NetCheck & netCheck, NetCheckImages & images, const QRectF & sourceRes, ViewLayer::ViewLayerPlacement viewLayerPlacement) {
+	// runs on a pool thread: touches nothing but the svg text and this thread's images.
+	// Only the window around the net's rects is rendered, so a small net costs little however big the board is
+	if (netCheck.window.isEmpty()) {
+		for (int i = 0; i < netCheck.rects.count(); i++) netCheck.atPixels << QList<QPointF>();
+		return;
+	}
+
+	QImage plusImage = scratchImage(images.plusImage, netCheck.window.size());
+	QImage minusImage = scratchImage(images.minusImage, netCheck.window.size());
+	QImage marksImage = scratchImage(images.marksImage, netCheck.window.size(), QImage::Format_Indexed8);
+	plusImage.fill(0xffffffff);
+	minusImage.fill(0xffffffff);
+	marksImage.fill(0);
+	QRectF renderRect = sourceRes.translated(-netCheck.window.topLeft());
+	ItemBase::renderOne(netCheck.plusSvg, &plusImage, renderRect);
+	ItemBase::renderOne(netCheck.minusSvg, &minusImage, renderRect);
+
+#ifndef QT_NO_DEBUG
+	plusImage.save(FolderUtils::getTopLevelUserDataStorePath() + QString("/splitNetPlus%1_%2.png").arg(viewLayerPlacement).arg(netCheck.index));
+	minusImage.save(FolderUtils::getTopLevelUserDataStorePath() + QString("/splitNetMinus%1_%2.png").arg(viewLayerPlacement).arg(netCheck.index));
+#else
+	Q_UNUSED(viewLayerPlacement);
+#endif
+
+	bool hits = false;
+	Q_FOREACH (QRect rect, netCheck.rects) {
+		QList<QPointF> atPixels;
+		rect.translate(-netCheck.window.topLeft());
+		if (pixelsCollide(&plusImage, &minusImage, &marksImage, rect.left(), rect.top(), rect.left() + rect.width(), rect.top() + rect.height(), 1 /* 0x80ff0000 */, atPixels)) {
+			hits = true;
+		}
+		for (auto & p : atPixels) p += netCheck.window.topLeft();
+		netCheck.atPixels << atPixels;
+	}
+
+	// checkNets() copies the marks onto the board's display image
+	if (hits) netCheck.marks = marksImage.copy();
+}
+
+void DRC::checkNets(QList<NetCheck> & netChecks, const QRectF & sourceRes, ViewLayer::ViewLayerPlacement viewLayerPlacement) {
+	// net i goes to pool thread i % threads, so each set of images has one user at a time;
+	// the results stay in netChecks order, whichever thread finishes first
+	QList<NetCheck *> toCheck;
+	for (auto & netCheck : netChecks) {
+		toCheck << &netCheck;
+	}
+
+	QList< QFuture<void> > futures;
+	int threads = qMin(m_netCheckImages.count(), toCheck.count());
+	for (int t = 0; t < threads; t++) {
+		NetCheckImages * images = &m_netCheckImages[t];
+		futures << QtConcurrent::run([toCheck, images, t, threads, sourceRes, viewLayerPlacement]() {
+			for (int i = t; i < toCheck.count(); i += threads) {
+				checkNet(*toCheck.at(i), *images, sourceRes, viewLayerPlacement);
+			}
+		});
+	}
+
+	bool running = true;
+	while (running) {
+		QThread::msleep(NetCheckPollInterval);
+		ProcessEventBlocker::processEvents();
+		running = false;
+		Q_FOREACH (QFuture<void> future, futures) {
+			if (!future.isFinished()) running = true;
+		}
+	}
+
+	for (auto & netCheck : netChecks) {
+		if (netCheck.marks.isNull()) continue;
+
+		for (int y = 0; y < netCheck.marks.height(); y++) {
+			const uchar * from = netCheck.marks.constScanLine(y);
+			uchar * to = m_displayImage->scanLine(y + netCheck.window.top()) + netCheck.window.left();
+			for (int x = 0; x < netCheck.marks.width(); x++) {
+				if (from[x] != 0) to[x] = from[x];
+			}
+		}
+		netCheck.marks = QImage();
+	}
+}
+
 void DRC::splitNetPrep(QDomDocument * masterDoc, QList<ConnectorItem *> & equi, const Markers & markers, QList<QDomElement> & net, QList<QDomElement> & alsoNet, QList<QDomElement> & notNet, bool checkIntersection)
 {
-	QMultiHash<QString, QString> partSvgIDs;
-	QMultiHash<QString, QString> partTerminalIDs;
-	QHash<QString, QString> bothIDs;
-	QMultiHash<QString, ItemBase *> itemBases;
-	QSet<QString> wireIDs;
+	splitNetPrep(masterDoc, netIDs(equi), markers, net, alsoNet, notNet, checkIntersection);
+}
+
+NetIDs DRC::netIDs(const QList<ConnectorItem *> & equi)
+{
+	NetIDs ids;
 	Q_FOREACH (ConnectorItem * equ, equi) {
 		ItemBase * itemBase = equ->attachedTo();
 		if (itemBase == nullptr) continue;
 
 		if (itemBase->itemType() == ModelPart::Wire) {
-			wireIDs.insert(QString::number(itemBase->id()));
+			ids.wireIDs.insert(QString::number(itemBase->id()));
 		}
 
 		if (equ->connector() == nullptr) {
@@ -693,14 +873,29 @@ void DRC::splitNetPrep(QDomDocument * masterDoc, QList<ConnectorItem *> & equi,
 
 		QString sid = QString::number(itemBase->id());
 		SvgIdLayer * svgIdLayer = equ->connector()->fullPinInfo(itemBase->viewID(), itemBase->viewLayerID());
-		partSvgIDs.insert(sid, svgIdLayer->m_svgId);
+		ids.svgIDs.insert(sid, svgIdLayer->m_svgId);
 		if (!svgIdLayer->m_terminalId.isEmpty()) {
-			partTerminalIDs.insert(sid, svgIdLayer->m_terminalId);
-			bothIDs.insert(sid + svgIdLayer->m_svgId, svgIdLayer->m_terminalId);
+			ids.terminalIDs.insert(sid, svgIdLayer->m_terminalId);
+			ids.bothIDs.insert(sid + svgIdLayer->m_svgId, svgIdLayer->m_terminalId);
+		}
+		if (ids.partSvgIDs.contains(sid)) continue;
+
+		QStringList & partSvgIDs = ids.partSvgIDs[sid];
+		QStringList & partTerminalIDs = ids.partTerminalIDs[sid];
+		Q_FOREACH (ConnectorItem * connectorItem, itemBase->cachedConnectorItems()) {
+			SvgIdLayer * pin = connectorItem->connector()->fullPinInfo(itemBase->viewID(), itemBase->viewLayerID());
+			partSvgIDs.append(pin->m_svgId);
+			if (!pin->m_terminalId.isEmpty()) {
+				partTerminalIDs.append(pin->m_terminalId);
+			}
 		}
-		itemBases.insert(sid, itemBase);
 	}
 
+	return ids;
+}
+
+void DRC::splitNetPrep(QDomDocument * masterDoc, const NetIDs & ids, const Markers & markers, QList<QDomElement> & net, QList<QDomElement> & alsoNet, QList<QDomElement> & notNet, bool checkIntersection)
+{
 	QList<QDomElement> todo;
 	todo << masterDoc->documentElement();
 	bool firstTime = true;
@@ -723,16 +918,16 @@ void DRC::splitNetPrep(QDomDocument * masterDoc, QList<ConnectorItem *> & equi,
 
 		QString partID = element.attribute("partID");
 		if (!partID.isEmpty()) {
-			QStringList svgIDs = partSvgIDs.values(partID);
-			QStringList terminalIDs = partTerminalIDs.values(partID);
+			QStringList svgIDs = ids.svgIDs.values(partID);
+			QStringList terminalIDs = ids.terminalIDs.values(partID);
 			if (svgIDs.count() == 0) {
 				markSubs(element, NotNet);
 			}
-			else if (wireIDs.contains(partID)) {
+			else if (ids.wireIDs.contains(partID)) {
 				markSubs(element, Net);
 			}
 			else {
-				splitSubs(masterDoc, element, partID, markers, svgIDs, terminalIDs, itemBases.values(partID), bothIDs, checkIntersection);
+				splitSubs(masterDoc, element, partID, markers, svgIDs, terminalIDs, ids.partSvgIDs.value(partID), ids.partTerminalIDs.value(partID), ids.bothIDs, checkIntersection);
 			}
 		}
 
@@ -769,7 +964,7 @@ void DRC::markSubs(QDomElement & root, const QString & mark) {
 	}
 }
 
-void DRC::splitSubs(QDomDocument * doc, QDomElement & root, const QString & partID, const Markers & markers, const QStringList & svgIDs, const QStringList & terminalIDs, const QList<ItemBase *> & itemBases, QHash<QString, QString> & bothIDs, bool checkIntersection)
+void DRC::splitSubs(QDomDocument * doc, QDomElement & root, const QString & partID, const Markers & markers, const QStringList & svgIDs, const QStringList & terminalIDs, const QStringList & partSvgIDs, const QStringList & partTerminalIDs, const QHash<QString, QString> & bothIDs, bool checkIntersection)
 {
 	//QString string;
 	//QTextStream stream(&string);
@@ -777,17 +972,15 @@ void DRC::splitSubs(QDomDocument * doc, QDomElement & root, const QString & part
 
 	QStringList notSvgIDs;
 	QStringList notTerminalIDs;
-	if (checkIntersection && itemBases.count() > 0) {
-		ItemBase * itemBase = itemBases.at(0);
-		Q_FOREACH (ConnectorItem * connectorItem, itemBase->cachedConnectorItems()) {
-			SvgIdLayer * svgIdLayer = connectorItem->connector()->fullPinInfo(itemBase->viewID(), itemBase->viewLayerID());
-			if (!svgIDs.contains(svgIdLayer->m_svgId)) {
-				notSvgIDs.append(svgIdLayer->m_svgId);
+	if (checkIntersection) {
+		Q_FOREACH (QString svgID, partSvgIDs) {
+			if (!svgIDs.contains(svgID)) {
+				notSvgIDs.append(svgID);
 			}
-			if (!svgIdLayer->m_terminalId.isEmpty()) {
-				if (!terminalIDs.contains(svgIdLayer->m_terminalId)) {
-					notTerminalIDs.append(svgIdLayer->m_terminalId);
-				}
+		}
+		Q_FOREACH (QString terminalID, partTerminalIDs) {
+			if (!terminalIDs.contains(terminalID)) {
+				notTerminalIDs.append(terminalID);
 			}
 		}
 	}
@@ -912,6 +1105,125 @@ void DRC::splitSubs(QDomDocument * doc, QDomElement & root, const QString & part
 	}
 }
 
+QList<CopperPiece> DRC::collectCopper(PCBSketchWidget * sketchWidget, const QRectF & area, const LayerList & viewLayerIDs, const QHash<ConnectorItem *, int> & netOf) {
+	// the copper on some layers straight from the scene shapes: a segment per trace, an outline per connector,
+	// and the whole shape of copper items without connectors (logos and the like).
+	// Non-connector copper inside a part that has connectors is not modeled.
+	QList<CopperPiece> pieces;
+	Q_FOREACH (QGraphicsItem * item, sketchWidget->scene()->items(area)) {
+		auto * itemBase = dynamic_cast<ItemBase *>(item);
+		if (itemBase == nullptr) continue;
+		if (itemBase->hidden() || itemBase->layerHidden() || !itemBase->isEverVisible()) continue;
+		if (itemBase->getRatsnest()) continue;
+		if (!viewLayerIDs.contains(itemBase->viewLayerID())) continue;
+
+		auto * pad = qobject_cast<Pad *>(itemBase);
+		if (pad && pad->copperBlocker()) continue;		// not copper
+
+		CopperPiece piece;
+		piece.itemBase = itemBase;
+		auto * wire = qobject_cast<Wire *>(itemBase);
+		if (wire) {
+			QLineF line = wire->line();
+			piece.trace = true;
+			piece.line = QLineF(wire->mapToScene(line.p1()), wire->mapToScene(line.p2()));
+			piece.width = wire->width();
+			piece.reportAs = wire->connector0();
+			piece.net = netOf.value(piece.reportAs, -1);
+			pieces << piece;
+			continue;
+		}
+
+		if (itemBase->cachedConnectorItems().isEmpty()) {
+			piece.path = itemBase->mapToScene(itemBase->shape());
+			pieces << piece;
+			continue;
+		}
+
+		Q_FOREACH (ConnectorItem * connectorItem, itemBase->cachedConnectorItems()) {
+			piece.path = connectorItem->mapToScene(connectorItem->shape());
+			piece.reportAs = connectorItem;
+			piece.net = netOf.value(connectorItem, -1);
+			pieces << piece;
+		}
+	}
+
+	return pieces;
+}
+
+void DRC::addCopper(CopperClearance & clearance, const CopperPiece & piece, int owner) {
+	if (piece.trace) clearance.addSegment(piece.line, piece.width, owner);
+	else clearance.addPath(piece.path, owner);
+}
+
+void DRC::checkCopperVector(ViewLayer::ViewLayerPlacement viewLayerPlacement, const LayerList & viewLayerIDs, const QList< QList<ConnectorItem *> > & equis, QStringList & messages, QList<CollidingThing *> & collidingThings, double keepoutMils, double dpi) {
+	// the same nets as the image check, but as polygons, so the time depends on how much copper
+	// there is rather than on board area and resolution
+
+	QHash<ConnectorItem *, int> netOf;
+	for (int i = 0; i < equis.count(); i++) {
+		Q_FOREACH (ConnectorItem * connectorItem, equis.at(i)) {
+			netOf.insert(connectorItem, i);
+			ConnectorItem * cross = connectorItem->getCrossLayerConnectorItem();
+			if (cross) netOf.insert(cross, i);
+		}
+	}
+
+	QRectF boardRect = m_board->sceneBoundingRect();
+	QList<CopperPiece> pieces = collectCopper(m_sketchWidget, boardRect, viewLayerIDs, netOf);
+	CopperClearance clearance(keepoutMils * GraphicsUtils::SVGDPI / 1000);
+	Q_FOREACH (const CopperPiece & piece, pieces) {
+		addCopper(clearance, piece, piece.net);
+	}
+
+	// gather each piece's overlaps, then report the pieces in order, as the image check does per connector
+	QMap<int, QList<QPolygonF> > regions;
+	Q_FOREACH (const CopperClearance::Overlap & overlap, clearance.overlaps()) {
+		if (clearance.owner(overlap.first) >= 0) regions[overlap.first].append(overlap.region);
+		if (clearance.owner(overlap.second) >= 0) regions[overlap.second].append(overlap.region);
+	}
+	QTransform toImage = QTransform::fromTranslate(-boardRect.left(), -boardRect.top()) * QTransform::fromScale(dpi / GraphicsUtils::SVGDPI, dpi / GraphicsUtils::SVGDPI);
+	QRect imageRect = m_displayImage->rect();
+	for (auto it = regions.constBegin(); it != regions.constEnd(); ++it) {
+		QPainterPath path;
+		path.setFillRule(Qt::WindingFill);
+		Q_FOREACH (const QPolygonF & polygon, it.value()) {
+			path.addPolygon(toImage.map(polygon));
+		}
+
+		QList<QPointF> atPixels;
+		QRect bounds = path.boundingRect().toAlignedRect() & imageRect;
+		for (int y = bounds.top(); y <= bounds.bottom(); y++) {
+			for (int x = bounds.left(); x <= bounds.right(); x++) {
+				if (!path.contains(QPointF(x + 0.5, y + 0.5))) continue;
+
+				m_displayImage->setPixel(x, y, 1 /* 0x80ff0000 */);
+				if (atPixels.count() < 1000) {
+					atPixels.append(QPointF(x, y));
+				}
+			}
+		}
+		if (atPixels.isEmpty() && !bounds.isEmpty()) {
+			// thinner than a pixel
+			atPixels.append(bounds.center());
+			m_displayImage->setPixel(bounds.center(), 1 /* 0x80ff0000 */);
+		}
+
+		CollidingThing * collidingThing = findItemsAt(atPixels, m_board, viewLayerIDs, keepoutMils, dpi, false, pieces.at(it.key()).reportAs);
+		QStringList names = getNames(collidingThing);
+		QString name0 = names.isEmpty() ? QString() : names.at(0);
+		QString msg = tr("%1 is overlapping (%2 layer)")
+					  .arg(name0)
+					  .arg(viewLayerPlacement == ViewLayer::NewTop ? ItemBase::TranslatedPropertyNames.value("top") : ItemBase::TranslatedPropertyNames.value("bottom"))
+					  ;
+		messages << msg;
+		collidingThings << collidingThing;
+		Q_EMIT setProgressMessage(msg);
+	}
+
+	if (!regions.isEmpty()) updateDisplay();
+}
+
 void DRC::updateDisplay() {
 	QPixmap pixmap = QPixmap::fromImage(*m_displayImage);
 	if (m_displayItem == nullptr) {
@@ -1049,50 +1361,14 @@ void DRC::checkCopperBoth(QStringList & messages, QList<CollidingThing *> & coll
 		QRectF ibr = item->sceneBoundingRect();
 		if (!boardRect.intersects(ibr)) continue;
 
-		QString fzpPath = itemBase->modelPart()->path();
-		QFile file(fzpPath);
-		if (!file.open(QFile::ReadOnly)) {
-			DebugDialog::debug(QString("unable to open %1").arg(fzpPath));
-			continue;
-		}
-
-		QString fzp = file.readAll();
-		file.close();
-
-		bool copper0 = fzp.contains("copper0");
-		bool copper1 = fzp.contains("copper1");
-		if (!copper1 && !copper0) continue;
-
-		QString svgPath = itemBase->fsvgRenderer()->filename();
-		QFile file2(svgPath);
-		if (!file2.open(QFile::ReadOnly)) {
-			DebugDialog::debug(QString("itembase svg file open failure %1").arg(itemBase->id()));
-			continue;
-		}
-
-		QString svg = file2.readAll();
-		file2.close();
-
-		QDomDocument doc;
-		QString errorStr;
-		auto errorLine = 0;
-		auto errorColumn = 0;
-		if (!doc.setContent(svg, &errorStr, &errorLine, &errorColumn)) {
-			DebugDialog::debug(QString("itembase svg xml failure %1 %2 %3 %4").arg(itemBase->id()).arg(errorStr).arg(errorLine).arg(errorColumn));
-			continue;
-		}
+		// the fzp and svg are only read the first time a part is seen
+		PartCopper::Info info;
+		if (!PartCopper::info(itemBase->modelPart(), itemBase->fsvgRenderer()->filename(), info)) continue;
+		if (!info.copper1 && !info.copper0) continue;
 
 		QSet<ConnectorItem *> missing;
-		QDomElement root = doc.documentElement();
-
-		if (copper1) {
-			Q_FOREACH(ConnectorItem * ci, missingCopper("copper1", ViewLayer::Copper1, itemBase, root)) {
-				missing << ci;
-			}
-		}
-
-		if (copper0) {
-			Q_FOREACH (ConnectorItem * ci, missingCopper("copper0", ViewLayer::Copper0, itemBase, root)) {
+		Q_FOREACH (ConnectorItem * ci, itemBase->cachedConnectorItems()) {
+			if (info.missing1.contains(ci->connectorSharedID()) || info.missing0.contains(ci->connectorSharedID())) {
 				missing << ci;
 			}
 		}
@@ -1131,25 +1407,3 @@ void DRC::checkCopperBoth(QStringList & messages, QList<CollidingThing *> & coll
 	}
 
 }
-
-QList<ConnectorItem *> DRC::missingCopper(const QString & layerName, ViewLayer::ViewLayerID viewLayerID, ItemBase * itemBase, const QDomElement & root)
-{
-	QDomElement copperElement = TextUtils::findElementWithAttribute(root, "id", layerName);
-	QList<ConnectorItem *> missing;
-
-	Q_FOREACH (ConnectorItem * connectorItem, itemBase->cachedConnectorItems()) {
-		SvgIdLayer * svgIdLayer = connectorItem->connector()->fullPinInfo(itemBase->viewID(), viewLayerID);
-		if (svgIdLayer == nullptr) {
-			DebugDialog::debug(QString("missing pin info for %1").arg(itemBase->id()));
-			missing << connectorItem;
-			continue;
-		}
-
-		QDomElement element = TextUtils::findElementWithAttribute(copperElement, "id", svgIdLayer->m_svgId);
-		if (element.isNull()) {
-			missing << connectorItem;
-		}
-	}
-
-	return missing;
-}
@@ -22,6 +22,10 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 #define DRC_H
 
 #include <QList>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
 #include <QObject>
 #include <QImage>
 #include <QDomDocument>
@@ -31,15 +35,81 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 #include <QRadioButton>
 #include <QListWidgetItem>
 #include <QPointer>
+#include <QPainterPath>
+#include <QLineF>
 
 #include "../svg/svgfilesplitter.h"
 #include "../viewlayer.h"
 
+class ConnectorItem;
+class ItemBase;
+
 struct CollidingThing {
 	QPointer<class NonConnectorItem> nonConnectorItem;
 	QList<QPointF> atPixels;
 };
 
+// One net on one side, ready to be checked off the main thread: the two renderings splitNet()
+// makes of the master doc, and the areas of the net's connectors in image pixels.
+struct NetCheck {
+	QByteArray plusSvg;							// the net at its normal size
+	QByteArray minusSvg;						// everything else, widened by the keepout
+	QList<ConnectorItem *> connectorItems;
+	QList<QRect> rects;							// one per connector item
+	QList< QList<QPointF> > atPixels;			// filled in by the check, one per connector item
+	QRect window;								// the part of the board the rects are in, all that is rendered
+	QImage marks;								// the window's collision marks, only when there are some
+	int index = 0;
+};
+
+// A pool thread's own images, so nets can be rendered side by side.
+struct NetCheckImages {
+	QImage plusImage;							// scratch for the net's window, grown as needed
+	QImage minusImage;
+	QImage marksImage;
+};
+
+// A piece of copper as the scene has it, for the polygon checks.
+struct CopperPiece {
+	ItemBase * itemBase = nullptr;
+	ConnectorItem * reportAs = nullptr;			// whose name a collision goes under; null for copper on no net
+	int net = -1;								// index into the nets it was collected for
+	bool trace = false;
+	QLineF line;								// a trace, in scene coordinates
+	double width = 0;
+	QPainterPath path;							// anything else, in scene coordinates
+};
+
+// One problem a DRC run found, for reports.
+struct DRCViolation {
+	QString kind;								// "border", "overlap", "hole" or "copperBoth"
+	QString message;
+	QRectF area;								// what was marked, in inches from the board's top left
+	long itemID = -1;							// the part involved, when there is one
+	QString title;
+	QString instanceTitle;
+};
+
+struct DRCStats {
+	qint64 netsMs = 0;
+	qint64 bordersMs = 0;						// rendering each side and checking it against the board's edge
+	qint64 netChecksMs = 0;
+	qint64 holesMs = 0;
+	qint64 copperBothMs = 0;
+	QList<DRCViolation> violations;				// in the order of the messages start() returns
+};
+
+// What splitNetPrep() matches a net's connectors by in the master doc, keyed by part id.  It is read
+// from the scene, so callers off the GUI thread take it there first.
+struct NetIDs {
+	QMultiHash<QString, QString> svgIDs;			// the net's connectors on each part
+	QMultiHash<QString, QString> terminalIDs;
+	QHash<QString, QString> bothIDs;				// part id + svg id -> terminal id
+	QSet<QString> wireIDs;
+	QHash<QString, QStringList> partSvgIDs;			// all the connectors on each part
+	QHash<QString, QStringList> partTerminalIDs;
+};
+
 struct Markers {
 	QString inSvgID;
 	QString inSvgAndID;
@@ -49,8 +119,6 @@ struct Markers {
 };
 
 class PCBSketchWidget;
-class ItemBase;
-class ConnectorItem;
 class DRC : public QObject
 {
 	Q_OBJECT
@@ -60,10 +128,16 @@ public:
 	virtual ~DRC();
 
 	QStringList start(bool showOkMessage, double keepoutMils);
+	const DRCStats & stats() const;
 
 public:
 	static void splitNetPrep(QDomDocument * masterDoc, QList<ConnectorItem *> & equi, const Markers &, QList<QDomElement> & net, QList<QDomElement> & alsoNet, QList<QDomElement> & notNet, bool checkIntersection);
+	static void splitNetPrep(QDomDocument * masterDoc, const NetIDs &, const Markers &, QList<QDomElement> & net, QList<QDomElement> & alsoNet, QList<QDomElement> & notNet, bool checkIntersection);
+	static NetIDs netIDs(const QList<ConnectorItem *> & equi);
 	static void extendBorder(double keepoutImagePixels, QImage * image);
+	static void collectNets(PCBSketchWidget *, QList< QList<ConnectorItem *> > & equis);
+	static QList<CopperPiece> collectCopper(PCBSketchWidget *, const QRectF & area, const LayerList & viewLayerIDs, const QHash<ConnectorItem *, int> & netOf);
+	static void addCopper(class CopperClearance &, const CopperPiece &, int owner);
 
 public Q_SLOTS:
 	void cancel();
@@ -84,20 +158,24 @@ public:
 	static const uchar BitTable[];
 	static const QString KeepoutSettingName;
 	static const double KeepoutDefaultMils;
+	static const QString VectorSettingName;
+	static const QString LiveSettingName;
 
 protected:
 	bool makeBoard(QImage *, QRectF & sourceRes);
-	void splitNet(QDomDocument *, QList<ConnectorItem *> &, QImage * minusImage, QImage * plusImage, QRectF & sourceRes, ViewLayer::ViewLayerPlacement viewLayerPlacement, int index, double keepoutMils);
+	void splitNet(QDomDocument *, QList<ConnectorItem *> &, NetCheck &, double keepoutMils);
+	void checkNets(QList<NetCheck> &, const QRectF & sourceRes, ViewLayer::ViewLayerPlacement);
+	void checkCopperVector(ViewLayer::ViewLayerPlacement, const LayerList & viewLayerIDs, const QList< QList<ConnectorItem *> > & equis, QStringList & messages, QList<CollidingThing *> &, double keepoutMils, double dpi);
 	void updateDisplay();
 	bool startAux(QString & message, QStringList & messages, QList<CollidingThing *> &, double keepoutMils);
 	CollidingThing * findItemsAt(QList<QPointF> &, ItemBase * board, const LayerList & viewLayerIDs, double keepout, double dpi, bool skipHoles, ConnectorItem * already);
 	void checkHoles(QStringList & messages, QList<CollidingThing *> & collidingThings, double dpi);
 	void checkCopperBoth(QStringList & messages, QList<CollidingThing *> & collidingThings, double dpi);
-	QList<ConnectorItem *> missingCopper(const QString & layerName, ViewLayer::ViewLayerID, ItemBase *, const QDomElement & svgRoot);
+	void recordViolations(const QString & kind, const QStringList & messages, const QList<CollidingThing *> &, double dpi);
 
 protected:
 	static void markSubs(QDomElement & root, const QString & mark);
-	static void splitSubs(QDomDocument *, QDomElement & root, const QString & partID, const Markers &, const QStringList & svgIDs,  const QStringList & terminalIDs, const QList<ItemBase *> &, QHash<QString, QString> & both, bool checkIntersection);
+	static void splitSubs(QDomDocument *, QDomElement & root, const QString & partID, const Markers &, const QStringList & svgIDs,  const QStringList & terminalIDs, const QStringList & partSvgIDs, const QStringList & partTerminalIDs, const QHash<QString, QString> & both, bool checkIntersection);
 
 protected:
 	PCBSketchWidget * m_sketchWidget;
@@ -108,8 +186,11 @@ protected:
 	QImage * m_displayImage;
 	QGraphicsPixmapItem * m_displayItem;
 	QHash<ViewLayer::ViewLayerPlacement, QDomDocument *> m_masterDocs;
+	QVector<NetCheckImages> m_netCheckImages;
+	bool m_vector;							// check the nets as polygons instead of images
 	bool m_cancelled;
 	int m_maxProgress;
+	DRCStats m_stats;
 };
 
 class DRCResultsDialog : public QDialog
@@ -0,0 +1,217 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+#include "livedrc.h"
+#include "drc.h"
+#include "../sketch/pcbsketchwidget.h"
+#include "../connectors/connectoritem.h"
+#include "../waitpushundostack.h"
+
+#include <QBrush>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QGraphicsPathItem>
+#include <QGraphicsScene>
+
+#include <algorithm>
+
+static constexpr int RebuildFactor = 4;			// rebuild an index once it holds this many times the live shapes
+
+static QByteArray netKey(const QList<ConnectorItem *> & equi) {
+	QList<quintptr> pointers;
+	Q_FOREACH (ConnectorItem * connectorItem, equi) {
+		pointers << (quintptr) connectorItem;
+	}
+	std::sort(pointers.begin(), pointers.end());
+	return QByteArray((const char *) pointers.constData(), pointers.count() * (int) sizeof(quintptr));
+}
+
+static QByteArray pieceData(const CopperPiece & piece) {
+	QByteArray data;
+	QDataStream stream(&data, QIODevice::WriteOnly);
+	stream << piece.trace;
+	if (piece.trace) stream << piece.line << piece.width;
+	else stream << piece.path;
+	return data;
+}
+
+////////////////////////////////////////////////////////////////////
+
+LiveDRC::LiveDRC(PCBSketchWidget * sketchWidget) : QObject(sketchWidget),
+	m_sketchWidget(sketchWidget)
+{
+	m_timer.setSingleShot(true);
+	m_timer.setInterval(Delay);
+	connect(&m_timer, SIGNAL(timeout()), this, SLOT(check()));
+
+	connect(sketchWidget->undoStack(), SIGNAL(indexChanged(int)), this, SLOT(changed()));
+	connect(sketchWidget, SIGNAL(routingStatusSignal(SketchWidget *, const RoutingStatus &)), this, SLOT(changed()));
+	changed();
+}
+
+LiveDRC::~LiveDRC()
+{
+	// when the view is going away, so is its scene and the overlay with it
+	if (m_sketchWidget && m_overlay) delete m_overlay;
+}
+
+void LiveDRC::changed() {
+	m_timer.start();
+}
+
+void LiveDRC::reset() {
+	m_board = nullptr;
+	m_netIds.clear();
+	m_top = Side();
+	m_bottom = Side();
+}
+
+void LiveDRC::check() {
+	if (m_sketchWidget.isNull()) return;
+
+	// like the DRC, only a sketch with one board can be checked
+	QList<ItemBase *> boards = m_sketchWidget->findBoard();
+	if (boards.count() != 1) {
+		reset();
+		updateOverlay();
+		return;
+	}
+
+	double keepout = m_sketchWidget->getKeepout();
+	if (boards.first() != m_board || keepout != m_keepout) {
+		reset();
+		m_board = boards.first();
+		m_keepout = keepout;
+	}
+
+	QList< QList<ConnectorItem *> > equis;
+	DRC::collectNets(m_sketchWidget, equis);
+
+	// a net keeps its id as long as it has the same connectors; otherwise it is a new net and the old one is gone
+	QHash<QByteArray, int> netIds;
+	QHash<ConnectorItem *, int> netOf;
+	Q_FOREACH (const QList<ConnectorItem *> & equi, equis) {
+		QByteArray key = netKey(equi);
+		int id = m_netIds.value(key, -1);
+		if (id < 0) id = m_nextNetId++;
+		netIds.insert(key, id);
+		Q_FOREACH (ConnectorItem * connectorItem, equi) {
+			netOf.insert(connectorItem, id);
+			ConnectorItem * cross = connectorItem->getCrossLayerConnectorItem();
+			if (cross) netOf.insert(cross, id);
+		}
+	}
+	m_netIds = netIds;
+
+	QRectF boardRect = m_board->sceneBoundingRect();
+	checkSide(m_bottom, ViewLayer::NewBottom, boardRect, netOf);
+	if (m_sketchWidget->boardLayers() == 2) checkSide(m_top, ViewLayer::NewTop, boardRect, netOf);
+	else m_top = Side();
+
+	updateOverlay();
+}
+
+void LiveDRC::checkSide(Side & side, ViewLayer::ViewLayerPlacement viewLayerPlacement, const QRectF & boardRect, const QHash<ConnectorItem *, int> & netOf) {
+	LayerList viewLayerIDs = ViewLayer::copperLayers(viewLayerPlacement);
+	viewLayerIDs.removeOne(ViewLayer::GroundPlane0);
+	viewLayerIDs.removeOne(ViewLayer::GroundPlane1);
+
+	QList<CopperPiece> pieces = DRC::collectCopper(m_sketchWidget, boardRect, viewLayerIDs, netOf);
+
+	// removed shapes keep their slots, so after a long session start the index over
+	if (side.clearance && side.clearance->count() > RebuildFactor * (pieces.count() + 16)) {
+		side = Side();
+	}
+	if (!side.clearance) {
+		side.clearance.reset(new CopperClearance(m_keepout));
+	}
+
+	// copper on no net is fingerprinted together under -1, like a net of its own
+	QHash<int, QList<int> > netPieces;
+	QHash<int, QList<QByteArray> > netData;
+	for (int i = 0; i < pieces.count(); i++) {
+		const CopperPiece & piece = pieces.at(i);
+		netPieces[piece.net].append(i);
+		netData[piece.net].append(pieceData(piece));
+	}
+
+	QHash<int, QByteArray> fingerprints;
+	QSet<int> dirty;
+	for (auto it = netData.begin(); it != netData.end(); ++it) {
+		std::sort(it.value().begin(), it.value().end());		// the scene's order is the stacking order, which is not a change
+		QCryptographicHash hash(QCryptographicHash::Md5);
+		Q_FOREACH (const QByteArray & data, it.value()) {
+			hash.addData(data);
+		}
+		QByteArray fingerprint = hash.result();
+		fingerprints.insert(it.key(), fingerprint);
+		if (side.fingerprints.value(it.key()) != fingerprint) dirty.insert(it.key());
+	}
+	for (auto it = side.fingerprints.constBegin(); it != side.fingerprints.constEnd(); ++it) {
+		if (!fingerprints.contains(it.key())) dirty.insert(it.key());
+	}
+	side.fingerprints = fingerprints;
+	if (dirty.isEmpty()) return;
+
+	CopperClearance & clearance = *side.clearance;
+	Q_FOREACH (int net, dirty) {
+		clearance.removeOwner(net);
+		Q_FOREACH (int i, netPieces.value(net)) {
+			DRC::addCopper(clearance, pieces.at(i), net);
+		}
+	}
+
+	// the overlaps between untouched nets still stand; the rest are found again
+	QList<CopperClearance::Overlap> overlaps;
+	Q_FOREACH (const CopperClearance::Overlap & overlap, side.overlaps) {
+		if (dirty.contains(clearance.owner(overlap.first))) continue;
+		if (dirty.contains(clearance.owner(overlap.second))) continue;
+		overlaps << overlap;
+	}
+	overlaps.append(clearance.overlaps(dirty));
+	side.overlaps = overlaps;
+}
+
+void LiveDRC::updateOverlay() {
+	QPainterPath path;
+	path.setFillRule(Qt::WindingFill);
+	Q_FOREACH (const Side * side, QList<const Side *>() << &m_bottom << &m_top) {
+		Q_FOREACH (const CopperClearance::Overlap & overlap, side->overlaps) {
+			Q_FOREACH (const QPolygonF & polygon, overlap.region) {
+				path.addPolygon(polygon);
+			}
+		}
+	}
+
+	if (m_overlay == nullptr) {
+		if (path.isEmpty()) return;
+
+		m_overlay = new QGraphicsPathItem;
+		m_overlay->setPen(Qt::NoPen);
+		m_overlay->setBrush(QColor(255, 0, 0, 128));
+		m_overlay->setFlags(QFlags<QGraphicsItem::GraphicsItemFlag>());
+		m_overlay->setAcceptedMouseButtons(Qt::NoButton);
+		m_overlay->setZValue(5000);
+		m_sketchWidget->scene()->addItem(m_overlay);
+	}
+
+	m_overlay->setPath(path);
+	m_overlay->setVisible(!path.isEmpty());
+}
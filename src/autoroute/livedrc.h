@@ -0,0 +1,85 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+#ifndef LIVEDRC_H
+#define LIVEDRC_H
+
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QHash>
+#include <QSet>
+#include <QByteArray>
+
+#include <memory>
+
+#include "../viewlayer.h"
+#include "copperclearance.h"
+
+class PCBSketchWidget;
+class ItemBase;
+class ConnectorItem;
+class QGraphicsPathItem;
+
+// A clearance check that keeps running while the pcb view is edited, using the polygon DRC.
+// Shortly after each change the copper of every net is fingerprinted; only the nets whose
+// copper changed are taken out of the clearance index, put back and checked against their
+// neighbours, and the overlaps found earlier for the other nets are kept.  The overlaps are
+// shown as a red overlay above the board until they are fixed.
+
+class LiveDRC : public QObject
+{
+	Q_OBJECT
+
+public:
+	static constexpr int Delay = 50;				// ms after the last change, so a burst of changes is checked once
+
+public:
+	LiveDRC(PCBSketchWidget *);
+	~LiveDRC();
+
+public Q_SLOTS:
+	void changed();
+	void check();
+
+protected:
+	struct Side {
+		std::unique_ptr<CopperClearance> clearance;
+		QHash<int, QByteArray> fingerprints;		// net id -> its copper when last checked
+		QList<CopperClearance::Overlap> overlaps;
+	};
+
+	void checkSide(Side &, ViewLayer::ViewLayerPlacement, const QRectF & boardRect, const QHash<ConnectorItem *, int> & netOf);
+	void updateOverlay();
+	void reset();
+
+protected:
+	QPointer<PCBSketchWidget> m_sketchWidget;
+	QTimer m_timer;
+	QGraphicsPathItem * m_overlay = nullptr;
+	ItemBase * m_board = nullptr;
+	double m_keepout = 0;
+	QHash<QByteArray, int> m_netIds;				// sorted connector pointers -> net id, so a net keeps its id between checks
+	int m_nextNetId = 0;
+	Side m_top;
+	Side m_bottom;
+};
+
+#endif
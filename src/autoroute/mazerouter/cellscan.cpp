@@ -0,0 +1,121 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+
+#include "cellscan.h"
+
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+struct WordChunk {
+	static constexpr int Bytes = 8;
+
+	static bool white(const uchar * p, int bytesPerLine) {
+		quint64 r0, r1, r2, r3;
+		memcpy(&r0, p, Bytes);
+		memcpy(&r1, p + bytesPerLine, Bytes);
+		memcpy(&r2, p + (2 * bytesPerLine), Bytes);
+		memcpy(&r3, p + (3 * bytesPerLine), Bytes);
+		return (r0 & r1 & r2 & r3) == ~Q_UINT64_C(0);
+	}
+};
+
+#if defined(__AVX2__)
+struct VectorChunk {
+	static constexpr int Bytes = 32;
+
+	static bool white(const uchar * p, int bytesPerLine) {
+		__m256i anded = _mm256_and_si256(
+		                    _mm256_and_si256(_mm256_loadu_si256((const __m256i *) p), _mm256_loadu_si256((const __m256i *) (p + bytesPerLine))),
+		                    _mm256_and_si256(_mm256_loadu_si256((const __m256i *) (p + (2 * bytesPerLine))), _mm256_loadu_si256((const __m256i *) (p + (3 * bytesPerLine)))));
+		return _mm256_movemask_epi8(_mm256_cmpeq_epi8(anded, _mm256_set1_epi8(-1))) == -1;
+	}
+};
+#elif defined(__SSE2__)
+struct VectorChunk {
+	static constexpr int Bytes = 16;
+
+	static bool white(const uchar * p, int bytesPerLine) {
+		__m128i anded = _mm_and_si128(
+		                    _mm_and_si128(_mm_loadu_si128((const __m128i *) p), _mm_loadu_si128((const __m128i *) (p + bytesPerLine))),
+		                    _mm_and_si128(_mm_loadu_si128((const __m128i *) (p + (2 * bytesPerLine))), _mm_loadu_si128((const __m128i *) (p + (3 * bytesPerLine)))));
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(anded, _mm_set1_epi8(-1))) == 0xffff;
+	}
+};
+#else
+typedef WordChunk VectorChunk;
+#endif
+
+static inline uchar andedByte(const uchar * p, int bytesPerLine) {
+	return p[0] & p[bytesPerLine] & p[2 * bytesPerLine] & p[3 * bytesPerLine];
+}
+
+static inline int markCell(const uchar * scanLine, int bytesPerLine, int ix, int * cells, int count) {
+	// the high nibble of a byte is the even cell
+	uchar mask = ix & 1 ? 0x0f : 0xf0;
+	if ((andedByte(scanLine + (ix >> 1), bytesPerLine) & mask) != mask) {
+		cells[count++] = ix;
+	}
+	return count;
+}
+
+template <typename Chunk>
+static int scan(const uchar * scanLine, int bytesPerLine, int sx, int width, int * cells) {
+	int count = 0;
+	int ix = sx;
+	int end = sx + width;
+	if ((ix & 1) && ix < end) {
+		count = markCell(scanLine, bytesPerLine, ix++, cells, count);
+	}
+
+	// whole bytes from here on, Chunk::Bytes of them (two cells each) at a time
+	const int chunkCells = Chunk::Bytes * 2;
+	for (; ix + chunkCells <= end; ix += chunkCells) {
+		const uchar * p = scanLine + (ix >> 1);
+		if (Chunk::white(p, bytesPerLine)) continue;
+
+		for (int b = 0; b < Chunk::Bytes; b++) {
+			uchar anded = andedByte(p + b, bytesPerLine);
+			if (anded == 0xff) continue;
+
+			if ((anded & 0xf0) != 0xf0) cells[count++] = ix + (2 * b);
+			if ((anded & 0x0f) != 0x0f) cells[count++] = ix + (2 * b) + 1;
+		}
+	}
+
+	for (; ix < end; ix++) {
+		count = markCell(scanLine, bytesPerLine, ix, cells, count);
+	}
+
+	return count;
+}
+
+int CellScan::blackCells(const uchar * scanLine, int bytesPerLine, int sx, int width, int * cells) {
+	return scan<VectorChunk>(scanLine, bytesPerLine, sx, width, cells);
+}
+
+int CellScan::blackCellsWords(const uchar * scanLine, int bytesPerLine, int sx, int width, int * cells) {
+	return scan<WordChunk>(scanLine, bytesPerLine, sx, width, cells);
+}
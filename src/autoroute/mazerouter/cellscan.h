@@ -0,0 +1,44 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+
+#ifndef CELLSCAN_H
+#define CELLSCAN_H
+
+#include <QtGlobal>
+
+// Downsampling for Grid::init4().  The router renders into Format_Mono images oversampled 4x,
+// so a grid cell is a 4 x 4 block of bits, all white (1) when the cell is open.
+// blackCells() lists the cells of one row that have any black bit.  It ANDs the row's four
+// scanlines a vector (AVX2 or SSE2, whichever the build targets) or a 64-bit word at a time,
+// and only looks at single cells inside chunks that are not all white.
+
+class CellScan
+{
+public:
+	// scanLine is the first of the row's four scanlines; writes the x of each black cell
+	// in [sx, sx + width) to cells, in increasing order, and returns how many there are
+	static int blackCells(const uchar * scanLine, int bytesPerLine, int sx, int width, int * cells);
+
+	// the same with 64-bit words only, what blackCells() does on builds without SSE2
+	static int blackCellsWords(const uchar * scanLine, int bytesPerLine, int sx, int width, int * cells);
+};
+
+#endif
@@ -0,0 +1,112 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+#include "displaytiles.h"
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+static int tileColumns(const QSize & size) {
+	return (size.width() + DisplayTiles::DisplayTileSize - 1) / DisplayTiles::DisplayTileSize;
+}
+
+static QRect tileRect(int index, int columns) {
+	return QRect((index % columns) * DisplayTiles::DisplayTileSize, (index / columns) * DisplayTiles::DisplayTileSize, DisplayTiles::DisplayTileSize, DisplayTiles::DisplayTileSize);
+}
+
+////////////////////////////////////////////////////////////////////
+
+DisplayTiles::DisplayTiles(const QSize & size) : m_size(size)
+{
+	m_columns = tileColumns(size);
+}
+
+void DisplayTiles::fill() {
+	m_tiles.clear();
+	m_changed.clear();
+	m_reset = true;
+}
+
+void DisplayTiles::setPixel(int x, int y, uint color) {
+	if (x < 0 || y < 0 || x >= m_size.width() || y >= m_size.height()) return;
+
+	int index = ((y / DisplayTileSize) * m_columns) + (x / DisplayTileSize);
+	QImage & image = m_tiles[index];
+	if (image.isNull()) {
+		image = QImage(DisplayTileSize, DisplayTileSize, QImage::Format_ARGB32);
+		image.fill(0);
+	}
+	image.setPixel(x % DisplayTileSize, y % DisplayTileSize, color);
+	m_changed.insert(index);
+}
+
+DisplayTileImages DisplayTiles::takeChanged(bool & reset) {
+	// the images are implicitly shared, so whoever draws next here detaches its own copy
+	DisplayTileImages changed;
+	Q_FOREACH (int index, m_changed) {
+		changed.insert(index, m_tiles.value(index));
+	}
+	m_changed.clear();
+	reset = m_reset;
+	m_reset = false;
+	return changed;
+}
+
+////////////////////////////////////////////////////////////////////
+
+DisplayTilesItem::DisplayTilesItem(const QSize & size) : m_size(size)
+{
+	m_columns = tileColumns(size);
+	setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true);		// for option->exposedRect
+}
+
+void DisplayTilesItem::setTiles(bool reset, const DisplayTileImages & tiles) {
+	if (reset) {
+		m_images.clear();
+		m_pixmaps.clear();
+	}
+	for (auto it = tiles.constBegin(); it != tiles.constEnd(); ++it) {
+		m_images.insert(it.key(), it.value());
+		m_pixmaps.remove(it.key());
+	}
+
+	update();
+}
+
+QRectF DisplayTilesItem::boundingRect() const {
+	return QRectF(QPointF(0, 0), m_size);
+}
+
+void DisplayTilesItem::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget) {
+	Q_UNUSED(widget);
+
+	QRectF exposed = option->exposedRect;
+	for (auto it = m_images.constBegin(); it != m_images.constEnd(); ++it) {
+		// edge tiles reach past the picture
+		QRect r = tileRect(it.key(), m_columns) & QRect(QPoint(0, 0), m_size);
+		if (!exposed.intersects(r)) continue;
+
+		auto pixmap = m_pixmaps.find(it.key());
+		if (pixmap == m_pixmaps.end()) {
+			pixmap = m_pixmaps.insert(it.key(), QPixmap::fromImage(it.value()));
+		}
+		painter->drawPixmap(r.topLeft(), pixmap.value(), QRect(QPoint(0, 0), r.size()));
+	}
+}
@@ -0,0 +1,77 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+
+#ifndef DISPLAYTILES_H
+#define DISPLAYTILES_H
+
+#include <QGraphicsItem>
+#include <QHash>
+#include <QImage>
+#include <QPixmap>
+#include <QSet>
+#include <QSize>
+
+// The router's progress picture, one pixel per grid cell, cut into DisplayTileSize square tiles.
+// A tile gets an image only once something is drawn on it, and only tiles changed since the
+// last snapshot are handed over to the scene.
+
+typedef QHash<int, QImage> DisplayTileImages;
+
+class DisplayTiles
+{
+public:
+	static constexpr int DisplayTileSize = 128;
+
+public:
+	DisplayTiles(const QSize &);
+
+	void fill();									// back to transparent
+	void setPixel(int x, int y, uint color);		// ignores pixels off the picture
+	DisplayTileImages takeChanged(bool & reset);	// reset: fill() was called since the last time
+
+protected:
+	QSize m_size;
+	int m_columns;
+	DisplayTileImages m_tiles;
+	QSet<int> m_changed;
+	bool m_reset = false;
+};
+
+// Shows the snapshots in the scene.  Only tiles inside the exposed area are painted, and each
+// becomes a pixmap the first time it is.
+
+class DisplayTilesItem : public QGraphicsItem
+{
+public:
+	DisplayTilesItem(const QSize &);
+
+	void setTiles(bool reset, const DisplayTileImages &);
+	QRectF boundingRect() const override;
+	void paint(QPainter *, const QStyleOptionGraphicsItem *, QWidget * widget = nullptr) override;
+
+protected:
+	QSize m_size;
+	int m_columns;
+	DisplayTileImages m_images;
+	QHash<int, QPixmap> m_pixmaps;
+};
+
+#endif
@@ -0,0 +1,252 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+#include "gridqueue.h"
+
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr quint32 NodeDone = 0x80000000;
+static constexpr quint32 NodeTop = 0x40000000;			// z is 0 or 1, so it takes one bit
+static constexpr quint32 NodeCell = NodeTop - 1;
+static constexpr double FractionSlots = 256;				// a power of two, so slot costs are exact
+static constexpr size_t MaxSlots = 1 << 20;
+static constexpr double MaxStep = 4611686018427387904.0;	// 2^62, so slot arithmetic stays inside qint64
+
+////////////////////////////////////////////////////////////////////
+
+bool GridPoint::operator<(const GridPoint& other) const {
+	// make sure lower cost is first
+	return qCost > other.qCost;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void GridQueue::setKind(Kind kind, int gridX, int gridY) {
+	clear();
+	m_kind = kind;
+	m_gridX = gridX;
+	m_gridY = gridY;
+}
+
+GridQueue::Kind GridQueue::kind() const {
+	return m_kind;
+}
+
+bool GridQueue::empty() const {
+	if (m_kind == Heap) return m_heap.empty();
+
+	return m_count == 0 && m_far.empty();
+}
+
+size_t GridQueue::size() const {
+	if (m_kind == Heap) return m_heap.size();
+
+	return m_count + m_far.size();
+}
+
+void GridQueue::push(const GridPoint & gridPoint) {
+	if (m_kind == Heap) {
+		m_heap.push(gridPoint);
+		return;
+	}
+
+	if (m_count == 0) {
+		// the window starts over, so pick its step from the cost it starts on
+		m_scale = (gridPoint.qCost == std::floor(gridPoint.qCost)) ? 1 : FractionSlots;
+	}
+	double scaled = gridPoint.qCost * m_scale;
+	double step = std::floor(scaled);
+	Node node;
+	Q_ASSERT(gridPoint.z < 2);
+	node.cell = (quint32) ((gridPoint.y * m_gridX) + gridPoint.x);
+	if (gridPoint.z) node.cell |= NodeTop;
+	if (gridPoint.flags & GridPointDone) node.cell |= NodeDone;
+	node.baseCostLow = (quint32) gridPoint.baseCost;
+	node.baseCostHigh = (quint32) (gridPoint.baseCost >> 32);
+	int index = (qAbs(step) < MaxStep) ? bucketFor((qint64) step) : -1;
+	if (index < 0) {
+		m_far.push_back({ gridPoint.qCost, m_pushes++, node });
+		std::push_heap(m_far.begin(), m_far.end(), later);
+		return;
+	}
+
+	CostBucket & bucket = m_buckets[index];
+	if (scaled == step) {
+		bucket.nodes.push_back(node);
+	}
+	else {
+		bucket.between.push_back({ gridPoint.qCost, m_pushes, node });
+		std::push_heap(bucket.between.begin(), bucket.between.end(), later);
+	}
+	m_pushes++;
+	m_count++;
+}
+
+GridPoint GridQueue::top() const {
+	if (m_kind == Heap) return m_heap.top();
+
+	// a cost on the slot boundary is the lowest in its slot, so those nodes go first
+	const Node * node;
+	double cost;
+	if (farFirst()) {
+		node = &m_far.front().node;
+		cost = m_far.front().cost;
+	}
+	else {
+		const CostBucket & bucket = m_buckets[m_slots[m_low]];
+		if (bucket.head < bucket.nodes.size()) {
+			node = &bucket.nodes[bucket.head];
+			cost = (m_base + (qint64) m_low) / m_scale;
+		}
+		else {
+			node = &bucket.between.front().node;
+			cost = bucket.between.front().cost;
+		}
+	}
+	int cell = node->cell & NodeCell;
+	GridPoint gridPoint;
+	gridPoint.x = cell % m_gridX;
+	gridPoint.y = cell / m_gridX;
+	gridPoint.z = (node->cell & NodeTop) ? 1 : 0;
+	gridPoint.baseCost = ((GridValue) node->baseCostHigh << 32) | node->baseCostLow;
+	gridPoint.qCost = cost;
+	gridPoint.flags = (node->cell & NodeDone) ? GridPointDone : 0;
+	return gridPoint;
+}
+
+void GridQueue::pop() {
+	if (m_kind == Heap) {
+		m_heap.pop();
+		return;
+	}
+
+	if (farFirst()) {
+		std::pop_heap(m_far.begin(), m_far.end(), later);
+		m_far.pop_back();
+		return;
+	}
+
+	CostBucket & bucket = m_buckets[m_slots[m_low]];
+	if (bucket.head < bucket.nodes.size()) {
+		bucket.head++;
+	}
+	else {
+		std::pop_heap(bucket.between.begin(), bucket.between.end(), later);
+		bucket.between.pop_back();
+	}
+	m_count--;
+	if (bucket.head < bucket.nodes.size() || !bucket.between.empty()) return;
+
+	release(m_low);
+	if (m_count == 0) return;
+
+	size_t word = m_low / 64;
+	quint64 bits = m_occupied[word] & (~Q_UINT64_C(0) << (m_low % 64));
+	while (bits == 0) {
+		bits = m_occupied[++word];
+	}
+	m_low = (word * 64) + qCountTrailingZeroBits(bits);
+}
+
+void GridQueue::clear() {
+	m_heap = std::priority_queue<GridPoint>();
+	for (size_t word = 0; word < m_occupied.size(); word++) {
+		// release what the last route left behind, but keep the allocations around for the next one
+		while (m_occupied[word]) {
+			size_t slot = (word * 64) + qCountTrailingZeroBits(m_occupied[word]);
+			m_buckets[m_slots[slot]].between.clear();
+			release(slot);
+		}
+	}
+	m_far.clear();
+	m_count = 0;
+	m_pushes = 0;
+}
+
+int GridQueue::bucketFor(qint64 step) {
+	if (m_count == 0) {
+		// nothing in the window, so it can start anywhere; leave room for lower costs
+		m_base = step - (qint64) (m_slots.size() / 2);
+	}
+	if (step < m_base) {
+		if ((quint64) (m_base - step) > MaxSlots - m_slots.size()) return -1;
+
+		size_t grow = qMax((size_t) (m_base - step), m_slots.size());
+		grow = qMin((grow + 63) & ~(size_t) 63, MaxSlots - m_slots.size());
+		m_slots.insert(m_slots.begin(), grow, -1);
+		m_occupied.insert(m_occupied.begin(), grow / 64, 0);
+		m_base -= (qint64) grow;
+		m_low += grow;
+	}
+	if ((quint64) (step - m_base) >= MaxSlots) return -1;
+
+	size_t slot = (size_t) (step - m_base);
+	if (slot >= m_slots.size()) {
+		size_t size = qMax(slot + 1, m_slots.size() * 2);
+		size = qMin((size + 63) & ~(size_t) 63, MaxSlots);
+		m_slots.resize(size, -1);
+		m_occupied.resize(size / 64, 0);
+	}
+
+	int index = m_slots[slot];
+	if (index < 0) {
+		if (m_freeBuckets.empty()) {
+			index = (int) m_buckets.size();
+			m_buckets.emplace_back();
+		}
+		else {
+			index = m_freeBuckets.back();
+			m_freeBuckets.pop_back();
+		}
+		m_slots[slot] = index;
+		m_occupied[slot / 64] |= Q_UINT64_C(1) << (slot % 64);
+	}
+	if (m_count == 0 || slot < m_low) m_low = slot;
+	return index;
+}
+
+void GridQueue::release(size_t slot) {
+	int index = m_slots[slot];
+	CostBucket & bucket = m_buckets[index];
+	bucket.nodes.clear();
+	bucket.head = 0;
+	m_slots[slot] = -1;
+	m_occupied[slot / 64] &= ~(Q_UINT64_C(1) << (slot % 64));
+	m_freeBuckets.push_back(index);
+}
+
+bool GridQueue::farFirst() const {
+	if (m_far.empty()) return false;
+	if (m_count == 0) return true;
+
+	const CostBucket & bucket = m_buckets[m_slots[m_low]];
+	double cost = (bucket.head < bucket.nodes.size()) ? (m_base + (qint64) m_low) / m_scale : bucket.between.front().cost;
+	return m_far.front().cost < cost;
+}
+
+bool GridQueue::later(const CostNode & a, const CostNode & b) {
+	// std::push_heap() keeps the greatest on top, so this puts the lowest cost, then the first pushed, there
+	if (a.cost != b.cost) return a.cost > b.cost;
+
+	return a.order > b.order;
+}
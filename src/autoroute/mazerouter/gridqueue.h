@@ -0,0 +1,118 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+#ifndef GRIDQUEUE_H
+#define GRIDQUEUE_H
+
+#include <QtGlobal>
+#include <QPoint>
+
+#include <queue>
+#include <vector>
+
+typedef quint64 GridValue;
+
+static constexpr uchar GridPointDone = 1;
+
+struct GridPoint {
+	int x, y, z;
+	GridValue baseCost = 0;
+	double qCost = 0.0;
+	uchar flags = 0;
+
+	bool operator<(const GridPoint&) const;
+	GridPoint(QPoint p, int zed) : x(p.x()), y(p.y()), z(zed) { }
+	constexpr GridPoint() : x(0), y(0), z(0) { }
+};
+
+// The expansion frontier used by MazeRouter::route().
+//
+// Heap is the original std::priority_queue<GridPoint>.
+// Bucket is a Dial queue: a window of slots, one per cost step, with a bit per slot that holds a
+// bucket, so the lowest cost is found with a bit scan rather than a heap.  A cost that falls on a
+// slot boundary goes in that slot's bucket as a 12-byte node, popped in push order; many cells share
+// a cost, so most pushes and pops are a vector push_back and an index step.  Any other cost goes in
+// its slot's own small heap, which pops after the boundary nodes.  The step is a whole unit when the
+// queue starts out on a whole-number cost, as it does in route(), and 1/256 otherwise, since then
+// nearly every cost has a fraction and a whole unit would put most of the frontier in one slot.
+// The A* estimate means costs are not monotone, so a lower cost may be pushed at any time and the
+// window grows down as well as up.  Costs that would take it past MaxSlots go in a plain heap.
+// Only GridPointDone survives the round trip through a Bucket queue; route() uses no other flags.
+
+class GridQueue
+{
+public:
+	enum Kind {
+		Heap,
+		Bucket
+	};
+
+public:
+	void setKind(Kind, int gridX, int gridY);
+	Kind kind() const;
+	bool empty() const;
+	size_t size() const;
+	void push(const GridPoint &);
+	GridPoint top() const;
+	void pop();
+	void clear();
+
+protected:
+	struct Node {
+		quint32 cell;
+		quint32 baseCostLow;	// all 64 bits of the base cost, in two halves to keep the node 12 bytes
+		quint32 baseCostHigh;
+	};
+
+	struct CostNode {
+		double cost;
+		quint32 order;			// push order, for ties
+		Node node;
+	};
+
+	struct CostBucket {
+		std::vector<Node> nodes;			// the cost is the slot's own
+		size_t head = 0;					// next node to pop
+		std::vector<CostNode> between;		// a heap of costs between this slot and the next
+	};
+
+	int bucketFor(qint64 step);
+	void release(size_t slot);
+	bool farFirst() const;
+	static bool later(const CostNode &, const CostNode &);
+
+protected:
+	Kind m_kind = Heap;
+	int m_gridX = 0;
+	int m_gridY = 0;
+	std::priority_queue<GridPoint> m_heap;
+	std::vector<int> m_slots;			// bucket index for each cost step from m_base on, -1 for none
+	std::vector<quint64> m_occupied;	// a bit for each slot that has a bucket
+	qint64 m_base = 0;
+	double m_scale = 1;					// slots per unit of cost
+	size_t m_low = 0;					// the lowest slot with a bucket, while m_count is not 0
+	std::vector<CostBucket> m_buckets;
+	std::vector<int> m_freeBuckets;
+	std::vector<CostNode> m_far;		// a heap of costs outside the window
+	size_t m_count = 0;					// in the window
+	quint32 m_pushes = 0;
+};
+
+#endif
@@ -0,0 +1,263 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+#include "gridtiles.h"
+
+#include <QPair>
+#include <QTemporaryFile>
+
+#include <algorithm>
+
+GridTiles::GridTiles(int x, int y, int z, qint64 budget) :
+	m_x(x), m_y(y), m_z(z)
+{
+	m_columns = (x + TileMask) >> TileShift;
+	m_rows = (y + TileMask) >> TileShift;
+	m_tiles.resize(m_columns * m_rows * z);
+	m_residentLimit = (int) qMax((qint64) MinResidentTiles, qMin(budget / TileBytes, (qint64) m_tiles.count()));
+}
+
+GridTiles::~GridTiles()
+{
+	for (int index : m_resident) {
+		delete [] m_tiles.at(index).cells;
+	}
+	for (quint32 * cells : m_free) {
+		delete [] cells;
+	}
+	delete m_spillFile;
+}
+
+int GridTiles::tileIndex(int x, int y, int z) const {
+	Q_ASSERT(x >= 0 && x < m_x);
+	Q_ASSERT(y >= 0 && y < m_y);
+	Q_ASSERT(z >= 0 && z < m_z);
+	return (((z * m_rows) + (y >> TileShift)) * m_columns) + (x >> TileShift);
+}
+
+quint32 GridTiles::at(int x, int y, int z) const {
+	int index = tileIndex(x, y, z);
+	const Tile & tile = m_tiles.at(index);
+	if (tile.cells == nullptr && !tile.spilled) return tile.uniform;
+
+	return cells(index)[((y & TileMask) << TileShift) + (x & TileMask)];
+}
+
+void GridTiles::setAt(int x, int y, int z, quint32 value) {
+	int index = tileIndex(x, y, z);
+	const Tile & tile = m_tiles.at(index);
+	if (tile.cells == nullptr && !tile.spilled && tile.uniform == value) return;
+
+	touch(index);
+	cells(index)[((y & TileMask) << TileShift) + (x & TileMask)] = value;
+}
+
+void GridTiles::touch(int index) {
+	Tile & tile = m_tiles[index];
+	if (tile.touched) return;
+
+	tile.touched = true;
+	m_touched.append(index);
+}
+
+QList<QRect> GridTiles::touched(int z) const {
+	QList<QRect> rects;
+	int layerTiles = m_columns * m_rows;
+	for (int index : m_touched) {
+		if (index / layerTiles != z) continue;
+
+		int column = index % m_columns;
+		int row = (index / m_columns) % m_rows;
+		rects << (QRect(column << TileShift, row << TileShift, TileSize, TileSize) & QRect(0, 0, m_x, m_y));
+	}
+	return rects;
+}
+
+void GridTiles::forgetTouched() {
+	for (int index : m_touched) {
+		m_tiles[index].touched = false;
+	}
+	m_touched.clear();
+}
+
+quint32 * GridTiles::cells(int index) const {
+	Tile & tile = m_tiles[index];
+	tile.used = ++m_clock;
+	if (tile.cells) return tile.cells;
+
+	if (m_resident.count() >= m_residentLimit && !evict()) {
+		// nothing could be dropped, so go over the budget rather than fail
+		m_residentLimit++;
+	}
+
+	tile.cells = allocate();
+	m_resident.append(index);
+	if (tile.spilled) {
+		tile.spilled = false;
+		if (m_spillFile->seek((qint64) index * TileBytes) && m_spillFile->read((char *) tile.cells, TileBytes) == TileBytes) {
+			return tile.cells;
+		}
+
+		qWarning("GridTiles: unable to read back tile %d", index);
+		tile.uniform = 0;
+	}
+
+	std::fill_n(tile.cells, TileCells, tile.uniform);
+	return tile.cells;
+}
+
+quint32 * GridTiles::allocate() const {
+	if (m_free.isEmpty()) return new quint32[TileCells];
+
+	quint32 * cells = m_free.last();
+	m_free.removeLast();
+	return cells;
+}
+
+bool GridTiles::evict() const {
+	// drop the least recently used eighth in one go, so finding them is not paid for on every new tile
+	QVector<QPair<quint64, int> > byUse;
+	byUse.reserve(m_resident.count());
+	for (int index : m_resident) {
+		byUse.append(qMakePair(m_tiles.at(index).used, index));
+	}
+	if (byUse.isEmpty()) return false;
+
+	int count = qMax(1, byUse.count() / 8);
+	std::nth_element(byUse.begin(), byUse.begin() + count - 1, byUse.end());
+
+	bool dropped = false;
+	for (int i = 0; i < count; i++) {
+		int index = byUse.at(i).second;
+		Tile & tile = m_tiles[index];
+		quint32 value;
+		if (uniformCells(index, value)) {
+			tile.uniform = value;
+		}
+		else if (spill(index)) {
+			tile.spilled = true;
+		}
+		else continue;
+
+		m_free.append(tile.cells);
+		tile.cells = nullptr;
+		dropped = true;
+	}
+
+	if (!dropped) return false;
+
+	int kept = 0;
+	for (int i = 0; i < m_resident.count(); i++) {
+		int index = m_resident.at(i);
+		if (m_tiles.at(index).cells) m_resident[kept++] = index;
+	}
+	m_resident.resize(kept);
+	return true;
+}
+
+bool GridTiles::uniformCells(int index, quint32 & value) const {
+	// only the part of an edge tile that is inside the grid counts
+	int column = index % m_columns;
+	int row = (index / m_columns) % m_rows;
+	int width = qMin(TileSize, m_x - (column << TileShift));
+	int height = qMin(TileSize, m_y - (row << TileShift));
+	const quint32 * cells = m_tiles.at(index).cells;
+	value = cells[0];
+	for (int y = 0; y < height; y++) {
+		const quint32 * line = cells + (y << TileShift);
+		for (int x = 0; x < width; x++) {
+			if (line[x] != value) return false;
+		}
+	}
+
+	return true;
+}
+
+bool GridTiles::spill(int index) const {
+	if (m_spillFailed) return false;
+
+	if (m_spillFile == nullptr) {
+		m_spillFile = new QTemporaryFile;
+		if (!m_spillFile->open()) {
+			qWarning("GridTiles: no temporary file, keeping every tile in memory");
+			m_spillFailed = true;
+			return false;
+		}
+	}
+
+	// each tile has its own slot, so the file only grows as far as the tiles written out
+	if (!m_spillFile->seek((qint64) index * TileBytes) || m_spillFile->write((const char *) m_tiles.at(index).cells, TileBytes) != TileBytes) {
+		qWarning("GridTiles: unable to write out tile %d, keeping every tile in memory", index);
+		m_spillFailed = true;
+		return false;
+	}
+
+	m_spills++;
+	return true;
+}
+
+void GridTiles::clear() {
+	for (int index : m_resident) {
+		m_free.append(m_tiles.at(index).cells);
+	}
+	m_resident.clear();
+	m_touched.clear();
+	std::fill(m_tiles.begin(), m_tiles.end(), Tile());
+}
+
+void GridTiles::copy(int fromLayer, int toLayer) {
+	int layerTiles = m_columns * m_rows;
+	for (int i = 0; i < layerTiles; i++) {
+		int fromIndex = (fromLayer * layerTiles) + i;
+		int toIndex = (toLayer * layerTiles) + i;
+		touch(toIndex);
+		const Tile & from = m_tiles.at(fromIndex);
+		Tile & to = m_tiles[toIndex];
+		if (from.cells == nullptr && !from.spilled) {
+			if (to.cells) {
+				std::fill_n(to.cells, TileCells, from.uniform);
+			}
+			else {
+				to.spilled = false;
+				to.uniform = from.uniform;
+			}
+			continue;
+		}
+
+		// the target's old cells are about to be overwritten, so don't read them back;
+		// the tile touched last is never among those cells() evicts
+		to.spilled = false;
+		quint32 * toCells = cells(toIndex);
+		const quint32 * fromCells = cells(fromIndex);
+		std::copy_n(fromCells, TileCells, toCells);
+	}
+}
+
+qint64 GridTiles::bytes() const {
+	return (qint64) (m_resident.count() + m_free.count()) * TileBytes;
+}
+
+int GridTiles::residentLimit() const {
+	return m_residentLimit;
+}
+
+int GridTiles::spills() const {
+	return m_spills;
+}
@@ -0,0 +1,99 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+
+#ifndef GRIDTILES_H
+#define GRIDTILES_H
+
+#include <QList>
+#include <QRect>
+#include <QVector>
+
+class QTemporaryFile;
+
+// Storage for the tiled Grid: 32-bit cells in TileSize x TileSize tiles, one set per layer.
+// A tile holds a single value until something different is written to it, and only then gets
+// memory.  Once the tiles in memory would take more than the budget, the least recently used
+// one is dropped: back to a single value if all its cells are equal, else written to a
+// temporary file and read back the next time it is touched.
+
+class GridTiles
+{
+public:
+	static constexpr int TileShift = 6;
+	static constexpr int TileSize = 1 << TileShift;
+	static constexpr int TileMask = TileSize - 1;
+	static constexpr int TileCells = TileSize * TileSize;
+	static constexpr int TileBytes = TileCells * sizeof(quint32);
+	static constexpr int MinResidentTiles = 64;		// whatever the budget says
+
+public:
+	GridTiles(int x, int y, int z, qint64 budget);
+	~GridTiles();
+	GridTiles(const GridTiles &) = delete;
+	GridTiles & operator=(const GridTiles &) = delete;
+
+	quint32 at(int x, int y, int z) const;
+	void setAt(int x, int y, int z, quint32 value);
+	void clear();							// every cell back to 0
+	void copy(int fromLayer, int toLayer);
+	QList<QRect> touched(int z) const;		// the cells of every tile on a layer written since forgetTouched()
+	void forgetTouched();
+	qint64 bytes() const;					// tile memory allocated so far, not counting the table of tiles
+	int residentLimit() const;
+	int spills() const;						// tiles written out so far
+
+protected:
+	struct Tile {
+		quint32 * cells = nullptr;			// in memory
+		quint32 uniform = 0;				// every cell, while cells is null and not spilled
+		bool spilled = false;				// in the temporary file, at index * TileBytes
+		bool touched = false;				// written since forgetTouched()
+		quint64 used = 0;
+	};
+
+	int tileIndex(int x, int y, int z) const;
+	quint32 * cells(int index) const;
+	quint32 * allocate() const;
+	bool evict() const;
+	bool uniformCells(int index, quint32 & value) const;
+	bool spill(int index) const;
+	void touch(int index);
+
+protected:
+	int m_x;
+	int m_y;
+	int m_z;
+	int m_columns;
+	int m_rows;
+	QVector<int> m_touched;					// indexes of the tiles written since forgetTouched()
+
+	// which tiles are in memory: reading a cell can load its tile and drop others, so this changes in at() as well
+	mutable QVector<Tile> m_tiles;
+	mutable QVector<int> m_resident;		// indexes of the tiles in memory
+	mutable QVector<quint32 *> m_free;
+	mutable int m_residentLimit;
+	mutable int m_spills = 0;
+	mutable quint64 m_clock = 0;
+	mutable QTemporaryFile * m_spillFile = nullptr;
+	mutable bool m_spillFailed = false;
+};
+
+#endif
@@ -50,6 +50,9 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 //
 
 #include "mazerouter.h"
+#include "cellscan.h"
+#include "gridtiles.h"
+#include "searchstages.h"
 #include "../../sketch/pcbsketchwidget.h"
 #include "../../debugdialog.h"
 #include "../../items/virtualwire.h"
@@ -58,10 +61,12 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 #include "../../items/symbolpaletteitem.h"
 #include "../../items/via.h"
 #include "../../items/resizableboard.h"
+#include "../../items/pad.h"
 #include "../../utils/graphicsutils.h"
 #include "../../utils/graphutils.h"
 #include "../../utils/textutils.h"
 #include "../../utils/folderutils.h"
+#include "../../utils/fmessagebox.h"
 #include "../../connectors/connectoritem.h"
 #include "../../items/moduleidnames.h"
 #include "../../processeventblocker.h"
@@ -72,8 +77,13 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 #include "../../connectors/svgidlayer.h"
 
 #include <QApplication>
-#include <QMessageBox>
+#include <QEventLoop>
+#include <QFutureWatcher>
+#include <QPainterPathStroker>
 #include <QSettings>
+#include <QThread>
+#include <QFuture>
+#include <QtConcurrentRun>
 
 #include <qmath.h>
 #include <limits>
@@ -96,12 +106,63 @@ static constexpr GridValue GridAvoid = GridBoardObstacle - 4;
 static constexpr GridValue GridTempObstacle = GridBoardObstacle - 5;
 static constexpr GridValue GridSourceFlag = (GridBoardObstacle / 2) + 1;
 
+// compact Grid encoding: the three obstacle kinds are bit planes, the rest fits in a quint32 cell
+static constexpr int BoardPlane = 0;
+static constexpr int PartPlane = 1;
+static constexpr int AvoidPlane = 2;
+static constexpr int PlaneCount = 3;
+static constexpr quint32 CompactSource = std::numeric_limits<quint32>::max();
+static constexpr quint32 CompactTarget = CompactSource - 1;
+static constexpr quint32 CompactTempObstacle = CompactSource - 2;
+static constexpr quint32 CompactSourceFlag = (CompactSource / 2) + 1;
+static constexpr quint32 CompactCostLimit = CompactSourceFlag - 4;
+static constexpr quint32 CompactOverflow = CompactSourceFlag - 1;		// the cost is in Grid::overflow
+
+static constexpr qint64 CompactGridCells = 4 * 1024 * 1024;   // above this many cells (32MB of GridValue) use the compact Grid
+
+// tiled Grid encoding: compact cells, plus the three obstacle kinds in codes no compact cost reaches
+static constexpr quint32 TiledBoardObstacle = CompactCostLimit;
+static constexpr quint32 TiledPartObstacle = CompactCostLimit + 1;
+static constexpr quint32 TiledAvoid = CompactCostLimit + 2;
+
 static constexpr uint Layer1Cost = 100;
 static constexpr uint CrossLayerCost = 100;
 static constexpr uint ViaCost = 2000;
 static constexpr uint AvoidCost = 7;
 
-static constexpr uchar GridPointDone = 1;
+// negotiated congestion: a cell shared at the end of a pass costs this much more from then on,
+// and the penalty for cells currently used by other nets grows by PresentGrowth each pass
+static constexpr quint16 HistoryIncrement = 2;
+static constexpr double PresentGrowth = 1.5;
+static constexpr int MaxPresentFactor = 1000;
+static constexpr GridValue MaxCongestionCost = ViaCost;
+
+// coarse corridors: route() first finds a path over tiles of CorridorTileSize x CorridorTileSize cells,
+// then only expands within CorridorMargin tiles of it; boards under CorridorMinTiles tiles skip this
+static constexpr int CorridorTileSize = 16;
+static constexpr int CorridorMargin = 1;
+static constexpr int CorridorMinTiles = 64;
+
+// search regions: route() then tries boxes around source and target, the first with a margin of half the
+// box's longer side (at least RegionMinMargin cells), each next one with twice the margin, before the whole board.
+// A region covering half the board or more is not worth it.  Every stage may expand DefaultNodeBudget
+// percent of the grid's cells; a connection is given up on when the whole board stage runs out.
+static constexpr int RegionSteps = 3;
+static constexpr int RegionMinMargin = 8;
+static constexpr int DefaultNodeBudget = 100;
+
+// incremental runs: each retry rips up twice as many neighbours of every net left unrouted (1, 2, 4)
+static constexpr int MaxRipUpRounds = 3;
+
+// incremental runs: the line each autorouted trace was laid on, by trace id.  Undo and redo recreate a trace
+// with the same id, so this holds for the whole session.  A trace ending at a part that has turned more than
+// MaxTraceTurn degrees off it since was dragged there by the part.
+static QHash<long, QLineF> RoutedLines;
+static constexpr double MaxTraceTurn = 0.5;
+
+static constexpr int BatchPollInterval = 20;		// ms between checks on the batch workers
+static constexpr int DisplayInterval = 100;		// ms between display snapshots sent from the routing thread
+
 static constexpr uchar GridPointStepYPlus = 2;
 static constexpr uchar GridPointStepYMinus = 4;
 static constexpr uchar GridPointStepXPlus = 8;
@@ -224,6 +285,63 @@ bool byOrder(Trace & t1, Trace & t2) {
 	return (t1.order < t2.order);
 }
 
+QVector<QPoint> rasterizePath(const QPainterPath & path, const QRect & gridRect) {
+	// path is in grid coordinates; like init4(), which marks a cell if any of its 4 x 4 subsamples is set,
+	// a cell belongs to the path if about a sixteenth of it is covered
+	static constexpr int CoverageThreshold = 16;
+
+	QVector<QPoint> cells;
+	QRect r = path.boundingRect().toAlignedRect().intersected(gridRect);
+	if (r.isEmpty()) return cells;
+
+	QImage image(r.size(), QImage::Format_Grayscale8);
+	image.fill(0);
+	QPainter painter(&image);
+	painter.setRenderHint(QPainter::Antialiasing, true);
+	painter.translate(-r.topLeft());
+	painter.fillPath(path, Qt::white);
+	painter.end();
+
+	for (int iy = 0; iy < r.height(); iy++) {
+		const uchar * line = image.constScanLine(iy);
+		for (int ix = 0; ix < r.width(); ix++) {
+			if (line[ix] >= CoverageThreshold) {
+				cells.append(QPoint(r.left() + ix, r.top() + iy));
+			}
+		}
+	}
+
+	return cells;
+}
+
+QByteArray renderKey(const QList<ConnectorItem *> & subnet, int z) {
+	// a subnet is identified by its set of connectors, whatever order they were collected in
+	QVector<quintptr> ids;
+	ids.reserve(subnet.count() + 1);
+	Q_FOREACH (ConnectorItem * connectorItem, subnet) {
+		ids.append((quintptr) connectorItem);
+	}
+	std::sort(ids.begin(), ids.end());
+	ids.append((quintptr) z);
+	return QByteArray((const char *) ids.constData(), ids.count() * (int) sizeof(quintptr));
+}
+
+void removeNetTraces(Score & score, int netIndex) {
+	score.traces.remove(netIndex);
+	score.totalRoutedCount -= score.routedCount.value(netIndex);
+	score.routedCount.remove(netIndex);
+	score.totalViaCount -= score.viaCount.value(netIndex);
+	score.viaCount.remove(netIndex);
+	score.incompleteNets.remove(netIndex);
+}
+
+bool betterScore(const Score & score, const Score & bestScore) {
+	if (bestScore.ordering.order.count() == 0) return true;
+	if (score.totalRoutedCount > bestScore.totalRoutedCount) return true;
+
+	return (score.totalRoutedCount == bestScore.totalRoutedCount && score.totalViaCount < bestScore.totalViaCount);
+}
+
 /*
 inline double initialCost(QPoint p1, QPoint p2) {
     //return qAbs(p1.x() - p2.x()) + qAbs(p1.y() - p2.y());
@@ -312,28 +430,162 @@ void initMarkers(Markers & markers, bool pcbType) {
 
 ////////////////////////////////////////////////////////////////////
 
-bool GridPoint::operator<(const GridPoint& other) const {
-	// make sure lower cost is first
-	return qCost > other.qCost;
+inline bool fitsCompact(GridValue value) {
+	if (value == 0 || value == GridSource || value == GridTarget || value == GridTempObstacle) return true;
+
+	return (value & ~GridSourceFlag) < CompactCostLimit;
+}
+
+inline quint32 toCompact(GridValue value) {
+	if (value == 0) return 0;
+	if (value == GridSource) return CompactSource;
+	if (value == GridTarget) return CompactTarget;
+	if (value == GridTempObstacle) return CompactTempObstacle;
+
+	// only called when fitsCompact(); Grid::setAt() keeps bigger costs in Grid::overflow
+	quint32 compactCost = (quint32) (value & ~GridSourceFlag);
+	return (value & GridSourceFlag) ? compactCost | CompactSourceFlag : compactCost;
+}
+
+inline GridValue fromCompact(quint32 value) {
+	if (value == 0) return 0;
+	if (value == CompactSource) return GridSource;
+	if (value == CompactTarget) return GridTarget;
+	if (value == CompactTempObstacle) return GridTempObstacle;
+
+	GridValue cost = value & ~CompactSourceFlag;
+	return (value & CompactSourceFlag) ? cost | GridSourceFlag : cost;
+}
+
+inline quint32 toTiled(GridValue value) {
+	if (value == GridBoardObstacle) return TiledBoardObstacle;
+	if (value == GridPartObstacle) return TiledPartObstacle;
+	if (value == GridAvoid) return TiledAvoid;
+
+	return toCompact(value);
+}
+
+inline GridValue fromTiled(quint32 value) {
+	if (value == TiledBoardObstacle) return GridBoardObstacle;
+	if (value == TiledPartObstacle) return GridPartObstacle;
+	if (value == TiledAvoid) return GridAvoid;
+
+	return fromCompact(value);
+}
+
+Grid::Grid(int sx, int sy, int sz, Kind kind, qint64 budget) :
+	x(sx), y(sy), z(sz)
+{
+	switch (kind) {
+		case Tiled:
+			tiles = new GridTiles(sx, sy, sz, budget);
+			break;
+		case Compact:
+			planeWords = (int) ((((qint64) sx * sy) + 63) / 64);
+			cells = new quint32[(qint64) sx * sy * sz]();
+			planes = new quint64[(qint64) PlaneCount * sz * planeWords]();
+			break;
+		default:
+			data = new GridValue[(qint64) sx * sy * sz]();  // initialize to zero
+			break;
+	}
+}
+
+Grid::Kind Grid::kindFor(int sx, int sy, int sz, qint64 budget) {
+	// the compact grid needs a little over 4 bytes a cell; a grid that doesn't fit in the budget that way is tiled
+	qint64 count = (qint64) sx * sy * sz;
+	if (budget > 0 && count * (qint64) sizeof(quint32) > budget) return Tiled;
+	if (count > CompactGridCells) return Compact;
+	if (budget > 0 && count * (qint64) sizeof(GridValue) > budget) return Compact;
+
+	return Dense;
+}
+
+Grid::Kind Grid::kind() const {
+	if (tiles) return Tiled;
+	if (cells) return Compact;
+
+	return Dense;
+}
+
+bool Grid::allocated() const {
+	return data != nullptr || tiles != nullptr || (cells != nullptr && planes != nullptr);
 }
-////////////////////////////////////////////////////////////////////
 
-Grid::Grid(int sx, int sy, int sz) : 
-	data(new GridValue[sx * sy * sz]()), // initialize to zero
-	x(sx), y(sy), z(sz) { }
+qint64 Grid::bytes() const {
+	if (data) return (qint64) x * y * z * sizeof(GridValue);
+	if (tiles) return tiles->bytes();
+
+	return ((qint64) x * y * z * sizeof(quint32)) + ((qint64) PlaneCount * z * planeWords * sizeof(quint64));
+}
+
+int Grid::tileSpills() const {
+	return tiles ? tiles->spills() : 0;
+}
 
 GridValue Grid::at(int sx, int sy, int sz) const {
     Q_ASSERT (sx < x);
     Q_ASSERT (sy < y);
     Q_ASSERT (sz < z);
-	return *(data + (sz * y * x) + (sy * x) + sx);
+	// 64-bit before multiplying: the big boards these backends are for can have more than 2^31 cells
+	qint64 layer = (qint64) sz * y * x;
+	qint64 i = ((qint64) sy * x) + sx;
+	if (data) return *(data + layer + i);
+	if (tiles) {
+		quint32 value = tiles->at(sx, sy, sz);
+		if (value == CompactOverflow) return overflow.value(layer + i);
+
+		return fromTiled(value);
+	}
+
+	const quint64 * plane = planes + ((qint64) sz * planeWords) + (i >> 6);
+	quint64 bit = Q_UINT64_C(1) << (i & 63);
+	if (plane[BoardPlane * z * planeWords] & bit) return GridBoardObstacle;
+	if (plane[PartPlane * z * planeWords] & bit) return GridPartObstacle;
+	if (plane[AvoidPlane * z * planeWords] & bit) return GridAvoid;
+
+	quint32 value = *(cells + layer + i);
+	if (value == CompactOverflow) return overflow.value(layer + i);
+
+	return fromCompact(value);
 }
 
 void Grid::setAt(int sx, int sy, int sz, GridValue value) {
     Q_ASSERT (sx < x);
     Q_ASSERT (sy < y);
     Q_ASSERT (sz < z);
-	*(data + (sz * y * x) + (sy * x) + sx) = value;
+	qint64 layer = (qint64) sz * y * x;
+	qint64 i = ((qint64) sy * x) + sx;
+	if (data) {
+		*(data + layer + i) = value;
+		return;
+	}
+
+	// a cost too big for a 32-bit cell keeps its full value on the side
+	qint64 index = layer + i;
+	if (!overflow.isEmpty()) overflow.remove(index);
+	bool fits = fitsCompact(value) || value == GridBoardObstacle || value == GridPartObstacle || value == GridAvoid;
+	if (!fits) overflow.insert(index, value);
+
+	if (tiles) {
+		tiles->setAt(sx, sy, sz, fits ? toTiled(value) : CompactOverflow);
+		return;
+	}
+
+	quint64 * plane = planes + ((qint64) sz * planeWords) + (i >> 6);
+	quint64 bit = Q_UINT64_C(1) << (i & 63);
+	plane[BoardPlane * z * planeWords] &= ~bit;
+	plane[PartPlane * z * planeWords] &= ~bit;
+	plane[AvoidPlane * z * planeWords] &= ~bit;
+	if (value == GridBoardObstacle) plane[BoardPlane * z * planeWords] |= bit;
+	else if (value == GridPartObstacle) plane[PartPlane * z * planeWords] |= bit;
+	else if (value == GridAvoid) plane[AvoidPlane * z * planeWords] |= bit;
+	else {
+		*(cells + layer + i) = fits ? toCompact(value) : CompactOverflow;
+		return;
+	}
+
+	*(cells + layer + i) = 0;
 }
 
 QList<QPoint> Grid::init(int sx, int sy, int sz, int width, int height, const QImage & image, GridValue value, bool collectPoints) {
@@ -373,21 +625,13 @@ QList<QPoint> Grid::init4(int sx, int sy, int sz, int width, int height, const Q
 	QList<QPoint> points;
 	const uchar * bits1 = image->constScanLine(0);
 	int bytesPerLine = image->bytesPerLine();
+	QVector<int> cells(qMax(0, width));
 	for (int iy = sy; iy < sy + height; iy++) {
-		int offset = iy * bytesPerLine * 4;
-		for (int ix = sx; ix < sx + width; ix++) {
-			int byteOffset = (ix >> 1) + offset;
-			uchar mask = ix & 1 ? 0x0f : 0xf0;
-
-			if ((*(bits1 + byteOffset) & mask) != mask) ;
-			else if ((*(bits1 + byteOffset + bytesPerLine) & mask) != mask) ;
-			else if ((*(bits1 + byteOffset + bytesPerLine + bytesPerLine) & mask) != mask) ;
-			else if ((*(bits1 + byteOffset + bytesPerLine + bytesPerLine + bytesPerLine) & mask) != mask) ;
-			else continue;  // "pixel" is all white
-
-			setAt(ix, iy, sz, value);
+		int count = CellScan::blackCells(bits1 + (iy * bytesPerLine * 4), bytesPerLine, sx, width, cells.data());
+		for (int i = 0; i < count; i++) {
+			setAt(cells.at(i), iy, sz, value);
 			if (collectPoints) {
-				points.append(QPoint(ix, iy));
+				points.append(QPoint(cells.at(i), iy));
 			}
 		}
 	}
@@ -396,12 +640,60 @@ QList<QPoint> Grid::init4(int sx, int sy, int sz, int width, int height, const Q
 }
 
 void Grid::copy(int fromIndex, int toIndex) {
-	memcpy(((uchar *) data) + toIndex * x * y * sizeof(GridValue), ((uchar *) data) + fromIndex * x * y * sizeof(GridValue), x * y * sizeof(GridValue));
+	qint64 layer = (qint64) x * y;
+	if (data) {
+		memcpy(data + (toIndex * layer), data + (fromIndex * layer), layer * sizeof(GridValue));
+		return;
+	}
+	if (!overflow.isEmpty()) {
+		QHash<qint64, GridValue> copied;
+		for (auto it = overflow.constBegin(); it != overflow.constEnd(); ++it) {
+			qint64 index = it.key();
+			if (index / layer == toIndex) continue;
+
+			copied.insert(index, it.value());
+			if (index / layer == fromIndex) copied.insert(index + ((toIndex - fromIndex) * layer), it.value());
+		}
+		overflow = copied;
+	}
+	if (tiles) {
+		tiles->copy(fromIndex, toIndex);
+		return;
+	}
+
+	memcpy(cells + (toIndex * layer), cells + (fromIndex * layer), layer * sizeof(quint32));
+	for (int p = 0; p < PlaneCount; p++) {
+		memcpy(planes + ((qint64) (p * z) + toIndex) * planeWords, planes + ((qint64) (p * z) + fromIndex) * planeWords, planeWords * sizeof(quint64));
+	}
+}
+
+QList<QRect> Grid::touched(int z) const {
+	// a tiled grid only has to look at the tiles written since, rather than read back every spilled one
+	if (tiles) return tiles->touched(z);
+
+	QList<QRect> rects;
+	rects << QRect(0, 0, x, y);
+	return rects;
+}
+
+void Grid::forgetTouched() {
+	if (tiles) tiles->forgetTouched();
 }
 
 void Grid::clear() {
+	overflow.clear();
 	// memset can be very dangerous, clear out memory this way
-	std::fill_n(data, x * y * z, 0);
+	if (data) {
+		std::fill_n(data, (qint64) x * y * z, 0);
+		return;
+	}
+	if (tiles) {
+		tiles->clear();
+		return;
+	}
+
+	std::fill_n(cells, (qint64) x * y * z, 0);
+	std::fill_n(planes, (qint64) PlaneCount * z * planeWords, 0);
 }
 
 Grid::~Grid() {
@@ -409,6 +701,115 @@ Grid::~Grid() {
 		delete [] data;
 		data = nullptr;
 	}
+	if (cells) {
+		delete [] cells;
+		cells = nullptr;
+	}
+	if (planes) {
+		delete [] planes;
+		planes = nullptr;
+	}
+	if (tiles) {
+		delete tiles;
+		tiles = nullptr;
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+
+CongestionMap::CongestionMap(int x, int y, int z, int keepout, int halfVia, int halfJumper, bool bothSides) :
+    m_x(x),
+    m_y(y),
+    m_z(z),
+    m_keepout(keepout),
+    m_halfVia(halfVia),
+    m_halfJumper(halfJumper),
+    m_bothSides(bothSides),
+    m_present(x * y * z, 0),
+    m_history(x * y * z, 0),
+    m_mark(x * y * z, 0)
+{
+}
+
+GridValue CongestionMap::cost(int x, int y, int z) const {
+	int i = (z * m_x * m_y) + (y * m_x) + x;
+	GridValue c = m_history.at(i) + ((GridValue) presentFactor * m_present.at(i));
+	return qMin(c, MaxCongestionCost);
+}
+
+void CongestionMap::stamp(QVector<int> & cells, int cx, int cy, int cz, int half) {
+	for (int y = qMax(0, cy - half); y <= qMin(m_y - 1, cy + half); y++) {
+		for (int x = qMax(0, cx - half); x <= qMin(m_x - 1, cx + half); x++) {
+			int i = (cz * m_x * m_y) + (y * m_x) + x;
+			if (m_mark.at(i) == m_generation) continue;
+
+			m_mark[i] = m_generation;
+			cells.append(i);
+		}
+	}
+}
+
+void CongestionMap::addNet(int netIndex, const QList<Trace> & traces) {
+	// same footprint traceObstacles() would block, but each cell counted once per net
+	removeNet(netIndex);
+	if (++m_generation == 0) {
+		m_mark.fill(0);
+		m_generation = 1;
+	}
+
+	QVector<int> cells;
+	Q_FOREACH (Trace trace, traces) {
+		int lastZ = trace.gridPoints.at(0).z;
+		Q_FOREACH (GridPoint gridPoint, trace.gridPoints) {
+			if (gridPoint.z != lastZ) {
+				for (int z = 0; z < m_z; z++) {
+					stamp(cells, gridPoint.x, gridPoint.y, z, m_halfVia);
+				}
+				lastZ = gridPoint.z;
+			}
+			else {
+				stamp(cells, gridPoint.x, gridPoint.y, gridPoint.z, m_keepout);
+			}
+		}
+
+		if (trace.flags) {
+			GridPoint gridPoint = trace.gridPoints.first();
+			stamp(cells, gridPoint.x, gridPoint.y, 0, m_halfJumper);
+			if (m_bothSides && m_z > 1) {
+				stamp(cells, gridPoint.x, gridPoint.y, 1, m_halfJumper);
+			}
+		}
+	}
+
+	Q_FOREACH (int i, cells) {
+		if (m_present.at(i) < std::numeric_limits<quint16>::max()) m_present[i]++;
+	}
+	m_netCells.insert(netIndex, cells);
+}
+
+void CongestionMap::removeNet(int netIndex) {
+	Q_FOREACH (int i, m_netCells.take(netIndex)) {
+		if (m_present.at(i) > 0) m_present[i]--;
+	}
+}
+
+QSet<int> CongestionMap::sharedNets(const Score & score, int & sharedCells) {
+	// a trace cell is shared when some other net's trace or keepout also covers it;
+	// those cells get more expensive for every later pass
+	QSet<int> nets;
+	sharedCells = 0;
+	Q_FOREACH (Trace trace, score.traces) {
+		Q_FOREACH (GridPoint gridPoint, trace.gridPoints) {
+			int i = (gridPoint.z * m_x * m_y) + (gridPoint.y * m_x) + gridPoint.x;
+			if (m_present.at(i) <= 1) continue;
+
+			sharedCells++;
+			nets.insert(trace.netIndex);
+			m_history[i] = qMin<int>(std::numeric_limits<quint16>::max(), m_history.at(i) + HistoryIncrement);
+		}
+	}
+
+	return nets;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -417,12 +818,16 @@ Grid::~Grid() {
 void Score::setOrdering(const NetOrdering & _ordering) {
 	reorderNet = -1;
 	if (ordering.order.count() > 0) {
+		// keep the nets the two orderings start with, up to the first one left incomplete: routeNets()
+		// would route that one again with the later nets' traces in the way, so drop it and the rest.
+		// What is kept is then what routing the new ordering from scratch would give
 		bool remove = false;
 		for (int i = 0; i < ordering.order.count(); i++) {
-			if (!remove && (ordering.order.at(i) == _ordering.order.at(i))) continue;
+			if (!remove && (ordering.order.at(i) == _ordering.order.at(i)) && !incompleteNets.contains(ordering.order.at(i))) continue;
 
 			remove = true;
 			int netIndex = ordering.order.at(i);
+			incompleteNets.remove(netIndex);
 			traces.remove(netIndex);
 			int c = routedCount.value(netIndex);
 			routedCount.remove(netIndex);
@@ -507,7 +912,10 @@ MazeRouter::MazeRouter(PCBSketchWidget * sketchWidget, QGraphicsItem * board, bo
     m_grid(nullptr),
     m_cleanupCount(0),
     m_netLabelIndex(-1),
-    m_commandCount(0)
+    m_commandCount(0),
+    m_workerCount(1),
+    m_lookahead(1),
+    m_queueKind(GridQueue::Heap)
 {
 
 	CancelledMessage = tr("Autorouter was cancelled.");
@@ -515,8 +923,38 @@ MazeRouter::MazeRouter(PCBSketchWidget * sketchWidget, QGraphicsItem * board, bo
 	QSettings settings;
 	m_maxCycles = settings.value(MaxCyclesName, DefaultMaxCycles).toInt();
 
+	// more than one worker explores that many net orderings at the same time. They need orderings queued
+	// ahead to work on, so each net that fails queues lookahead of them (one worker's worth by default).
+	// The result depends on the lookahead, not on the worker count: one worker with the same lookahead
+	// routes the same orderings in the same order and ends with the same traces
+	m_workerCount = qBound(1, settings.value(WorkerCountName, 1).toInt(), qMax(1, QThread::idealThreadCount()));
+	m_lookahead = qMax(1, settings.value(LookaheadName, m_workerCount).toInt());
+
+	if (settings.value(FrontierName).toString() == "bucket") {
+		m_queueKind = GridQueue::Bucket;
+	}
+
 	m_bothSidesNow = sketchWidget->routeBothSides();
 	m_pcbType = sketchWidget->autorouteTypePCB();
+
+	// schematic obstacles are whole part bodies, so the shape rasterizer is only used for copper
+	m_geometryRaster = m_pcbType && settings.value(RasterizerName).toString() == "geometry";
+	// the shortcut index only holds connectors and traces, not other copper inside parts, so it is opt-in
+	m_indexedShortcuts = m_pcbType && settings.value(ShortcutCheckName).toString() == "geometry";
+	// schematic routing already trades off crossings through GridAvoid, so negotiation is PCB only
+	m_negotiated = m_pcbType && settings.value(StrategyName).toString() == "negotiated";
+	if (m_negotiated || m_lookahead < 2) {
+		// nothing to batch: negotiation routes one ordering, and without lookahead only one is ever queued
+		m_workerCount = 1;
+	}
+	// undoExpansion() cannot tell an expanded GridAvoid cell from open space, so corridors are PCB only;
+	// a corridor can steer a trace differently from the whole-board search, so they are opt-in
+	m_corridors = m_pcbType && settings.value(CorridorName, false).toBool();
+	// for the same reasons, search regions are PCB only and opt-in
+	m_regions = m_pcbType && settings.value(RegionName, false).toBool();
+	m_regionFallbacks.fill(0, RegionSteps);
+	m_nodeBudgetPercent = qMax(0, settings.value(NodeBudgetName, DefaultNodeBudget).toInt());
+	m_memoryBudget = (qint64) qMax(0, settings.value(MemoryBudgetName, DefaultMemoryBudget).toInt()) * 1024 * 1024;
 	m_board = board;
 
 	if (m_board) {
@@ -541,6 +979,9 @@ MazeRouter::MazeRouter(PCBSketchWidget * sketchWidget, QGraphicsItem * board, bo
 
 	m_standardWireWidth = m_sketchWidget->getAutorouterTraceWidth();
 
+	qRegisterMetaType<DisplayTileImages>("DisplayTileImages");
+	connect(this, &MazeRouter::displaySnapshot, this, &MazeRouter::showDisplay, Qt::QueuedConnection);
+
 	/*
 	// for debugging leave the last result hanging around
 	QList<QGraphicsPixmapItem *> pixmapItems;
@@ -563,10 +1004,70 @@ MazeRouter::MazeRouter(PCBSketchWidget * sketchWidget, QGraphicsItem * board, bo
 	}
 }
 
+MazeRouter::MazeRouter(const MazeRouter * master) :
+    Autorouter(master->m_sketchWidget),
+    m_viewLayerIDs(master->m_viewLayerIDs),
+    m_keepoutMils(master->m_keepoutMils),
+    m_keepoutGrid(master->m_keepoutGrid),
+    m_keepoutGridInt(master->m_keepoutGridInt),
+    m_halfGridViaSize(master->m_halfGridViaSize),
+    m_halfGridJumperSize(master->m_halfGridJumperSize),
+    m_gridPixels(master->m_gridPixels),
+    m_standardWireWidth(master->m_standardWireWidth),
+    m_boardImage(nullptr),
+    m_spareImage(nullptr),
+    m_spareImage2(nullptr),
+    m_temporaryBoard(false),
+    m_costFunction(master->m_costFunction),
+    m_jumperWillFitFunction(master->m_jumperWillFitFunction),
+    m_grid(nullptr),
+    m_cleanupCount(0),
+    m_netLabelIndex(-1),
+    m_commandCount(0),
+    m_workerCount(1),
+    m_lookahead(master->m_lookahead),
+    m_queueKind(master->m_queueKind),
+    m_geometryRaster(master->m_geometryRaster),
+    m_corridors(master->m_corridors),
+    m_regions(master->m_regions),
+    m_nodeBudget(master->m_nodeBudget)
+{
+	// a worker only runs routeNets(); it never touches the scene or the display images,
+	// so it gets its own grid, scratch image and master documents, and shares the rest read-only
+
+	m_bothSidesNow = master->m_bothSidesNow;
+	m_pcbType = master->m_pcbType;
+	m_board = master->m_board;
+	m_regionFallbacks.fill(0, RegionSteps);
+	m_maxCycles = master->m_maxCycles;
+	m_keepoutPixels = master->m_keepoutPixels;
+	m_maxRect = master->m_maxRect;
+	m_traceColors[0] = master->m_traceColors[0];
+	m_traceColors[1] = master->m_traceColors[1];
+
+	m_grid = new Grid(master->m_grid->x, master->m_grid->y, master->m_grid->z, master->m_grid->kind(), master->gridBudget());
+	m_boardImage = new QImage(*master->m_boardImage);     // implicitly shared, the worker only reads it
+	m_spareImage = new QImage(master->m_spareImage->size(), master->m_spareImage->format());
+
+	for (int z = 0; z < 2; z++) {
+		m_copperShapes[z] = master->m_copperShapes[z];
+		m_copperShapeIndex[z] = master->m_copperShapeIndex[z];
+	}
+	m_connectorGeometry = master->m_connectorGeometry;
+	m_netIDs = master->m_netIDs;
+	if (m_geometryRaster) return;		// routeNets() never reads the master documents
+
+	Q_FOREACH (ViewLayer::ViewLayerPlacement viewLayerPlacement, master->m_masterDocs.keys()) {
+		auto * masterDoc = new QDomDocument(master->m_masterDocs.value(viewLayerPlacement)->cloneNode(true).toDocument());
+		m_masterDocs.insert(viewLayerPlacement, masterDoc);
+	}
+}
+
 MazeRouter::~MazeRouter()
 {
     /// @todo replace explicit deletes with std::shared_ptr and std::unique_ptr
     /// where it makes sense. 
+	deleteWorkers();
 	Q_FOREACH (QDomDocument * doc, m_masterDocs) {
 		delete doc;
 	}
@@ -576,11 +1077,11 @@ MazeRouter::~MazeRouter()
 	if (m_displayItem[1]) {
 		delete m_displayItem[1];
 	}
-	if (m_displayImage[0]) {
-		delete m_displayImage[0];
+	if (m_displayTiles[0]) {
+		delete m_displayTiles[0];
 	}
-	if (m_displayImage[1]) {
-		delete m_displayImage[1];
+	if (m_displayTiles[1]) {
+		delete m_displayTiles[1];
 	}
 	if (m_temporaryBoard && m_board != nullptr) {
 		delete m_board;
@@ -600,11 +1101,22 @@ MazeRouter::~MazeRouter()
 }
 
 void MazeRouter::start()
+{
+	// an incremental run that leaves a net unrouted is undone and run again with a few more
+	// of the neighbouring nets ripped up, up to MaxRipUpRounds times
+	m_ripUpRound = 0;
+	while (startRun()) {
+		releaseRun();
+		m_ripUpRound++;
+	}
+}
+
+bool MazeRouter::startRun()
 {
 	if (m_pcbType) {
 		if (!m_board) {
-			QMessageBox::warning(nullptr, QObject::tr("Fritzing"), QObject::tr("Cannot autoroute: no board (or multiple boards) found"));
-			return;
+			FMessageBox::warning(nullptr, QObject::tr("Fritzing"), QObject::tr("Cannot autoroute: no board (or multiple boards) found"));
+			return false;
 		}
 		m_jumperWillFitFunction = jumperWillFit;
 		m_costFunction = distanceCost;
@@ -646,9 +1158,9 @@ void MazeRouter::start()
 
 	if (m_allPartConnectorItems.count() == 0) {
 		QString message = m_pcbType ?  QObject::tr("No connections (on the PCB) to route.") : QObject::tr("No connections to route.");
-		QMessageBox::information(nullptr, QObject::tr("Fritzing"), message);
+		FMessageBox::information(nullptr, QObject::tr("Fritzing"), message);
 		Autorouter::cleanUpNets();
-		return;
+		return false;
 	}
 
 	auto *parentCommand = new QUndoCommand("Autoroute");
@@ -656,7 +1168,13 @@ void MazeRouter::start()
 	new CleanUpWiresCommand(m_sketchWidget, CleanUpWiresCommand::UndoOnly, parentCommand);
 	new CleanUpRatsnestsCommand(m_sketchWidget, CleanUpWiresCommand::UndoOnly, parentCommand);
 
-	initUndo(parentCommand);
+	QSet<ItemBase *> ripUp;
+	if (m_incremental) {
+		if (m_ripUpRound == 0) findChangedNets();
+		ripUp = ripUpItems();
+		DebugDialog::debug(QString("autorouter incremental round %1: ripping up %2 nets, %3 items").arg(m_ripUpRound).arg(m_ripUpAnchors.count()).arg(ripUp.count()));
+	}
+	initUndo(parentCommand, m_incremental ? &ripUp : nullptr);
 
 	NetList netList;
 	auto totalToRoute = 0;
@@ -692,6 +1210,13 @@ void MazeRouter::start()
 		totalToRoute += net->net->count() - 1;
 	}
 
+	if (m_incremental && netList.nets.isEmpty()) {
+		FMessageBox::information(nullptr, QObject::tr("Fritzing"), tr("Nothing to reroute: every connection is routed and its traces keep their clearance."));
+		restoreOriginalState(parentCommand);
+		cleanUpNets(netList);
+		return false;
+	}
+
     std::sort(netList.nets.begin(), netList.nets.end(), byPinsWithin);
 	NetOrdering initialOrdering;
 	auto ix = 0;
@@ -709,21 +1234,33 @@ void MazeRouter::start()
 	if (m_cancelled || m_stopTracing) {
 		restoreOriginalState(parentCommand);
 		cleanUpNets(netList);
-		return;
+		return false;
 	}
 
 	QSizeF gridSize(m_maxRect.width() / m_gridPixels, m_maxRect.height() / m_gridPixels);
 	QSize boardImageSize(qCeil(gridSize.width()), qCeil(gridSize.height()));
-	m_grid = new Grid(boardImageSize.width(), boardImageSize.height(), m_bothSidesNow ? 2 : 1);
-	if (!m_grid->data) {
-		QMessageBox::information(nullptr, QObject::tr("Fritzing"), "Out of memory--unable to proceed");
+	auto layers = m_bothSidesNow ? 2 : 1;
+	m_grid = new Grid(boardImageSize.width(), boardImageSize.height(), layers, Grid::kindFor(boardImageSize.width(), boardImageSize.height(), layers, gridBudget()), gridBudget());
+	if (!m_grid->allocated()) {
+		FMessageBox::information(nullptr, QObject::tr("Fritzing"), "Out of memory--unable to proceed");
 		restoreOriginalState(parentCommand);
 		cleanUpNets(netList);
-		return;
+		return false;
 	}
+	m_stats.connectionsToRoute = totalToRoute;
+	m_stats.peakGridBytes = m_grid->bytes();
+	m_stats.gridTileSpills = 0;
+	m_nodeBudget = (qint64) m_nodeBudgetPercent * m_grid->x * m_grid->y * m_grid->z / 100;
+	DebugDialog::debug(QString("autorouter grid %1 x %2 x %3, %4 bytes%5").arg(m_grid->x).arg(m_grid->y).arg(m_grid->z).arg(m_grid->bytes()).arg(m_grid->kind() == Grid::Compact ? " (compact)" : m_grid->kind() == Grid::Tiled ? " (tiled)" : ""));
 
 	m_boardImage = new QImage(boardImageSize.width() * 4, boardImageSize.height() * 4, QImage::Format_Mono);
 	m_spareImage = new QImage(boardImageSize.width() * 4, boardImageSize.height() * 4, QImage::Format_Mono);
+	if (m_boardImage->isNull() || m_spareImage->isNull()) {
+		FMessageBox::information(nullptr, QObject::tr("Fritzing"), "Out of memory--unable to proceed");
+		restoreOriginalState(parentCommand);
+		cleanUpNets(netList);
+		return false;
+	}
 	if (m_temporaryBoard) {
 		m_boardImage->fill(0xffffffff);
 	}
@@ -738,90 +1275,75 @@ void MazeRouter::start()
 	if (m_cancelled || m_stopTracing) {
 		restoreOriginalState(parentCommand);
 		cleanUpNets(netList);
-		return;
+		return false;
 	}
-    /// @todo perfect candidate for std::unique_ptr<QImage[]>
-	m_displayImage[0] = new QImage(boardImageSize, QImage::Format_ARGB32);
-	m_displayImage[0]->fill(0);
-	m_displayImage[1] = new QImage(boardImageSize, QImage::Format_ARGB32);
-	m_displayImage[1]->fill(0);
+	m_displayTiles[0] = new DisplayTiles(boardImageSize);
+	m_displayTiles[1] = new DisplayTiles(boardImageSize);
 
+	QElapsedTimer phaseTimer;
+	phaseTimer.start();
 	QString message;
 	auto gotMasters = makeMasters(message);
+	m_stats.makeMastersMs = phaseTimer.elapsed();
 	if (m_cancelled || m_stopTracing || !gotMasters) {
 		restoreOriginalState(parentCommand);
 		cleanUpNets(netList);
-		return;
+		return false;
 	}
 
-	QList<NetOrdering> allOrderings;
-	allOrderings << initialOrdering;
-	Score bestScore;
-	Score currentScore;
-	auto run = 0;
-	for (; run < m_maxCycles && run < allOrderings.count(); run++) {
-		QString msg= tr("best so far: %1 of %2 routed").arg(bestScore.totalRoutedCount).arg(totalToRoute);
-		if (m_pcbType) {
-			msg +=  tr(" with %n vias", "", bestScore.totalViaCount);
-		}
-		Q_EMIT setProgressMessage(msg);
-		Q_EMIT setCycleMessage(tr("round %1 of:").arg(run + 1));
-		Q_EMIT setProgressValue(run);
-		ProcessEventBlocker::processEvents();
-		currentScore.setOrdering(allOrderings.at(run));
-		currentScore.anyUnrouted = false;
-		routeNets(netList, false, currentScore, gridSize, allOrderings);
-		if (bestScore.ordering.order.count() == 0) {
-			bestScore = currentScore;
-		}
-		else {
-			if (currentScore.totalRoutedCount > bestScore.totalRoutedCount) {
-				bestScore = currentScore;
-			}
-			else if (currentScore.totalRoutedCount == bestScore.totalRoutedCount && currentScore.totalViaCount < bestScore.totalViaCount) {
-				bestScore = currentScore;
-			}
-		}
-		if (m_cancelled || bestScore.anyUnrouted == false || m_stopTracing) break;
+	if (m_geometryRaster) {
+		collectCopperShapes(netList);
 	}
 
-	Q_EMIT disableButtons();
-
-	//DebugDialog::debug("done running");
-
+	// the search runs on a pool thread and never reads the scene: it gets the connector geometry and
+	// svg ids, each net's DRC::netIDs() and its batch workers from here. This thread keeps the dialog
+	// and the display live, then turns the result into scene items and undo commands
+	snapshotConnectors(netList);
+	if (m_workerCount > 1) {
+		createWorkers();
+	}
+	phaseTimer.restart();
+	RouteResult result;
+	QFutureWatcher<void> watcher;
+	QEventLoop loop;
+	connect(&watcher, &QFutureWatcher<void>::finished, &loop, &QEventLoop::quit);
+	watcher.setFuture(QtConcurrent::run([this, &result, &netList, gridSize, &initialOrdering, totalToRoute]() {
+		search(result, netList, gridSize, initialOrdering, totalToRoute);
+	}));
+	loop.exec();
+	deleteWorkers();
+	m_stats.routeMs = phaseTimer.elapsed();
+	Score & bestScore = result.bestScore;
+	DebugDialog::debug(QString("autorouter search done after %1 rounds").arg(result.rounds));
 
 	if (m_cancelled) {
 		doCancel(parentCommand);
-		return;
+		return false;
 	}
 
-	if (m_stopTracing) {
-		QString msg = tr("Routing stopped!");
-		msg += " ";
-		if (m_useBest) msg += tr("Use best so far...");
-		Q_EMIT setProgressMessage(msg);
-		if (m_useBest) {
-			routeNets(netList, true, bestScore, gridSize, allOrderings);
-		}
-	}
-	else if (!bestScore.anyUnrouted) {
-		Q_EMIT setProgressMessage(tr("Routing complete!"));
-		Q_EMIT setProgressValue(m_maxCycles);
-	}
-	else {
-		Q_EMIT setCycleMessage(tr("round %1 of:").arg(run));
-		QString msg;
-		if (run < m_maxCycles) msg = tr("Routing unsuccessful; stopping at round %1.").arg(run);
-		else msg = tr("Routing reached maximum round %1.").arg(m_maxCycles);
-		msg += " ";
-		msg += tr("Use best so far...");
-		Q_EMIT setProgressMessage(msg);
-		printOrder("best ", bestScore.ordering.order);
-		routeNets(netList, true, bestScore, gridSize, allOrderings);
-		Q_EMIT setProgressValue(m_maxCycles);
+	if (m_incremental && bestScore.anyUnrouted && !m_stopTracing && m_ripUpRound < MaxRipUpRounds && widenRipUp(netList, bestScore)) {
+		restoreOriginalState(parentCommand);
+		cleanUpNets(netList);
+		return true;
 	}
+
+	updateDisplay(0);
+	if (m_bothSidesNow) updateDisplay(1);
 	ProcessEventBlocker::processEvents();
 
+	if (m_pcbType) {
+		// optimizeTraces() checks the board edge against the routing grid's board cells
+		m_grid->clear();
+		m_grid->init4(0, 0, 0, m_grid->x, m_grid->y, m_boardImage, GridBoardObstacle, false);
+		m_offBoard = QBitArray(m_grid->x * m_grid->y);
+		m_offBoardColumns = m_grid->x;
+		for (int y = 0; y < m_grid->y; y++) {
+			for (int x = 0; x < m_grid->x; x++) {
+				if (m_grid->at(x, y, 0) == GridBoardObstacle) m_offBoard.setBit((y * m_grid->x) + x);
+			}
+		}
+	}
+
 	if (m_grid) {
 		delete m_grid;
 		m_grid = nullptr;
@@ -835,21 +1357,27 @@ void MazeRouter::start()
 		m_spareImage = nullptr;
 	}
 
-	m_boardImage = new QImage(m_maxRect.width() * OptimizeFactor, m_maxRect.height() * OptimizeFactor, QImage::Format_Mono);
-	m_spareImage = new QImage(m_maxRect.width() * OptimizeFactor, m_maxRect.height() * OptimizeFactor, QImage::Format_Mono);
-	m_spareImage2 = new QImage(m_maxRect.width() * OptimizeFactor, m_maxRect.height() * OptimizeFactor, QImage::Format_Mono);
+	if (!m_indexedShortcuts) {
+		// shortcuts are checked by painting them over the rendered obstacles
+		m_boardImage = new QImage(m_maxRect.width() * OptimizeFactor, m_maxRect.height() * OptimizeFactor, QImage::Format_Mono);
+		m_spareImage = new QImage(m_maxRect.width() * OptimizeFactor, m_maxRect.height() * OptimizeFactor, QImage::Format_Mono);
+		m_spareImage2 = new QImage(m_maxRect.width() * OptimizeFactor, m_maxRect.height() * OptimizeFactor, QImage::Format_Mono);
 
-	if (m_temporaryBoard) {
-		m_boardImage->fill(0xffffffff);
+		if (m_temporaryBoard) {
+			m_boardImage->fill(0xffffffff);
+		}
+		else {
+			m_boardImage->fill(0);
+			QRectF r2(0, 0, m_boardImage->width(), m_boardImage->height());
+			makeBoard(m_boardImage, m_keepoutPixels * 2, r2);
+		}
+		GraphicsUtils::drawBorder(m_boardImage, 2);
 	}
-	else {
-		m_boardImage->fill(0);
-		QRectF r2(0, 0, m_boardImage->width(), m_boardImage->height());
-		makeBoard(m_boardImage, m_keepoutPixels * 2, r2);
-	}
-	GraphicsUtils::drawBorder(m_boardImage, 2);
 
-	createTraces(netList, bestScore, parentCommand);
+	phaseTimer.restart();
+	auto * resultCommand = new AutorouteResultCommand(m_sketchWidget, parentCommand);
+	createTraces(netList, bestScore, resultCommand);
+	m_stats.createTracesMs = phaseTimer.elapsed() - m_stats.optimizeTracesMs;
 
 	cleanUpNets(netList);
     /// @todo leaks can occur if not careful
@@ -857,7 +1385,7 @@ void MazeRouter::start()
 	new CleanUpWiresCommand(m_sketchWidget, CleanUpWiresCommand::RedoOnly, parentCommand);
 
 	m_sketchWidget->blockUI(true);
-	m_commandCount = BaseCommand::totalChildCount(parentCommand);
+	m_commandCount = BaseCommand::totalChildCount(parentCommand) + resultCommand->count();
 	Q_EMIT setMaximumProgress(m_commandCount);
 	Q_EMIT setProgressMessage2(tr("Preparing undo..."));
 	if (m_displayItem[0]) {
@@ -872,7 +1400,105 @@ void MazeRouter::start()
 	m_sketchWidget->blockUI(false);
 	m_sketchWidget->repaint();
 	DebugDialog::debug("\n\n\nautorouting complete\n\n\n");
+	return false;
+}
+
+void MazeRouter::search(RouteResult & result, NetList & netList, const QSizeF gridSize, const NetOrdering & initialOrdering, int totalToRoute)
+{
+	// runs on a pool thread (see start()): only grid, image and DOM work, plus queued signals to the dialog;
+	// nothing here may create or change scene items
+	QList<NetOrdering> allOrderings;
+	allOrderings << initialOrdering;
+	Score & bestScore = result.bestScore;
+	Score currentScore;
+	auto run = 0;
+	if (m_negotiated) {
+		run = routeNegotiated(netList, bestScore, gridSize, allOrderings, totalToRoute);
+	}
+	while (!m_negotiated && run < m_maxCycles && run < allOrderings.count()) {
+		QString msg= tr("best so far: %1 of %2 routed").arg(bestScore.totalRoutedCount).arg(totalToRoute);
+		if (m_pcbType) {
+			msg +=  tr(" with %n vias", "", bestScore.totalViaCount);
+		}
+		Q_EMIT setProgressMessage(msg);
+		Q_EMIT setCycleMessage(tr("round %1 of:").arg(run + 1));
+		Q_EMIT setProgressValue(run);
+
+		auto batchCount = OrderingQueue::batchCount(run, m_maxCycles, allOrderings.count(), m_workers.count());
+		if (batchCount > 1) {
+			// on to the last ordering taken, which is where the serial loop would stop
+			run += routeBatch(netList, currentScore, bestScore, gridSize, allOrderings, run, batchCount) - 1;
+		}
+		else {
+			currentScore.setOrdering(allOrderings.at(run));
+			currentScore.anyUnrouted = false;
+			routeNets(netList, false, currentScore, gridSize, allOrderings);
+			if (betterScore(currentScore, bestScore)) {
+				bestScore = currentScore;
+			}
+		}
+		if (m_cancelled || bestScore.anyUnrouted == false || m_stopTracing) break;
+
+		run++;
+	}
+	QList<Grid *> grids;
+	grids << m_grid;
+	Q_FOREACH (MazeRouter * worker, m_workers) {
+		grids << worker->m_grid;
+	}
+	Q_FOREACH (Grid * grid, grids) {
+		// a tiled grid allocates tiles as the search reaches them
+		if (grid->kind() != Grid::Tiled) continue;
+
+		m_stats.peakGridBytes += grid->bytes();
+		m_stats.gridTileSpills += grid->tileSpills();
+	}
+	m_stats.connectionsRouted = bestScore.totalRoutedCount;
+	m_stats.nodesExpanded = m_nodesExpanded;
+	m_stats.corridorRoutes = m_corridorRoutes;
+	m_stats.corridorFallbacks = m_corridorFallbacks;
+	m_stats.regionRoutes = m_regionRoutes;
+	m_stats.regionFallbacks = m_regionFallbacks;
+	m_stats.budgetHits = m_budgetHits;
+	DebugDialog::debug(QString("autorouter render cache: %1 hits, %2 misses").arg(m_renderCacheHits).arg(m_renderCacheMisses));
+	DebugDialog::debug(QString("autorouter corridors: %1 routes, %2 fell back to the whole board").arg(m_corridorRoutes).arg(m_corridorFallbacks));
+	QStringList fallbacks;
+	Q_FOREACH (int count, m_regionFallbacks) fallbacks << QString::number(count);
+	DebugDialog::debug(QString("autorouter regions: %1 routes, widened %2; %3 connections over the node budget of %4")
+	                   .arg(m_regionRoutes).arg(fallbacks.join("/")).arg(m_budgetHits).arg(m_nodeBudget));
+
+	Q_EMIT disableButtons();
+
+	//DebugDialog::debug("done running");
 
+	result.rounds = run;
+	if (m_cancelled) return;
+
+	if (m_stopTracing) {
+		QString msg = tr("Routing stopped!");
+		msg += " ";
+		if (m_useBest) msg += tr("Use best so far...");
+		Q_EMIT setProgressMessage(msg);
+		if (m_useBest) {
+			routeNets(netList, true, bestScore, gridSize, allOrderings);
+		}
+	}
+	else if (!bestScore.anyUnrouted) {
+		Q_EMIT setProgressMessage(tr("Routing complete!"));
+		Q_EMIT setProgressValue(m_maxCycles);
+	}
+	else {
+		Q_EMIT setCycleMessage(tr("round %1 of:").arg(run));
+		QString msg;
+		if (run < m_maxCycles) msg = tr("Routing unsuccessful; stopping at round %1.").arg(run);
+		else msg = tr("Routing reached maximum round %1.").arg(m_maxCycles);
+		msg += " ";
+		msg += tr("Use best so far...");
+		Q_EMIT setProgressMessage(msg);
+		printOrder("best ", bestScore.ordering.order);
+		routeNets(netList, true, bestScore, gridSize, allOrderings);
+		Q_EMIT setProgressValue(m_maxCycles);
+	}
 }
 
 int MazeRouter::findPinsWithin(QList<ConnectorItem *> * net) {
@@ -991,6 +1617,8 @@ bool MazeRouter::routeNets(NetList & netList, bool makeJumper, Score & currentSc
 	routeThing.r4 = QRectF(QPointF(0, 0), gridSize * 4);
 	routeThing.layerSpecs << ViewLayer::NewBottom;
 	if (m_bothSidesNow) routeThing.layerSpecs << ViewLayer::NewTop;
+	routeThing.sourceQ.setKind(m_queueKind, m_grid->x, m_grid->y);
+	routeThing.targetQ.setKind(m_queueKind, m_grid->x, m_grid->y);
 
 	auto result = true;
 
@@ -1011,7 +1639,12 @@ bool MazeRouter::routeNets(NetList & netList, bool makeJumper, Score & currentSc
 		    );
 		*/
 
-		if (currentScore.routedCount.value(netIndex) == net->subnets.count() - 1) {
+		if (m_congestion) {
+			// negotiated congestion: every pass rips up and reroutes every net
+			m_congestion->removeNet(netIndex);
+			removeNetTraces(currentScore, netIndex);
+		}
+		else if (currentScore.routedCount.value(netIndex) == net->subnets.count() - 1) {
 			// this net was fully routed in a previous run
 			Q_FOREACH (Trace trace, currentScore.traces.values(netIndex)) {
 				displayTrace(trace);
@@ -1052,9 +1685,9 @@ bool MazeRouter::routeNets(NetList & netList, bool makeJumper, Score & currentSc
 		//DebugDialog::debug("find nearest pair");
 
 		findNearestPair(subnets, routeThing.nearest);
-		auto ip = routeThing.nearest.ic->sceneAdjustedTerminalPoint(nullptr) - m_maxRect.topLeft();
+		auto ip = geometry(routeThing.nearest.ic).terminalPoint - m_maxRect.topLeft();
 		routeThing.gridSourcePoint = QPoint(ip.x() / m_gridPixels, ip.y() / m_gridPixels);
-		auto jp = routeThing.nearest.jc->sceneAdjustedTerminalPoint(nullptr) - m_maxRect.topLeft();
+		auto jp = geometry(routeThing.nearest.jc).terminalPoint - m_maxRect.topLeft();
 		routeThing.gridTargetPoint = QPoint(jp.x() / m_gridPixels, jp.y() / m_gridPixels);
 
 		m_grid->clear();
@@ -1065,7 +1698,8 @@ bool MazeRouter::routeNets(NetList & netList, bool makeJumper, Score & currentSc
 
 		QList<Trace> traces = currentScore.traces.values();
 		if (m_pcbType) {
-			traceObstacles(traces, netIndex, m_grid, m_keepoutGridInt);
+			// when negotiating, expandOne() prices other nets' traces instead of blocking them
+			if (m_congestion == nullptr) traceObstacles(traces, netIndex, m_grid, m_keepoutGridInt);
 		}
 		else {
 			traceAvoids(traces, netIndex, routeThing);
@@ -1075,12 +1709,17 @@ bool MazeRouter::routeNets(NetList & netList, bool makeJumper, Score & currentSc
 			int z = viewLayerPlacement == ViewLayer::NewBottom ? 0 : 1;
 
 			QDomDocument * masterDoc = m_masterDocs.value(viewLayerPlacement);
+			if (m_geometryRaster) {
+				rasterizeObstacles(netIndex, z);
+				prepSourceAndTarget(masterDoc, routeThing, subnets, z, viewLayerPlacement);
+				continue;
+			}
 
 			//QString before = masterDoc->toString();
 
 			Markers markers;
 			initMarkers(markers, m_pcbType);
-			DRC::splitNetPrep(masterDoc, *(net->net), markers, routeThing.netElements[z].net, routeThing.netElements[z].alsoNet, routeThing.netElements[z].notNet, true);
+			DRC::splitNetPrep(masterDoc, m_netIDs.at(netIndex), markers, routeThing.netElements[z].net, routeThing.netElements[z].alsoNet, routeThing.netElements[z].notNet, true);
 			Q_FOREACH (QDomElement element, routeThing.netElements[z].net) {
 				element.setTagName("g");
 			}
@@ -1131,14 +1770,25 @@ bool MazeRouter::routeNets(NetList & netList, bool makeJumper, Score & currentSc
 			result = routeNext(makeJumper, routeThing, subnets, currentScore, netIndex, allOrderings);
 		}
 
+		if (!result || currentScore.routedCount.value(netIndex) < net->subnets.count() - 1) {
+			currentScore.incompleteNets.insert(netIndex);
+		}
+		else {
+			currentScore.incompleteNets.remove(netIndex);
+		}
+
+		if (m_congestion) {
+			m_congestion->addNet(netIndex, currentScore.traces.values(netIndex));
+		}
+
 		routeThing.netElements[0].net.clear();
 		routeThing.netElements[0].notNet.clear();
 		routeThing.netElements[0].alsoNet.clear();
 		routeThing.netElements[1].net.clear();
 		routeThing.netElements[1].notNet.clear();
 		routeThing.netElements[1].alsoNet.clear();
-		routeThing.sourceQ = std::priority_queue<GridPoint>();
-		routeThing.targetQ = std::priority_queue<GridPoint>();
+		routeThing.sourceQ.clear();
+		routeThing.targetQ.clear();
 
 		if (!result) break;
 	}
@@ -1168,7 +1818,7 @@ bool MazeRouter::routeOne(bool makeJumper, Score & currentScore, int netIndex, R
 		}
 		else {
 			routeThing.unrouted = true;
-			if (currentScore.reorderNet < 0) {
+			if (currentScore.reorderNet < 0 && m_congestion == nullptr) {
 				for (int i = 0; i < currentScore.ordering.order.count(); i++) {
 					if (currentScore.ordering.order.at(i) == netIndex) {
 						if (moveBack(currentScore, i, allOrderings)) {
@@ -1231,13 +1881,13 @@ bool MazeRouter::routeNext(bool makeJumper, RouteThing & routeThing, QList< QLis
 	routeThing.nearest.j = -1;
 	routeThing.nearest.distance = std::numeric_limits<double>::max();
 	findNearestPair(subnets, 0, combined, routeThing.nearest);
-	auto ip = routeThing.nearest.ic->sceneAdjustedTerminalPoint(nullptr) - m_maxRect.topLeft();
+	auto ip = geometry(routeThing.nearest.ic).terminalPoint - m_maxRect.topLeft();
 	routeThing.gridSourcePoint = QPoint(ip.x() / m_gridPixels, ip.y() / m_gridPixels);
-	auto jp = routeThing.nearest.jc->sceneAdjustedTerminalPoint(nullptr) - m_maxRect.topLeft();
+	auto jp = geometry(routeThing.nearest.jc).terminalPoint - m_maxRect.topLeft();
 	routeThing.gridTargetPoint = QPoint(jp.x() / m_gridPixels, jp.y() / m_gridPixels);
 
-	routeThing.sourceQ = std::priority_queue<GridPoint>();
-	routeThing.targetQ = std::priority_queue<GridPoint>();
+	routeThing.sourceQ.clear();
+	routeThing.targetQ.clear();
 
 	if (!m_pcbType) {
 		QList<Trace> traces = currentScore.traces.values();
@@ -1271,80 +1921,35 @@ bool MazeRouter::routeNext(bool makeJumper, RouteThing & routeThing, QList< QLis
 }
 
 bool MazeRouter::moveBack(Score & currentScore, int index, QList<NetOrdering> & allOrderings) {
-	if (index == 0) {
-		return false;  // nowhere to move back to
-	}
-
-	QList<int> order(currentScore.ordering.order);
-	//printOrder("start", order);
-	int netIndex = order.takeAt(index);
-	//printOrder("minus", order);
-	for (int i = index - 1; i >= 0; i--) {
-		bool done = true;
-		order.insert(i, netIndex);
-		//printOrder("plus ", order);
-		Q_FOREACH (NetOrdering ordering, allOrderings) {
-			bool gotOne = true;
-			for (int j = 0; j < order.count(); j++) {
-				if (order.at(j) != ordering.order.at(j)) {
-					gotOne = false;
-					break;
-				}
-			}
-			if (gotOne) {
-				done = false;
-				break;
-			}
-		}
-		if (done == true) {
-			NetOrdering newOrdering;
-			newOrdering.order = order;
-			allOrderings.append(newOrdering);
-			//printOrder("done ", newOrdering.order);
-
-			/*
-			const static int watch[] = { 0, 1, 2, 3, 6, 12, 14, 4, 5, 7, 8, 9, 10, 11, 13, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64 };
-			// {0, 1, 2, 4, 3, 12, 6, 14, 5, 7, 8, 9, 10, 11, 13, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64};
-
-			bool matches = true;
-			for (int i = 0; i < order.count(); i++) {
-			    if (order.at(i) != watch[i]) {
-			        matches = false;
-			        break;
-			    }
-			}
-			if (matches) {
-			    DebugDialog::debug("order matches");
-			}
-			*/
-			return true;
-		}
-		order.removeAt(i);
-	}
-
-	return false;
+	return OrderingQueue::moveBack(currentScore.ordering.order, index, m_lookahead, allOrderings) > 0;
 }
 
 void MazeRouter::prepSourceAndTarget(QDomDocument * masterDoc, RouteThing & routeThing, QList< QList<ConnectorItem *> > & subnets, int z, ViewLayer::ViewLayerPlacement viewLayerPlacement)
 {
-	Q_FOREACH (QDomElement element, routeThing.netElements[z].notNet) {
-		element.setTagName("g");
-	}
-	Q_FOREACH (QDomElement element, routeThing.netElements[z].alsoNet) {
-		element.setTagName("g");
-	}
+	QList<ConnectorItem *> li = subnets.at(routeThing.nearest.i);
+	QList<ConnectorItem *> lj = subnets.at(routeThing.nearest.j);
 
-	//QString debug = masterDoc->toString(4);
+	// only touch the master document if one of the two still has to be rendered
+	bool willRender = !m_geometryRaster && (!m_renderCache.contains(renderKey(li, z)) || !m_renderCache.contains(renderKey(lj, z)));
+	if (willRender) {
+		Q_FOREACH (QDomElement element, routeThing.netElements[z].notNet) {
+			element.setTagName("g");
+		}
+		Q_FOREACH (QDomElement element, routeThing.netElements[z].alsoNet) {
+			element.setTagName("g");
+		}
 
-	Q_FOREACH (QDomElement element, routeThing.netElements[z].net) {
-		// QString str;
-		// QTextStream stream(&str);
-		// element.save(stream, 0);
-		// DebugDialog::debug(str);
-		SvgFileSplitter::forceStrokeWidth(element, -2 * m_keepoutMils, "#000000", false, false);
+		//QString debug = masterDoc->toString(4);
+
+		Q_FOREACH (QDomElement element, routeThing.netElements[z].net) {
+			// QString str;
+			// QTextStream stream(&str);
+			// element.save(stream, 0);
+			// DebugDialog::debug(str);
+			SvgFileSplitter::forceStrokeWidth(element, -2 * m_keepoutMils, "#000000", false, false);
+		}
 	}
 
-	QList<ConnectorItem *> li = subnets.at(routeThing.nearest.i);
 	QList<QPoint> sourcePoints = renderSource(masterDoc, z, viewLayerPlacement, m_grid, routeThing.netElements[z].net, li, GridSource, true, routeThing.r4);
 
 	Q_FOREACH (QPoint p, sourcePoints) {
@@ -1354,7 +1959,6 @@ void MazeRouter::prepSourceAndTarget(QDomDocument * masterDoc, RouteThing & rout
 		routeThing.sourceQ.push(gridPoint);
 	}
 
-	QList<ConnectorItem *> lj = subnets.at(routeThing.nearest.j);
 	QList<QPoint> targetPoints = renderSource(masterDoc, z, viewLayerPlacement, m_grid, routeThing.netElements[z].net, lj, GridTarget, true, routeThing.r4);
 	Q_FOREACH (QPoint p, targetPoints) {
 		GridPoint gridPoint(p, z);
@@ -1363,8 +1967,10 @@ void MazeRouter::prepSourceAndTarget(QDomDocument * masterDoc, RouteThing & rout
 		routeThing.targetQ.push(gridPoint);
 	}
 
-	Q_FOREACH (QDomElement element, routeThing.netElements[z].net) {
-		SvgFileSplitter::forceStrokeWidth(element, 2 * m_keepoutMils, "#000000", false, false);
+	if (willRender) {
+		Q_FOREACH (QDomElement element, routeThing.netElements[z].net) {
+			SvgFileSplitter::forceStrokeWidth(element, 2 * m_keepoutMils, "#000000", false, false);
+		}
 	}
 
 	// restore masterdoc
@@ -1396,15 +2002,17 @@ void MazeRouter::findNearestPair(QList< QList<ConnectorItem *> > & subnets, int
 	for (int j = inetix + 1; j < subnets.count(); j++) {
 		QList<ConnectorItem *> jnet = subnets.at(j);
 		Q_FOREACH (ConnectorItem * ic, inet) {
-			QPointF ip = ic->sceneAdjustedTerminalPoint(nullptr);
-			ConnectorItem * icc = ic->getCrossLayerConnectorItem();
+			ConnectorGeometry ig = geometry(ic);
+			QPointF ip = ig.terminalPoint;
+			ConnectorItem * icc = ig.crossLayer;
 			Q_FOREACH (ConnectorItem * jc, jnet) {
-				ConnectorItem * jcc = jc->getCrossLayerConnectorItem();
+				ConnectorGeometry jg = geometry(jc);
+				ConnectorItem * jcc = jg.crossLayer;
 				if (jc == ic || jcc == ic) continue;
 
-				QPointF jp = jc->sceneAdjustedTerminalPoint(nullptr);
+				QPointF jp = jg.terminalPoint;
 				double d = qSqrt(GraphicsUtils::distanceSqd(ip, jp)) / m_gridPixels;
-				if (ic->attachedToViewLayerID() != jc->attachedToViewLayerID()) {
+				if (ig.viewLayerID != jg.viewLayerID) {
 					if (jcc != nullptr || icc != nullptr) {
 						// may not need a via
 						d += CrossLayerCost;
@@ -1415,7 +2023,7 @@ void MazeRouter::findNearestPair(QList< QList<ConnectorItem *> > & subnets, int
 					}
 				}
 				else {
-					if (jcc != nullptr && icc != nullptr && ic->attachedToViewLayerID() == ViewLayer::Copper1) {
+					if (jcc != nullptr && icc != nullptr && ig.viewLayerID == ViewLayer::Copper1) {
 						// route on the bottom when possible
 						d += Layer1Cost;
 					}
@@ -1433,63 +2041,88 @@ void MazeRouter::findNearestPair(QList< QList<ConnectorItem *> > & subnets, int
 }
 
 QList<QPoint> MazeRouter::renderSource(QDomDocument * masterDoc, int z, ViewLayer::ViewLayerPlacement viewLayerPlacement, Grid * grid, QList<QDomElement> & netElements, QList<ConnectorItem *> & subnet, GridValue value, bool clearElements, const QRectF & renderRect) {
-	if (clearElements) {
-		Q_FOREACH (QDomElement element, netElements) {
-			element.setTagName("g");
-		}
-	}
-
-	m_spareImage->fill(0xffffffff);
-	QMultiHash<QString, QString> partIDs;
-	QMultiHash<QString, QString> terminalIDs;
 	QList<ConnectorItem *> terminalPoints;
-	QRectF itemsBoundingRect;
-	Q_FOREACH (ConnectorItem * connectorItem, subnet) {
-		ItemBase * itemBase = connectorItem->attachedTo();
-		SvgIdLayer * svgIdLayer = connectorItem->connector()->fullPinInfo(itemBase->viewID(), itemBase->viewLayerID());
-		partIDs.insert(QString::number(itemBase->id()), svgIdLayer->m_svgId);
-		if (!svgIdLayer->m_terminalId.isEmpty()) {
-			terminalIDs.insert(QString::number(itemBase->id()), svgIdLayer->m_terminalId);
-			terminalPoints << connectorItem;
+	QList<QPoint> points;
+	QByteArray key = m_geometryRaster ? QByteArray() : renderKey(subnet, z);
+	auto cached = m_renderCache.constFind(key);
+	if (m_geometryRaster || cached != m_renderCache.constEnd()) {
+		if (m_geometryRaster) {
+			points = rasterizeSubnet(subnet, z, value);
 		}
-		itemsBoundingRect |= connectorItem->sceneBoundingRect();
-	}
-	Q_FOREACH (QDomElement element, netElements) {
-		if (idsMatch(element, partIDs)) {
-			element.setTagName(element.attribute("former"));
+		else {
+			// the footprint of a subnet does not depend on the net ordering, so only the first round renders it
+			m_renderCacheHits++;
+			points = cached.value();
+			Q_FOREACH (QPoint p, points) {
+				grid->setAt(p.x(), p.y(), z, value);
+			}
 		}
-		else if (idsMatch(element, terminalIDs)) {
-			element.setTagName(element.attribute("former"));
+		Q_FOREACH (ConnectorItem * connectorItem, subnet) {
+			if (!geometry(connectorItem).terminalID.isEmpty()) {
+				terminalPoints << connectorItem;
+			}
 		}
 	}
+	else {
+		m_renderCacheMisses++;
+		if (clearElements) {
+			Q_FOREACH (QDomElement element, netElements) {
+				element.setTagName("g");
+			}
+		}
 
-	if (!m_maxRect.contains(itemsBoundingRect)) {
-		qWarning("autorouter: m_maxRect does not contain itemsBoundingRect");
-		// Don't allow memory corruption
-		itemsBoundingRect = m_maxRect;
-	}
-	int x1 = qFloor((itemsBoundingRect.left() - m_maxRect.left()) / m_gridPixels);
-	int y1 = qFloor((itemsBoundingRect.top() - m_maxRect.top()) / m_gridPixels);
-	int x2 = qCeil((itemsBoundingRect.right() - m_maxRect.left()) / m_gridPixels);
-	int y2 = qCeil((itemsBoundingRect.bottom() - m_maxRect.top()) / m_gridPixels);
+		m_spareImage->fill(0xffffffff);
+		QMultiHash<QString, QString> partIDs;
+		QMultiHash<QString, QString> terminalIDs;
+		QRectF itemsBoundingRect;
+		Q_FOREACH (ConnectorItem * connectorItem, subnet) {
+			ConnectorGeometry g = geometry(connectorItem);
+			partIDs.insert(g.partID, g.svgID);
+			if (!g.terminalID.isEmpty()) {
+				terminalIDs.insert(g.partID, g.terminalID);
+				terminalPoints << connectorItem;
+			}
+			itemsBoundingRect |= g.sceneRect;
+		}
+		Q_FOREACH (QDomElement element, netElements) {
+			if (idsMatch(element, partIDs)) {
+				element.setTagName(element.attribute("former"));
+			}
+			else if (idsMatch(element, terminalIDs)) {
+				element.setTagName(element.attribute("former"));
+			}
+		}
 
-	ItemBase::renderOne(masterDoc, m_spareImage, renderRect);
+		if (!m_maxRect.contains(itemsBoundingRect)) {
+			qWarning("autorouter: m_maxRect does not contain itemsBoundingRect");
+			// Don't allow memory corruption
+			itemsBoundingRect = m_maxRect;
+		}
+		int x1 = qFloor((itemsBoundingRect.left() - m_maxRect.left()) / m_gridPixels);
+		int y1 = qFloor((itemsBoundingRect.top() - m_maxRect.top()) / m_gridPixels);
+		int x2 = qCeil((itemsBoundingRect.right() - m_maxRect.left()) / m_gridPixels);
+		int y2 = qCeil((itemsBoundingRect.bottom() - m_maxRect.top()) / m_gridPixels);
+
+		ItemBase::renderOne(masterDoc, m_spareImage, renderRect);
 #ifndef QT_NO_DEBUG
-	//static int rsi = 0;
-	//m_spareImage->save(FolderUtils::getUserDataStorePath("") + QString("/rendersource%1_%2.png").arg(rsi++,3,10,QChar('0')).arg(z));
+		//static int rsi = 0;
+		//m_spareImage->save(FolderUtils::getUserDataStorePath("") + QString("/rendersource%1_%2.png").arg(rsi++,3,10,QChar('0')).arg(z));
 #endif
-	QList<QPoint> points = grid->init4(x1, y1, z, x2 - x1, y2 - y1, m_spareImage, value, true);
+		points = grid->init4(x1, y1, z, x2 - x1, y2 - y1, m_spareImage, value, true);
+		m_renderCache.insert(key, points);
+	}
 
 
 
 	// terminal point hack (mostly for schematic view)
 	Q_FOREACH (ConnectorItem * connectorItem, terminalPoints) {
-		if (ViewLayer::specFromID(connectorItem->attachedTo()->viewLayerID()) != viewLayerPlacement) {
+		ConnectorGeometry g = geometry(connectorItem);
+		if (ViewLayer::specFromID(g.viewLayerID) != viewLayerPlacement) {
 			continue;
 		}
 
-		QPointF p = connectorItem->sceneAdjustedTerminalPoint(nullptr);
-		QRectF r = connectorItem->attachedTo()->sceneBoundingRect().adjusted(-m_keepoutPixels, -m_keepoutPixels, m_keepoutPixels, m_keepoutPixels);
+		QPointF p = g.terminalPoint;
+		QRectF r = g.partRect.adjusted(-m_keepoutPixels, -m_keepoutPixels, m_keepoutPixels, m_keepoutPixels);
 		QPointF closest(p.x(), r.top());
 		double d = qAbs(p.y() - r.top());
 		int dx = 0;
@@ -1576,31 +2209,75 @@ QList<GridPoint> MazeRouter::route(RouteThing & routeThing, int & viaCount)
 	viaCount = 0;
 	GridPoint done;
 	bool result = false;
-	while (!routeThing.sourceQ.empty() && !routeThing.targetQ.empty()) {
-		GridPoint gp = routeThing.sourceQ.top();
-		GridPoint gpt = routeThing.targetQ.top();
-		if (gpt.qCost < gp.qCost) {
-			gp = gpt;
-			routeThing.targetQ.pop();
-			routeThing.targetValue = GridSource;
-			routeThing.sourceValue = GridTarget;
-		}
-		else {
-			routeThing.sourceQ.pop();
-			routeThing.targetValue = GridTarget;
-			routeThing.sourceValue = GridSource;
-		}
 
-		if (gp.flags & GridPointDone) {
-			done = gp;
-			result = true;
-			break;
+	// the search widens in stages: the coarse corridor, then boxes around source and target,
+	// then the whole board; each stage starts over from the seeds
+	bool corridor = makeCorridor(routeThing);
+	int regionStep = 0;
+	routeThing.region = corridor ? QRect() : searchRegion(routeThing, regionStep);
+	if (!routeThing.region.isEmpty()) m_regionRoutes++;
+	SearchStages stages(m_nodeBudget, corridor || !routeThing.region.isEmpty());
+	GridQueue sourceSeeds;
+	GridQueue targetSeeds;
+	if (stages.bounded()) {
+		sourceSeeds = routeThing.sourceQ;
+		targetSeeds = routeThing.targetQ;
+	}
+
+	while (true) {
+		while (!routeThing.sourceQ.empty() && !routeThing.targetQ.empty()) {
+			GridPoint gp = routeThing.sourceQ.top();
+			GridPoint gpt = routeThing.targetQ.top();
+			if (gpt.qCost < gp.qCost) {
+				gp = gpt;
+				routeThing.targetQ.pop();
+				routeThing.targetValue = GridSource;
+				routeThing.sourceValue = GridTarget;
+			}
+			else {
+				routeThing.sourceQ.pop();
+				routeThing.targetValue = GridTarget;
+				routeThing.sourceValue = GridSource;
+			}
+
+			if (gp.flags & GridPointDone) {
+				done = gp;
+				result = true;
+				break;
+			}
+
+			expand(gp, routeThing);
+			if (m_cancelled || m_stopTracing) {
+				break;
+			}
+			if (!stages.expand()) break;
 		}
 
-		expand(gp, routeThing);
-		if (m_cancelled || m_stopTracing) {
-			break;
+		if (result || !stages.bounded() || m_cancelled || m_stopTracing) break;
+
+		// nothing within this bound, or the bound used up the budget: widen it and start over
+		QRect undoArea;
+		if (corridor) {
+			m_corridorFallbacks++;
+			corridor = false;
+			routeThing.corridor.clear();
 		}
+		else {
+			m_regionFallbacks[regionStep]++;
+			undoArea = routeThing.region;
+			regionStep++;
+		}
+		routeThing.region = (regionStep < RegionSteps) ? searchRegion(routeThing, regionStep) : QRect();
+		stages.widen(!routeThing.region.isEmpty());
+		undoExpansion(m_grid, undoArea);
+		routeThing.sourceQ = sourceSeeds;
+		routeThing.targetQ = targetSeeds;
+	}
+
+	routeThing.overBudget = stages.overBudget();
+	if (routeThing.overBudget) {
+		m_budgetHits++;
+		DebugDialog::debug(QString("autorouter gave up a connection after %1 nodes").arg(stages.expanded()));
 	}
 
 	//DebugDialog::debug(QString("routing result %1").arg(result));
@@ -1733,6 +2410,7 @@ void MazeRouter::expand(GridPoint & gridPoint, RouteThing & routeThing)
 	//if (debugit) {
 	//    DebugDialog::debug(QString("expand %1 %2 %3, %4").arg(gridPoint.x).arg(gridPoint.y).arg(gridPoint.z).arg(routeThing.pq.size()));
 	//}
+	m_nodesExpanded++;
 	if (gridPoint.x > 0) expandOne(gridPoint, routeThing, -1, 0, 0, false);
 	if (gridPoint.x < m_grid->x - 1) expandOne(gridPoint, routeThing, 1, 0, 0, false);
 	if (gridPoint.y > 0) expandOne(gridPoint, routeThing, 0, -1, 0, false);
@@ -1756,6 +2434,13 @@ void MazeRouter::expandOne(GridPoint & gridPoint, RouteThing & routeThing, int d
 
 	bool writeable = false;
 	bool avoid = false;
+	if (!routeThing.corridor.isEmpty() && !routeThing.corridor.testBit(((next.y / CorridorTileSize) * routeThing.corridorColumns) + (next.x / CorridorTileSize))) {
+		return;
+	}
+	if (!routeThing.region.isEmpty() && !routeThing.region.contains(next.x, next.y)) {
+		return;
+	}
+
 	GridValue nextval = m_grid->at(next.x, next.y, next.z);
 	if (nextval == GridPartObstacle || nextval == GridBoardObstacle || nextval == routeThing.sourceValue || nextval == GridTempObstacle) {
 		//DebugDialog::debug("exit expand one");
@@ -1830,6 +2515,9 @@ void MazeRouter::expandOne(GridPoint & gridPoint, RouteThing & routeThing, int d
 	else if (avoid) {
 		next.baseCost += AvoidCost;
 	}
+	if (m_congestion) {
+		next.baseCost += m_congestion->cost(next.x, next.y, next.z);
+	}
 	next.baseCost++;
 
 
@@ -1933,9 +2621,27 @@ bool MazeRouter::viaWillFit(GridPoint & gridPoint, Grid * grid) {
 }
 
 void MazeRouter::updateDisplay(int iz) {
-	QPixmap pixmap = QPixmap::fromImage(*m_displayImage[iz]);
+	if (m_displayTiles[iz] == nullptr) return;   // worker
+
+	bool reset;
+	if (QThread::currentThread() != thread()) {
+		// routing thread: the scene belongs to the GUI thread, so send it the changed tiles now and then
+		if (m_displayTimer[iz].isValid() && m_displayTimer[iz].elapsed() < DisplayInterval) return;
+
+		m_displayTimer[iz].start();
+		DisplayTileImages tiles = m_displayTiles[iz]->takeChanged(reset);
+		Q_EMIT displaySnapshot(iz, reset, tiles);
+		return;
+	}
+
+	DisplayTileImages tiles = m_displayTiles[iz]->takeChanged(reset);
+	showDisplay(iz, reset, tiles);
+	ProcessEventBlocker::processEvents();
+}
+
+void MazeRouter::showDisplay(int iz, bool reset, const DisplayTileImages & tiles) {
 	if (m_displayItem[iz] == nullptr) {
-		m_displayItem[iz] = new QGraphicsPixmapItem(pixmap);
+		m_displayItem[iz] = new DisplayTilesItem(QSize(qCeil(m_maxRect.width() / m_gridPixels), qCeil(m_maxRect.height() / m_gridPixels)));
 		m_displayItem[iz]->setFlag(QGraphicsItem::ItemIsSelectable, false);
 		m_displayItem[iz]->setFlag(QGraphicsItem::ItemIsMovable, false);
 		//m_displayItem[iz]->setPos(iz == 1 ? m_maxRect.topLeft() : m_maxRect.topRight());
@@ -1943,21 +2649,18 @@ void MazeRouter::updateDisplay(int iz) {
 		m_sketchWidget->scene()->addItem(m_displayItem[iz]);
 		m_displayItem[iz]->setZValue(5000);
 		//m_displayItem[iz]->setZValue(m_sketchWidget->viewLayers().value(iz == 0 ? ViewLayer::Copper0 : ViewLayer::Copper1)->nextZ());
-		m_displayItem[iz]->setScale(m_gridPixels);   // m_maxRect.width() / m_displayImage[iz]->width()
+		m_displayItem[iz]->setScale(m_gridPixels);   // m_maxRect.width() / grid width
 		m_displayItem[iz]->setVisible(true);
 	}
-	else {
-		m_displayItem[iz]->setPixmap(pixmap);
-	}
-	ProcessEventBlocker::processEvents();
+	m_displayItem[iz]->setTiles(reset, tiles);
 }
 
 void MazeRouter::updateDisplay(Grid * grid, int iz) {
-	m_displayImage[iz]->fill(0);
+	m_displayTiles[iz]->fill();
 	for (int y = 0; y < grid->y; y++) {
 		for (int x = 0; x < grid->x; x++) {
 			uint color = getColor(grid->at(x, y, iz));
-			if (color) m_displayImage[iz]->setPixel(x, y, color);
+			if (color) m_displayTiles[iz]->setPixel(x, y, color);
 		}
 	}
 
@@ -1969,29 +2672,165 @@ void MazeRouter::updateDisplay(GridPoint & gridPoint) {
 	//if (counter++ % 2 == 0) {
 	uint color = getColor(m_grid->at(gridPoint.x, gridPoint.y, gridPoint.z));
 	if (color) {
-		m_displayImage[gridPoint.z]->setPixel(gridPoint.x, gridPoint.y, color);
+		m_displayTiles[gridPoint.z]->setPixel(gridPoint.x, gridPoint.y, color);
 		updateDisplay(gridPoint.z);
 	}
 	//}
 }
 
 void MazeRouter::clearExpansion(Grid * grid) {
-	// TODO: keep a list of expansion points instead?
+	for (int z = 0; z < grid->z; z++) {
+		Q_FOREACH (const QRect & cells, grid->touched(z)) {
+			for (int y = cells.top(); y <= cells.bottom(); y++) {
+				for (int x = cells.left(); x <= cells.right(); x++) {
+					GridValue val = grid->at(x, y, z);
+					if (val == 0 || val == GridPartObstacle || val == GridBoardObstacle) ;
+					else grid->setAt(x, y, z, 0);
+				}
+			}
+		}
+	}
 
+	// whatever is left in the touched cells is obstacles and traces
+	grid->forgetTouched();
+}
+
+void MazeRouter::undoExpansion(Grid * grid, const QRect & area) {
+	// like clearExpansion(), but keeps the source and target so the same route can be searched again;
+	// a search confined to a region only has to be undone within it
 	for (int z = 0; z < grid->z; z++) {
-		for (int y = 0; y < grid->y; y++) {
-			for (int x = 0; x < grid->x; x++) {
-				GridValue val = grid->at(x, y, z);
-				if (val == 0 || val == GridPartObstacle || val == GridBoardObstacle) ;
-				else grid->setAt(x, y, z, 0);
+		Q_FOREACH (QRect cells, grid->touched(z)) {
+			if (!area.isEmpty()) cells &= area;
+			for (int y = cells.top(); y <= cells.bottom(); y++) {
+				for (int x = cells.left(); x <= cells.right(); x++) {
+					GridValue val = grid->at(x, y, z);
+					if (val == 0 || val == GridPartObstacle || val == GridBoardObstacle || val == GridSource || val == GridTarget) ;
+					else grid->setAt(x, y, z, 0);
+				}
 			}
 		}
 	}
 }
 
+QRect MazeRouter::searchRegion(RouteThing & routeThing, int step) {
+	if (!m_regions) return QRect();
+
+	QRect box = QRect(routeThing.gridSourcePoint, routeThing.gridTargetPoint).normalized();
+	int margin = qMax(RegionMinMargin, qMax(box.width(), box.height()) / 2) << step;
+	QRect region = box.adjusted(-margin, -margin, margin, margin) & QRect(0, 0, m_grid->x, m_grid->y);
+	if ((qint64) region.width() * region.height() * 2 >= (qint64) m_grid->x * m_grid->y) return QRect();
+
+	return region;
+}
+
+bool MazeRouter::makeCorridor(RouteThing & routeThing) {
+	// global routing pass: A* over coarse tiles from the source to the target connector,
+	// where a tile costs more the less of it is open.  The detailed search in route() is then
+	// confined to the tiles along that path plus a margin.
+	routeThing.corridor.clear();
+	if (!m_corridors) return false;
+
+	int columns = (m_grid->x + CorridorTileSize - 1) / CorridorTileSize;
+	int rows = (m_grid->y + CorridorTileSize - 1) / CorridorTileSize;
+	int tileCount = columns * rows;
+	if (tileCount < CorridorMinTiles) return false;
+
+	auto tileOf = [columns, rows](const QPoint & p) {
+		int column = qBound(0, p.x() / CorridorTileSize, columns - 1);
+		int row = qBound(0, p.y() / CorridorTileSize, rows - 1);
+		return (row * columns) + column;
+	};
+	int source = tileOf(routeThing.gridSourcePoint);
+	int target = tileOf(routeThing.gridTargetPoint);
+	auto estimate = [columns, target](int tile) {
+		return qAbs((tile % columns) - (target % columns)) + qAbs((tile / columns) - (target / columns));
+	};
+
+	QVector<int> costs(tileCount, -1);
+	QVector<int> distance(tileCount, std::numeric_limits<int>::max());
+	QVector<int> from(tileCount, -1);
+	std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int> >, std::greater<std::pair<int, int> > > queue;
+	distance[source] = 0;
+	queue.push(std::make_pair(estimate(source), source));
+	while (!queue.empty()) {
+		int tile = queue.top().second;
+		int d = queue.top().first - estimate(tile);
+		queue.pop();
+		if (tile == target) break;
+		if (d > distance.at(tile)) continue;		// stale entry
+
+		int column = tile % columns;
+		int row = tile / columns;
+		int neighbors[4] = { column > 0 ? tile - 1 : -1, column < columns - 1 ? tile + 1 : -1, row > 0 ? tile - columns : -1, row < rows - 1 ? tile + columns : -1 };
+		for (int neighbor : neighbors) {
+			if (neighbor < 0) continue;
+
+			if (costs.at(neighbor) < 0) {
+				costs[neighbor] = tileCost(neighbor % columns, neighbor / columns);
+			}
+			if (costs.at(neighbor) == 0 && neighbor != target) continue;
+
+			int nd = d + qMax(1, costs.at(neighbor));
+			if (nd >= distance.at(neighbor)) continue;
+
+			distance[neighbor] = nd;
+			from[neighbor] = tile;
+			queue.push(std::make_pair(nd + estimate(neighbor), neighbor));
+		}
+	}
+
+	if (distance.at(target) == std::numeric_limits<int>::max()) return false;
+
+	QBitArray corridor(tileCount);
+	for (int tile = target; tile >= 0; tile = from.at(tile)) {
+		int column = tile % columns;
+		int row = tile / columns;
+		for (int r = qMax(0, row - CorridorMargin); r <= qMin(rows - 1, row + CorridorMargin); r++) {
+			for (int c = qMax(0, column - CorridorMargin); c <= qMin(columns - 1, column + CorridorMargin); c++) {
+				corridor.setBit((r * columns) + c);
+			}
+		}
+	}
+
+	// not worth it when the corridor is most of the board
+	if (corridor.count(true) * 2 > tileCount) return false;
+
+	routeThing.corridor = corridor;
+	routeThing.corridorColumns = columns;
+	m_corridorRoutes++;
+	return true;
+}
+
+int MazeRouter::tileCost(int column, int row) {
+	// 0 when no layer has an open cell in the tile, otherwise 1 (open) to 4 (nearly blocked);
+	// the most open layer counts, since a via can always switch to it
+	int x0 = column * CorridorTileSize;
+	int y0 = row * CorridorTileSize;
+	int x1 = qMin(m_grid->x, x0 + CorridorTileSize);
+	int y1 = qMin(m_grid->y, y0 + CorridorTileSize);
+	int cells = (x1 - x0) * (y1 - y0);
+	int leastBlocked = cells;
+	for (int z = 0; z < m_grid->z; z++) {
+		int blocked = 0;
+		for (int y = y0; y < y1; y++) {
+			for (int x = x0; x < x1; x++) {
+				GridValue val = m_grid->at(x, y, z);
+				if (val == GridPartObstacle || val == GridBoardObstacle) blocked++;
+			}
+		}
+		leastBlocked = qMin(leastBlocked, blocked);
+	}
+
+	if (leastBlocked == cells) return 0;
+
+	return 1 + ((3 * leastBlocked) / cells);
+}
+
 void MazeRouter::initTraceDisplay() {
-	m_displayImage[0]->fill(0);
-	m_displayImage[1]->fill(0);
+	if (m_displayTiles[0] == nullptr) return;   // worker
+
+	m_displayTiles[0]->fill();
+	m_displayTiles[1]->fill();
 }
 
 void MazeRouter::displayTrace(Trace & trace) {
@@ -2000,18 +2839,20 @@ void MazeRouter::displayTrace(Trace & trace) {
 		return;
 	}
 
+	if (m_displayTiles[0] == nullptr) return;   // worker
+
 	int lastz = trace.gridPoints.at(0).z;
 	Q_FOREACH (GridPoint gridPoint, trace.gridPoints) {
 		if (gridPoint.z != lastz) {
 			for (int y = -m_halfGridViaSize; y <= m_halfGridViaSize; y++) {
 				for (int x = -m_halfGridViaSize; x <= m_halfGridViaSize; x++) {
-					m_displayImage[1]->setPixel(x + gridPoint.x, y + gridPoint.y, 0x80ff0000);
+					m_displayTiles[1]->setPixel(x + gridPoint.x, y + gridPoint.y, 0x80ff0000);
 				}
 			}
 			lastz = gridPoint.z;
 		}
 		else {
-			m_displayImage[lastz]->setPixel(gridPoint.x, gridPoint.y, m_traceColors[lastz]);
+			m_displayTiles[lastz]->setPixel(gridPoint.x, gridPoint.y, m_traceColors[lastz]);
 		}
 	}
 
@@ -2032,7 +2873,7 @@ void MazeRouter::displayTrace(Trace & trace) {
 		}
 		for (int y = -m_halfGridJumperSize; y <= m_halfGridJumperSize; y++) {
 			for (int x = xl; x <= xr; x++) {
-				m_displayImage[0]->setPixel(x + gridPoint.x, y + gridPoint.y, 0x800000ff);
+				m_displayTiles[0]->setPixel(x + gridPoint.x, y + gridPoint.y, 0x800000ff);
 			}
 		}
 	}
@@ -2126,7 +2967,7 @@ void MazeRouter::cleanUpNets(NetList & netList) {
 	Autorouter::cleanUpNets();
 }
 
-void MazeRouter::createTraces(NetList & netList, Score & bestScore, QUndoCommand * parentCommand) {
+void MazeRouter::createTraces(NetList & netList, Score & bestScore, AutorouteResultCommand * resultCommand) {
 	QMultiHash<int, Via *> allVias;
 	QMultiHash<int, JumperItem *> allJumperItems;
 	QMultiHash<int, SymbolPaletteItem *> allNetLabels;
@@ -2195,28 +3036,37 @@ void MazeRouter::createTraces(NetList & netList, Score & bestScore, QUndoCommand
 	}
 
 	//DebugDialog::debug("before optimize");
+	QElapsedTimer optimizeTimer;
+	optimizeTimer.start();
 	optimizeTraces(bestScore.ordering.order, allBundles, allVias, allJumperItems, allNetLabels, netList, connectionThing);
+	m_stats.optimizeTracesMs = optimizeTimer.elapsed();
 	//DebugDialog::debug("after optimize");
 
+	m_stats.viaCount = allVias.count();
+	m_stats.jumperCount = allJumperItems.count();
+
 	Q_FOREACH (SymbolPaletteItem * netLabel, allNetLabels) {
-		addNetLabelToUndo(netLabel, parentCommand);
+		addNetLabelToUndo(netLabel, resultCommand);
 	}
 	Q_FOREACH (Via * via, allVias) {
-		addViaToUndo(via, parentCommand);
+		addViaToUndo(via, resultCommand);
 	}
 	Q_FOREACH (JumperItem * jumperItem, allJumperItems) {
-		addJumperToUndo(jumperItem, parentCommand);
+		addJumperToUndo(jumperItem, resultCommand);
 	}
 
 	Q_FOREACH (QList< QPointer<TraceWire> > bundle, allBundles) {
 		Q_FOREACH (TraceWire * traceWire, bundle) {
-			addWireToUndo(traceWire, parentCommand);
+			if (m_pcbType && traceWire) {
+				RoutedLines.insert(traceWire->id(), QLineF(traceWire->connector0()->sceneAdjustedTerminalPoint(nullptr), traceWire->connector1()->sceneAdjustedTerminalPoint(nullptr)));
+			}
+			addWireToUndo(traceWire, resultCommand);
 		}
 	}
 
 	Q_FOREACH (ConnectorItem * source, connectionThing.sd.uniqueKeys()) {
 		Q_FOREACH (ConnectorItem * dest, connectionThing.values(source)) {
-			addConnectionToUndo(source, dest, parentCommand);
+			addConnectionToUndo(source, dest, resultCommand);
 		}
 	}
 
@@ -2310,10 +3160,10 @@ void MazeRouter::createTrace(Trace & trace, QList<GridPoint> & gridPoints, Trace
 		/*
 		GridPoint gp = gridPoints.last();
 		for (int x = gp.x - 5; x < gp.x + 5; x++) {
-		    m_displayImage[gp.z]->setPixel(x, gp.y, 0xff000000);
+		    m_displayTiles[gp.z]->setPixel(x, gp.y, 0xff000000);
 		}
 		for (int y = gp.y - 5; y < gp.y + 5; y++) {
-		    m_displayImage[gp.z]->setPixel(gp.x, y, 0xff000000);
+		    m_displayTiles[gp.z]->setPixel(gp.x, y, 0xff000000);
 		}
 		updateDisplay(gp.z);
 		*/
@@ -2692,37 +3542,53 @@ void MazeRouter::removeStep(int ix, QList<GridPoint> & gridPoints) {
 
 }
 
-void MazeRouter::addConnectionToUndo(ConnectorItem * from, ConnectorItem * to, QUndoCommand * parentCommand)
+void MazeRouter::addConnectionToUndo(ConnectorItem * from, ConnectorItem * to, AutorouteResultCommand * resultCommand)
 {
 	if (from == nullptr || to == nullptr) return;
 
-	auto * ccc = new ChangeConnectionCommand(m_sketchWidget, BaseCommand::CrossView,
-	        from->attachedToID(), from->connectorSharedID(),
-	        to->attachedToID(), to->connectorSharedID(),
-	        ViewLayer::specFromID(from->attachedToViewLayerID()),
-	        true, parentCommand);
-	ccc->setUpdateConnections(false);
+	AutorouteResultCommand::Connection connection;
+	connection.fromID = from->attachedToID();
+	connection.fromConnectorID = from->connectorSharedID();
+	connection.toID = to->attachedToID();
+	connection.toConnectorID = to->connectorSharedID();
+	connection.viewLayerPlacement = ViewLayer::specFromID(from->attachedToViewLayerID());
+	resultCommand->addConnection(connection);
 }
 
-void MazeRouter::addViaToUndo(Via * via, QUndoCommand * parentCommand) {
-	new AddItemCommand(m_sketchWidget, BaseCommand::CrossView, ModuleIDNames::ViaModuleIDName, via->viewLayerPlacement(), via->getViewGeometry(), via->id(), false, -1, parentCommand);
-	new SetPropCommand(m_sketchWidget, via->id(), "hole size", via->holeSize(), via->holeSize(), true, parentCommand);
-	new CheckStickyCommand(m_sketchWidget, BaseCommand::SingleView, via->id(), false, CheckStickyCommand::RemoveOnly, parentCommand);
+void MazeRouter::addViaToUndo(Via * via, AutorouteResultCommand * resultCommand) {
+	AutorouteResultCommand::Item item;
+	item.moduleID = ModuleIDNames::ViaModuleIDName;
+	item.viewLayerPlacement = via->viewLayerPlacement();
+	item.viewGeometry = via->getViewGeometry();
+	item.id = via->id();
+	item.prop = "hole size";
+	item.propValue = via->holeSize();
+	item.checkSticky = true;
+	resultCommand->addItem(item);
 }
 
-void MazeRouter::addJumperToUndo(JumperItem * jumperItem, QUndoCommand * parentCommand) {
+void MazeRouter::addJumperToUndo(JumperItem * jumperItem, AutorouteResultCommand * resultCommand) {
 	jumperItem->saveParams();
-	QPointF pos, c0, c1;
-	jumperItem->getParams(pos, c0, c1);
-
-	new AddItemCommand(m_sketchWidget, BaseCommand::CrossView, ModuleIDNames::JumperModuleIDName, jumperItem->viewLayerPlacement(), jumperItem->getViewGeometry(), jumperItem->id(), false, -1, parentCommand);
-	new ResizeJumperItemCommand(m_sketchWidget, jumperItem->id(), pos, c0, c1, pos, c0, c1, parentCommand);
-	new CheckStickyCommand(m_sketchWidget, BaseCommand::SingleView, jumperItem->id(), false, CheckStickyCommand::RemoveOnly, parentCommand);
+	AutorouteResultCommand::Item item;
+	item.moduleID = ModuleIDNames::JumperModuleIDName;
+	item.viewLayerPlacement = jumperItem->viewLayerPlacement();
+	item.viewGeometry = jumperItem->getViewGeometry();
+	item.id = jumperItem->id();
+	item.resizeJumper = true;
+	jumperItem->getParams(item.jumperPos, item.jumperC0, item.jumperC1);
+	item.checkSticky = true;
+	resultCommand->addItem(item);
 }
 
-void MazeRouter::addNetLabelToUndo(SymbolPaletteItem * netLabel, QUndoCommand * parentCommand) {
-	new AddItemCommand(m_sketchWidget, BaseCommand::CrossView, netLabel->moduleID(), netLabel->viewLayerPlacement(), netLabel->getViewGeometry(), netLabel->id(), false, -1, parentCommand);
-	new SetPropCommand(m_sketchWidget, netLabel->id(), "label", netLabel->getLabel(), netLabel->getLabel(), true, parentCommand);
+void MazeRouter::addNetLabelToUndo(SymbolPaletteItem * netLabel, AutorouteResultCommand * resultCommand) {
+	AutorouteResultCommand::Item item;
+	item.moduleID = netLabel->moduleID();
+	item.viewLayerPlacement = netLabel->viewLayerPlacement();
+	item.viewGeometry = netLabel->getViewGeometry();
+	item.id = netLabel->id();
+	item.prop = "label";
+	item.propValue = netLabel->getLabel();
+	resultCommand->addItem(item);
 }
 
 void MazeRouter::insertTrace(Trace & newTrace, int netIndex, Score & currentScore, int viaCount, bool incRouted) {
@@ -2764,6 +3630,281 @@ void MazeRouter::setMaxCycles(int maxCycles)
 	Q_EMIT setMaximumProgress(maxCycles);
 }
 
+void MazeRouter::setRunLimits(int maxCycles, bool bothSides)
+{
+	// unlike setMaxCycles() this only applies to this run and is not saved to the settings;
+	// bothSides can only turn off the second layer, not add one to a single-sided board
+	if (maxCycles > 0) {
+		m_maxCycles = maxCycles;
+	}
+
+	if (!bothSides && m_bothSidesNow) {
+		m_bothSidesNow = false;
+		while (m_viewLayerIDs.count() > 1) {
+			m_viewLayerIDs.removeLast();
+		}
+	}
+}
+
+const AutorouteStats & MazeRouter::stats() const
+{
+	return m_stats;
+}
+
+void MazeRouter::setIncremental(bool incremental)
+{
+	// keep the autorouted traces, vias and jumpers of nets that are still fine, see findChangedNets()
+	m_incremental = incremental;
+}
+
+void MazeRouter::releaseRun()
+{
+	// drop what startRun() built, so the next incremental round starts from the scene again
+	deleteWorkers();
+	Q_FOREACH (QDomDocument * doc, m_masterDocs) {
+		delete doc;
+	}
+	m_masterDocs.clear();
+	for (int iz = 0; iz < 2; iz++) {
+		delete m_displayTiles[iz];
+		m_displayTiles[iz] = nullptr;
+		m_copperShapes[iz].clear();
+		m_copperShapeIndex[iz].clear();
+	}
+	m_connectorGeometry.clear();
+	m_netIDs.clear();
+	delete m_grid;
+	m_grid = nullptr;
+	delete m_boardImage;
+	m_boardImage = nullptr;
+	delete m_spareImage;
+	m_spareImage = nullptr;
+	m_renderCache.clear();
+}
+
+QSet<ItemBase *> MazeRouter::autoroutedItems(QList<ConnectorItem *> * net) {
+	// the autoroutable traces, vias, jumpers and net labels currently connected to a net
+	QList<ConnectorItem *> equi(*net);
+	ConnectorItem::collectEqualPotential(equi, m_bothSidesNow, (ViewGeometry::RatsnestFlag | ViewGeometry::NormalFlag | ViewGeometry::PCBTraceFlag | ViewGeometry::SchematicTraceFlag) ^ m_sketchWidget->getTraceFlag());
+
+	QSet<ItemBase *> items;
+	Q_FOREACH (ConnectorItem * connectorItem, equi) {
+		ItemBase * itemBase = connectorItem->attachedTo()->layerKinChief();
+		auto * traceWire = qobject_cast<TraceWire *>(itemBase);
+		if (traceWire) {
+			if (traceWire->isTraceType(m_sketchWidget->getTraceFlag()) && traceWire->getAutoroutable()) items.insert(traceWire);
+			continue;
+		}
+		auto * via = qobject_cast<Via *>(itemBase);
+		if (via) {
+			if (via->getAutoroutable()) items.insert(via);
+			continue;
+		}
+		auto * jumperItem = qobject_cast<JumperItem *>(itemBase);
+		if (jumperItem) {
+			if (jumperItem->getAutoroutable()) items.insert(jumperItem);
+			continue;
+		}
+		auto * netLabel = qobject_cast<SymbolPaletteItem *>(itemBase);
+		if (netLabel && netLabel->isOnlyNetLabel() && netLabel->getAutoroutable()) items.insert(netLabel);
+	}
+
+	return items;
+}
+
+QSet<ItemBase *> MazeRouter::ripUpItems() {
+	QSet<ItemBase *> items;
+	Q_FOREACH (QList<ConnectorItem *> * net, m_allPartConnectorItems) {
+		Q_FOREACH (ConnectorItem * anchor, m_ripUpAnchors) {
+			if (!net->contains(anchor)) continue;
+
+			items.unite(autoroutedItems(net));
+			break;
+		}
+	}
+
+	return items;
+}
+
+void MazeRouter::addRipUpAnchor(QList<ConnectorItem *> * net) {
+	// nets are collected afresh every round, so remember one of the net's part connectors;
+	// vias and jumpers are deleted and recreated when a round is undone
+	Q_FOREACH (ConnectorItem * connectorItem, *net) {
+		ItemBase * itemBase = connectorItem->attachedTo()->layerKinChief();
+		if (qobject_cast<Via *>(itemBase) || qobject_cast<JumperItem *>(itemBase)) continue;
+
+		m_ripUpAnchors.append(connectorItem);
+		return;
+	}
+}
+
+static bool endsAtPart(TraceWire * traceWire) {
+	QList<ConnectorItem *> ends;
+	ends << traceWire->connector0() << traceWire->connector1();
+	Q_FOREACH (ConnectorItem * end, ends) {
+		Q_FOREACH (ConnectorItem * toConnectorItem, end->connectedToItems()) {
+			ItemBase * itemBase = toConnectorItem->attachedTo()->layerKinChief();
+			if (qobject_cast<Wire *>(itemBase) || qobject_cast<Via *>(itemBase) || qobject_cast<JumperItem *>(itemBase)) continue;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void MazeRouter::findChangedNets() {
+	// an incremental run rips up the nets whose autorouted copper no longer keeps its clearance
+	// from other nets' copper, which is what moving a part onto or next to routed traces does.
+	// It also rips up a net when an autorouted trace ending at a part connector no longer runs the
+	// way it was routed: moving or turning the part drags that end, so the trace leaves the connector
+	// at an angle the router did not lay, often off the 45 degree steps.  The angle is compared with
+	// RoutedLines; a part slid along the trace only stretches it and is kept.  Traces routed before
+	// this session have no line there, so only their clearance is checked.
+	// Nets with a missing connection are routed in any case, around the traces that are still there.
+	// Schematic has no clearance, so there only the missing connections are routed.
+
+	m_ripUpAnchors.clear();
+	if (!m_pcbType) return;
+
+	NetList allNets;
+	for (int i = 0; i < m_allPartConnectorItems.count(); i++) {
+		auto * net = new Net;
+		net->net = m_allPartConnectorItems.at(i);
+		net->id = i;
+		allNets.nets << net;
+	}
+
+	QSet<int> changed;
+	QPen keepoutPen(Qt::black, 0, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
+	for (int z = 0; z < (m_bothSidesNow ? 2 : 1); z++) {
+		ClearanceIndex clearance;
+		QList<SceneCopper> coppers = sceneCopper(allNets, z, QSet<ItemBase *>());
+		Q_FOREACH (const SceneCopper & copper, coppers) {
+			auto * traceWire = copper.connectorItems.isEmpty() ? nullptr : qobject_cast<TraceWire *>(copper.connectorItems.first()->attachedTo());
+			if (traceWire) {
+				QLineF line(traceWire->connector0()->sceneAdjustedTerminalPoint(nullptr), traceWire->connector1()->sceneAdjustedTerminalPoint(nullptr));
+				clearance.addSegment(line, (traceWire->width() / 2) + m_keepoutPixels, copper.netIndex);
+				continue;
+			}
+
+			QPainterPath grown = GraphicsUtils::shapeFromPath(copper.path, keepoutPen, 2 * m_keepoutPixels, true);
+			Q_FOREACH (QPolygonF polygon, grown.toFillPolygons()) {
+				clearance.addPolygon(polygon, grown.fillRule(), copper.netIndex);
+			}
+		}
+
+		Q_FOREACH (const SceneCopper & copper, coppers) {
+			if (copper.netIndex < 0 || copper.connectorItems.isEmpty() || changed.contains(copper.netIndex)) continue;
+
+			ItemBase * itemBase = copper.connectorItems.first()->attachedTo()->layerKinChief();
+			auto * traceWire = qobject_cast<TraceWire *>(itemBase);
+			if (traceWire) {
+				if (!traceWire->getAutoroutable()) continue;
+
+				QLineF line(traceWire->connector0()->sceneAdjustedTerminalPoint(nullptr), traceWire->connector1()->sceneAdjustedTerminalPoint(nullptr));
+				if (!m_maxRect.contains(line.p1()) || !m_maxRect.contains(line.p2()) || !clearance.clears(line, traceWire->width() / 2, copper.netIndex)) {
+					changed.insert(copper.netIndex);
+					continue;
+				}
+
+				auto routed = RoutedLines.constFind(traceWire->id());
+				if (routed == RoutedLines.constEnd() || !endsAtPart(traceWire)) continue;
+
+				double turn = line.angleTo(*routed);
+				if (line.length() < MinTraceManhattanLength || qMin(turn, 360 - turn) > MaxTraceTurn) {
+					changed.insert(copper.netIndex);
+				}
+				continue;
+			}
+
+			auto * via = qobject_cast<Via *>(itemBase);
+			auto * jumperItem = qobject_cast<JumperItem *>(itemBase);
+			if (!(via && via->getAutoroutable()) && !(jumperItem && jumperItem->getAutoroutable())) continue;
+
+			ConnectorItem * connectorItem = copper.connectorItems.first();
+			QPointF center = connectorItem->sceneAdjustedTerminalPoint(nullptr);
+			if (!clearance.clears(QLineF(center, center), connectorItem->sceneBoundingRect().width() / 2, copper.netIndex)) {
+				changed.insert(copper.netIndex);
+			}
+		}
+	}
+
+	Q_FOREACH (int netIndex, changed) {
+		addRipUpAnchor(m_allPartConnectorItems.at(netIndex));
+	}
+
+	Q_FOREACH (Net * net, allNets.nets) {
+		delete net;		// the connector lists belong to m_allPartConnectorItems
+	}
+}
+
+bool MazeRouter::widenRipUp(NetList & netList, const Score & bestScore) {
+	// for every net left unrouted, also rip up the kept nets whose autorouted copper is nearest to its pins;
+	// each round takes twice as many, so a local change stays local when it can
+	int wanted = 1 << m_ripUpRound;
+
+	QList<QRectF> unrouted;
+	Q_FOREACH (Net * net, netList.nets) {
+		if (bestScore.routedCount.value(net->id) >= net->subnets.count() - 1) continue;
+
+		QRectF r;
+		Q_FOREACH (ConnectorItem * connectorItem, *(net->net)) {
+			r |= connectorItem->sceneBoundingRect();
+		}
+		unrouted << r;
+	}
+
+	QList<QList<ConnectorItem *> *> kept;
+	QList< QList<QRectF> > keptCopper;
+	Q_FOREACH (QList<ConnectorItem *> * net, m_allPartConnectorItems) {
+		bool rippedUp = false;
+		Q_FOREACH (ConnectorItem * anchor, m_ripUpAnchors) {
+			if (net->contains(anchor)) {
+				rippedUp = true;
+				break;
+			}
+		}
+		if (rippedUp) continue;
+
+		QList<QRectF> rects;
+		Q_FOREACH (ItemBase * itemBase, autoroutedItems(net)) {
+			rects << itemBase->sceneBoundingRect();
+		}
+		if (rects.isEmpty()) continue;		// nothing of it would move
+
+		kept << net;
+		keptCopper << rects;
+	}
+
+	QSet<int> chosen;
+	Q_FOREACH (QRectF r, unrouted) {
+		QList< QPair<double, int> > byDistance;
+		for (int i = 0; i < kept.count(); i++) {
+			double distance = std::numeric_limits<double>::max();
+			Q_FOREACH (QRectF copper, keptCopper.at(i)) {
+				double dx = qMax(0.0, qMax(copper.left() - r.right(), r.left() - copper.right()));
+				double dy = qMax(0.0, qMax(copper.top() - r.bottom(), r.top() - copper.bottom()));
+				distance = qMin(distance, (dx * dx) + (dy * dy));
+			}
+			byDistance << qMakePair(distance, i);
+		}
+		std::sort(byDistance.begin(), byDistance.end());
+		for (int i = 0; i < byDistance.count() && i < wanted; i++) {
+			chosen.insert(byDistance.at(i).second);
+		}
+	}
+
+	int before = m_ripUpAnchors.count();
+	Q_FOREACH (int i, chosen) {
+		addRipUpAnchor(kept.at(i));
+	}
+	if (m_ripUpAnchors.count() == before) return false;
+
+	Q_EMIT setProgressMessage2(tr("Ripping up %n neighbouring net(s) and trying again...", "", m_ripUpAnchors.count() - before));
+	return true;
+}
+
 SymbolPaletteItem * MazeRouter::makeNetLabel(GridPoint & center, SymbolPaletteItem * pairedNetLabel, uchar traceFlags) {
 	// flags & JumperLeft means position the netlabel to the left of center, the netlabel points right
 
@@ -2882,14 +4023,14 @@ GridPoint MazeRouter::lookForJumper(GridPoint initial, GridValue targetValue, QP
 		if (targetValue == GridSource) bc ^= GridSourceFlag;
 		bc *= 3;
 		if (bc > 255) bc = 255;
-		m_displayImage[gp.z]->setPixel(gp.x, gp.y, 0xff000000 | (bc << 16) | (bc << 8) | bc);
+		m_displayTiles[gp.z]->setPixel(gp.x, gp.y, 0xff000000 | (bc << 16) | (bc << 8) | bc);
 		updateDisplay(gp.z);
 		*/
 
 		if ((*m_jumperWillFitFunction)(gp, m_grid, m_halfGridJumperSize)) {
 			if (targetValue == GridSource) gp.baseCost ^= GridSourceFlag;
 
-			//m_displayImage[gp.z]->setPixel(gp.x, gp.y, 0xff0000ff);
+			//m_displayTiles[gp.z]->setPixel(gp.x, gp.y, 0xff0000ff);
 			//updateDisplay(gp.z);
 			//updateDisplay(gp.z);
 
@@ -3001,8 +4142,11 @@ void MazeRouter::optimizeTraces(QList<int> & order, QMultiHash<int, QList< QPoin
 	QList<ViewLayer::ViewLayerPlacement> layerSpecs;
 	layerSpecs << ViewLayer::NewBottom;
 	if (m_bothSidesNow) layerSpecs << ViewLayer::NewTop;
-	QRectF r2(0, 0, m_boardImage->width(), m_boardImage->height());
+	QRectF r2 = m_boardImage ? QRectF(0, 0, m_boardImage->width(), m_boardImage->height()) : QRectF();
 	QPointF topLeft = m_maxRect.topLeft();
+	if (m_indexedShortcuts) {
+		indexCopperClearance(netList, bundles, vias, jumperItems);
+	}
 
 	//QList<int> order2(order);
 	//order2.append(order);
@@ -3013,95 +4157,100 @@ void MazeRouter::optimizeTraces(QList<int> & order, QMultiHash<int, QList< QPoin
 		Q_EMIT setProgressValue(progress++);
 		Net * net = netList.nets.at(netIndex);
 		Q_FOREACH (ViewLayer::ViewLayerPlacement layerSpec, layerSpecs) {
-			fastCopy(m_boardImage, m_spareImage);
-
-			QDomDocument * masterDoc = m_masterDocs.value(layerSpec);
-			//QString before = masterDoc->toString();
-			Markers markers;
-			initMarkers(markers, m_pcbType);
-			NetElements netElements;
-			DRC::splitNetPrep(masterDoc, *(net->net), markers, netElements.net, netElements.alsoNet, netElements.notNet, true);
-			Q_FOREACH (QDomElement element, netElements.net) {
-				element.setTagName("g");
-			}
-			Q_FOREACH (QDomElement element, netElements.alsoNet) {
-				element.setTagName("g");
+			if (m_indexedShortcuts) {
+				indexTraceClearance(netIndex, layerSpec, order, bundles, vias, jumperItems);
 			}
+			else {
+				fastCopy(m_boardImage, m_spareImage);
+
+				QDomDocument * masterDoc = m_masterDocs.value(layerSpec);
+				//QString before = masterDoc->toString();
+				Markers markers;
+				initMarkers(markers, m_pcbType);
+				NetElements netElements;
+				DRC::splitNetPrep(masterDoc, *(net->net), markers, netElements.net, netElements.alsoNet, netElements.notNet, true);
+				Q_FOREACH (QDomElement element, netElements.net) {
+					element.setTagName("g");
+				}
+				Q_FOREACH (QDomElement element, netElements.alsoNet) {
+					element.setTagName("g");
+				}
 
-			ItemBase::renderOne(masterDoc, m_spareImage, r2);
+				ItemBase::renderOne(masterDoc, m_spareImage, r2);
 
-			//QString after = masterDoc->toString();
+				//QString after = masterDoc->toString();
 
-			Q_FOREACH (QDomElement element, netElements.net) {
-				element.setTagName(element.attribute("former"));
-				element.removeAttribute("net");
-			}
-			Q_FOREACH (QDomElement element, netElements.alsoNet) {
-				element.setTagName(element.attribute("former"));
-				element.removeAttribute("net");
-			}
-			Q_FOREACH (QDomElement element, netElements.notNet) {
-				element.removeAttribute("net");
-			}
+				Q_FOREACH (QDomElement element, netElements.net) {
+					element.setTagName(element.attribute("former"));
+					element.removeAttribute("net");
+				}
+				Q_FOREACH (QDomElement element, netElements.alsoNet) {
+					element.setTagName(element.attribute("former"));
+					element.removeAttribute("net");
+				}
+				Q_FOREACH (QDomElement element, netElements.notNet) {
+					element.removeAttribute("net");
+				}
 
-			QPainter painter;
-			painter.begin(m_spareImage);
-			QPen pen = painter.pen();
-			pen.setColor(0xff000000);
+				QPainter painter;
+				painter.begin(m_spareImage);
+				QPen pen = painter.pen();
+				pen.setColor(0xff000000);
 
-			QBrush brush(QColor(0xff000000));
-			painter.setBrush(brush);
-			Q_FOREACH (int otherIndex, order) {
-				if (otherIndex == netIndex) continue;
+				QBrush brush(QColor(0xff000000));
+				painter.setBrush(brush);
+				Q_FOREACH (int otherIndex, order) {
+					if (otherIndex == netIndex) continue;
 
-				Q_FOREACH(QList< QPointer<TraceWire> > bundle, bundles.values(otherIndex)) {
-					if (bundle.count() == 0) continue;
-					if (ViewLayer::specFromID(bundle.at(0)->viewLayerID()) != layerSpec) continue;
+					Q_FOREACH(QList< QPointer<TraceWire> > bundle, bundles.values(otherIndex)) {
+						if (bundle.count() == 0) continue;
+						if (ViewLayer::specFromID(bundle.at(0)->viewLayerID()) != layerSpec) continue;
 
-					pen.setWidthF((bundle.at(0)->width() + m_keepoutPixels + m_keepoutPixels) * OptimizeFactor);
-					painter.setPen(pen);
-					Q_FOREACH (TraceWire * traceWire, bundle) {
-						if (traceWire == nullptr) continue;
+						pen.setWidthF((bundle.at(0)->width() + m_keepoutPixels + m_keepoutPixels) * OptimizeFactor);
+						painter.setPen(pen);
+						Q_FOREACH (TraceWire * traceWire, bundle) {
+							if (traceWire == nullptr) continue;
 
-						QPointF p1 = (traceWire->connector0()->sceneAdjustedTerminalPoint(nullptr) - topLeft) * OptimizeFactor;
-						QPointF p2 = (traceWire->connector1()->sceneAdjustedTerminalPoint(nullptr) - topLeft) * OptimizeFactor;
-						painter.drawLine(p1, p2);
+							QPointF p1 = (traceWire->connector0()->sceneAdjustedTerminalPoint(nullptr) - topLeft) * OptimizeFactor;
+							QPointF p2 = (traceWire->connector1()->sceneAdjustedTerminalPoint(nullptr) - topLeft) * OptimizeFactor;
+							painter.drawLine(p1, p2);
+						}
 					}
-				}
 
-				painter.setPen(Qt::NoPen);
+					painter.setPen(Qt::NoPen);
 
-				Q_FOREACH (Via * via, vias.values(otherIndex)) {
-					QPointF p = (via->connectorItem()->sceneAdjustedTerminalPoint(nullptr) - topLeft) * OptimizeFactor;
-					double rad = ((via->connectorItem()->sceneBoundingRect().width() / 2) + m_keepoutPixels) * OptimizeFactor;
-					painter.drawEllipse(p, rad, rad);
-				}
-				Q_FOREACH (JumperItem * jumperItem, jumperItems.values(otherIndex)) {
-					QPointF p = (jumperItem->connector0()->sceneAdjustedTerminalPoint(nullptr) - topLeft) * OptimizeFactor;
-					double rad = ((jumperItem->connector0()->sceneBoundingRect().width() / 2) + m_keepoutPixels) * OptimizeFactor;
-					painter.drawEllipse(p, rad, rad);
-					p = (jumperItem->connector1()->sceneAdjustedTerminalPoint(nullptr) - topLeft) * OptimizeFactor;
-					painter.drawEllipse(p, rad, rad);
+					Q_FOREACH (Via * via, vias.values(otherIndex)) {
+						QPointF p = (via->connectorItem()->sceneAdjustedTerminalPoint(nullptr) - topLeft) * OptimizeFactor;
+						double rad = ((via->connectorItem()->sceneBoundingRect().width() / 2) + m_keepoutPixels) * OptimizeFactor;
+						painter.drawEllipse(p, rad, rad);
+					}
+					Q_FOREACH (JumperItem * jumperItem, jumperItems.values(otherIndex)) {
+						QPointF p = (jumperItem->connector0()->sceneAdjustedTerminalPoint(nullptr) - topLeft) * OptimizeFactor;
+						double rad = ((jumperItem->connector0()->sceneBoundingRect().width() / 2) + m_keepoutPixels) * OptimizeFactor;
+						painter.drawEllipse(p, rad, rad);
+						p = (jumperItem->connector1()->sceneAdjustedTerminalPoint(nullptr) - topLeft) * OptimizeFactor;
+						painter.drawEllipse(p, rad, rad);
+					}
+					Q_FOREACH (SymbolPaletteItem * netLabel, netLabels.values(otherIndex)) {
+						QRectF r = netLabel->sceneBoundingRect();
+						painter.drawRect((r.left() - topLeft.x() - m_keepoutPixels) * OptimizeFactor,
+						                 (r.top() - topLeft.y() - m_keepoutPixels) * OptimizeFactor,
+						                 (r.width() + m_keepoutPixels) * OptimizeFactor,
+						                 (r.height() + m_keepoutPixels) * OptimizeFactor);
+					}
 				}
-				Q_FOREACH (SymbolPaletteItem * netLabel, netLabels.values(otherIndex)) {
+
+				Q_FOREACH (SymbolPaletteItem * netLabel, netLabels.values(netIndex)) {
 					QRectF r = netLabel->sceneBoundingRect();
 					painter.drawRect((r.left() - topLeft.x() - m_keepoutPixels) * OptimizeFactor,
 					                 (r.top() - topLeft.y() - m_keepoutPixels) * OptimizeFactor,
 					                 (r.width() + m_keepoutPixels) * OptimizeFactor,
 					                 (r.height() + m_keepoutPixels) * OptimizeFactor);
 				}
-			}
 
-			Q_FOREACH (SymbolPaletteItem * netLabel, netLabels.values(netIndex)) {
-				QRectF r = netLabel->sceneBoundingRect();
-				painter.drawRect((r.left() - topLeft.x() - m_keepoutPixels) * OptimizeFactor,
-				                 (r.top() - topLeft.y() - m_keepoutPixels) * OptimizeFactor,
-				                 (r.width() + m_keepoutPixels) * OptimizeFactor,
-				                 (r.height() + m_keepoutPixels) * OptimizeFactor);
+				painter.end();
 			}
 
-			painter.end();
-
 #ifndef QT_NO_DEBUG
 			//m_spareImage->save(FolderUtils::getUserDataStorePath("") + QString("/optimizeObstacles%1_%2.png").arg(netIndex, 2, 10, QChar('0')).arg(layerSpec));
 #endif
@@ -3176,8 +4325,6 @@ void MazeRouter::optimizeTraces(QList<int> & order, QMultiHash<int, QList< QPoin
 }
 
 void MazeRouter::reducePoints(QList<QPointF> & points, QPointF topLeft, QList<TraceWire *> & bundle, int startIndex, int endIndex, ConnectionThing & connectionThing, int netIndex, ViewLayer::ViewLayerPlacement layerSpec) {
-	Q_UNUSED(netIndex);
-	Q_UNUSED(layerSpec);
 #ifndef QT_NO_DEBUG
 	//int inc = 0;
 #endif
@@ -3186,10 +4333,6 @@ void MazeRouter::reducePoints(QList<QPointF> & points, QPointF topLeft, QList<Tr
 		for (int ix = 0; ix < points.count() - separation; ix++) {
 			QPointF p1 = (points.at(ix) - topLeft) * OptimizeFactor;
 			QPointF p2 = (points.at(ix + separation) - topLeft) * OptimizeFactor;
-			double minX = qMax(0.0, qMin(p1.x(), p2.x()) - width);
-			double minY = qMax(0.0, qMin(p1.y(), p2.y()) - width);
-			double maxX = qMin(m_spareImage2->width() - 1.0, qMax(p1.x(), p2.x()) + width);
-			double maxY = qMin(m_spareImage2->height() - 1.0, qMax(p1.y(), p2.y()) + width);
 			int corners = 1;
 			if (!m_pcbType) {
 				if (qAbs(p1.x() - p2.x()) >= 1 && qAbs(p1.y() - p2.y()) >= 1) {
@@ -3198,39 +4341,49 @@ void MazeRouter::reducePoints(QList<QPointF> & points, QPointF topLeft, QList<Tr
 				}
 			}
 			for (int corner = 0; corner < corners; corner++) {
-				m_spareImage2->fill(0xffffffff);
-				QPainter painter;
-				painter.begin(m_spareImage2);
-				QPen pen = painter.pen();
-				pen.setColor(0xff000000);
-				pen.setWidthF(width);
-				painter.setPen(pen);
-				if (corners == 1) {
-					painter.drawLine(p1, p2);
+				bool overlaps = false;
+				if (m_indexedShortcuts) {
+					// pcb shortcuts are always straight (corners == 1)
+					overlaps = !shortcutClears(QLineF(points.at(ix), points.at(ix + separation)), bundle.at(0)->width() / 2, netIndex, layerSpec);
 				}
 				else {
-					if (corner == 0) {
-						// vertical then horizontal
-						painter.drawLine(p1.x(), p1.y(), p1.x(), p2.y());
-						painter.drawLine(p1.x(), p2.y(), p2.x(), p2.y());
+					double minX = qMax(0.0, qMin(p1.x(), p2.x()) - width);
+					double minY = qMax(0.0, qMin(p1.y(), p2.y()) - width);
+					double maxX = qMin(m_spareImage2->width() - 1.0, qMax(p1.x(), p2.x()) + width);
+					double maxY = qMin(m_spareImage2->height() - 1.0, qMax(p1.y(), p2.y()) + width);
+					m_spareImage2->fill(0xffffffff);
+					QPainter painter;
+					painter.begin(m_spareImage2);
+					QPen pen = painter.pen();
+					pen.setColor(0xff000000);
+					pen.setWidthF(width);
+					painter.setPen(pen);
+					if (corners == 1) {
+						painter.drawLine(p1, p2);
 					}
 					else {
-						// horizontal then vertical
-						painter.drawLine(p1.x(), p1.y(), p2.x(), p1.y());
-						painter.drawLine(p2.x(), p1.y(), p2.x(), p2.y());
+						if (corner == 0) {
+							// vertical then horizontal
+							painter.drawLine(p1.x(), p1.y(), p1.x(), p2.y());
+							painter.drawLine(p1.x(), p2.y(), p2.x(), p2.y());
+						}
+						else {
+							// horizontal then vertical
+							painter.drawLine(p1.x(), p1.y(), p2.x(), p1.y());
+							painter.drawLine(p2.x(), p1.y(), p2.x(), p2.y());
+						}
 					}
-				}
-				painter.end();
+					painter.end();
 #ifndef QT_NO_DEBUG
-				//m_spareImage2->save(FolderUtils::getUserDataStorePath("") + QString("/optimizeTrace%1_%2_%3.png").arg(netIndex,2,10,QChar('0')).arg(layerSpec).arg(inc++,3,10,QChar('0')));
+					//m_spareImage2->save(FolderUtils::getUserDataStorePath("") + QString("/optimizeTrace%1_%2_%3.png").arg(netIndex,2,10,QChar('0')).arg(layerSpec).arg(inc++,3,10,QChar('0')));
 #endif
 
-				bool overlaps = false;
-				for (int y = minY; y <= maxY && !overlaps; y++) {
-					for (int x = minX; x <= maxX && !overlaps; x++) {
-						if (m_spareImage->pixel(x, y) == 0xffffffff) continue;
-						if (m_spareImage2->pixel(x, y) == 0xffffffff) continue;
-						overlaps = true;
+					for (int y = minY; y <= maxY && !overlaps; y++) {
+						for (int x = minX; x <= maxX && !overlaps; x++) {
+							if (m_spareImage->pixel(x, y) == 0xffffffff) continue;
+							if (m_spareImage2->pixel(x, y) == 0xffffffff) continue;
+							overlaps = true;
+						}
 					}
 				}
 
@@ -3299,3 +4452,419 @@ void MazeRouter::reducePoints(QList<QPointF> & points, QPointF topLeft, QList<Tr
 		}
 	}
 }
+
+void MazeRouter::indexCopperClearance(NetList & netList, QMultiHash<int, QList< QPointer<TraceWire> > > & bundles, QMultiHash<int, Via *> & vias, QMultiHash<int, JumperItem *> & jumperItems) {
+	// everything on the board except what this run created, grown by the keepout; indexTraceClearance() covers the rest
+	QSet<ItemBase *> skip;
+	Q_FOREACH (QList< QPointer<TraceWire> > bundle, bundles) {
+		Q_FOREACH (TraceWire * traceWire, bundle) {
+			if (traceWire) skip.insert(traceWire);
+		}
+	}
+	Q_FOREACH (Via * via, vias) skip.insert(via);
+	Q_FOREACH (JumperItem * jumperItem, jumperItems) skip.insert(jumperItem);
+
+	QPen keepoutPen(Qt::black, 0, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
+	for (int z = 0; z < 2; z++) {
+		m_copperClearance[z].clear();
+		if (z == 1 && !m_bothSidesNow) break;
+
+		Q_FOREACH (const SceneCopper & copper, sceneCopper(netList, z, skip)) {
+			QPainterPath grown = GraphicsUtils::shapeFromPath(copper.path, keepoutPen, 2 * m_keepoutPixels, true);
+			Q_FOREACH (QPolygonF polygon, grown.toFillPolygons()) {
+				m_copperClearance[z].addPolygon(polygon, grown.fillRule(), copper.netIndex);
+			}
+		}
+	}
+
+	DebugDialog::debug(QString("optimize clearance: %1 + %2 copper polygons").arg(m_copperClearance[0].count()).arg(m_copperClearance[1].count()));
+}
+
+void MazeRouter::indexTraceClearance(int netIndex, ViewLayer::ViewLayerPlacement layerSpec, QList<int> & order, QMultiHash<int, QList< QPointer<TraceWire> > > & bundles,
+                                     QMultiHash<int, Via *> & vias, QMultiHash<int, JumperItem *> & jumperItems)
+{
+	// the other nets' traces as they are now, after their own optimization, plus their vias and jumpers
+	m_traceClearance.clear();
+	Q_FOREACH (int otherIndex, order) {
+		if (otherIndex == netIndex) continue;
+
+		Q_FOREACH (QList< QPointer<TraceWire> > bundle, bundles.values(otherIndex)) {
+			if (bundle.count() == 0 || bundle.at(0) == nullptr) continue;
+			if (ViewLayer::specFromID(bundle.at(0)->viewLayerID()) != layerSpec) continue;
+
+			double radius = (bundle.at(0)->width() / 2) + m_keepoutPixels;
+			Q_FOREACH (TraceWire * traceWire, bundle) {
+				if (traceWire == nullptr) continue;
+
+				m_traceClearance.addSegment(QLineF(traceWire->connector0()->sceneAdjustedTerminalPoint(nullptr), traceWire->connector1()->sceneAdjustedTerminalPoint(nullptr)), radius);
+			}
+		}
+
+		Q_FOREACH (Via * via, vias.values(otherIndex)) {
+			double radius = (via->connectorItem()->sceneBoundingRect().width() / 2) + m_keepoutPixels;
+			m_traceClearance.addCircle(via->connectorItem()->sceneAdjustedTerminalPoint(nullptr), radius);
+		}
+		Q_FOREACH (JumperItem * jumperItem, jumperItems.values(otherIndex)) {
+			double radius = (jumperItem->connector0()->sceneBoundingRect().width() / 2) + m_keepoutPixels;
+			m_traceClearance.addCircle(jumperItem->connector0()->sceneAdjustedTerminalPoint(nullptr), radius);
+			m_traceClearance.addCircle(jumperItem->connector1()->sceneAdjustedTerminalPoint(nullptr), radius);
+		}
+	}
+}
+
+bool MazeRouter::shortcutClears(const QLineF & line, double halfWidth, int netIndex, ViewLayer::ViewLayerPlacement layerSpec) {
+	if (!onBoard(line)) return false;
+	if (!m_traceClearance.clears(line, halfWidth)) return false;
+
+	int z = layerSpec == ViewLayer::NewBottom ? 0 : 1;
+	return m_copperClearance[z].clears(line, halfWidth, netIndex);
+}
+
+bool MazeRouter::onBoard(const QLineF & line) const {
+	// walk the line in half-cell steps; every cell it passes must have been open to the router
+	if (m_offBoard.isEmpty()) return true;
+
+	int rows = m_offBoard.size() / m_offBoardColumns;
+	int steps = qMax(1, qCeil(line.length() * 2 / m_gridPixels));
+	for (int i = 0; i <= steps; i++) {
+		QPointF p = line.pointAt((double) i / steps) - m_maxRect.topLeft();
+		int x = qFloor(p.x() / m_gridPixels);
+		int y = qFloor(p.y() / m_gridPixels);
+		if (x < 0 || y < 0 || x >= m_offBoardColumns || y >= rows) return false;
+		if (m_offBoard.testBit((y * m_offBoardColumns) + x)) return false;
+	}
+
+	return true;
+}
+
+void MazeRouter::snapshotConnectors(NetList & netList) {
+	m_connectorGeometry.clear();
+	m_netIDs.clear();
+	Q_FOREACH (Net * net, netList.nets) {
+		m_netIDs.append(DRC::netIDs(*(net->net)));
+
+		// the subnets may hold equal-potential connectors that are not on the net list itself
+		QList<ConnectorItem *> connectorItems(*(net->net));
+		Q_FOREACH (const QList<ConnectorItem *> & subnet, net->subnets) {
+			connectorItems.append(subnet);
+		}
+		Q_FOREACH (ConnectorItem * connectorItem, connectorItems) {
+			if (m_connectorGeometry.contains(connectorItem)) continue;
+
+			ConnectorGeometry g;
+			g.terminalPoint = connectorItem->sceneAdjustedTerminalPoint(nullptr);
+			g.sceneRect = connectorItem->sceneBoundingRect();
+			ItemBase * itemBase = connectorItem->attachedTo();
+			g.partRect = itemBase->sceneBoundingRect();
+			g.viewLayerID = connectorItem->attachedToViewLayerID();
+			g.crossLayer = connectorItem->getCrossLayerConnectorItem();
+			SvgIdLayer * svgIdLayer = connectorItem->connector()->fullPinInfo(itemBase->viewID(), itemBase->viewLayerID());
+			g.partID = QString::number(itemBase->id());
+			g.svgID = svgIdLayer->m_svgId;
+			g.terminalID = svgIdLayer->m_terminalId;
+			m_connectorGeometry.insert(connectorItem, g);
+		}
+	}
+}
+
+ConnectorGeometry MazeRouter::geometry(ConnectorItem * connectorItem) const {
+	return m_connectorGeometry.value(connectorItem);
+}
+
+void MazeRouter::createWorkers() {
+	// called on the GUI thread before the search starts, so the workers belong to it
+	for (int i = 0; i < m_workerCount; i++) {
+		auto * worker = new MazeRouter(this);
+		if (!worker->m_grid->allocated() || worker->m_spareImage->isNull()) {
+			DebugDialog::debug(QString("autorouter: out of memory for worker %1").arg(i));
+			delete worker;
+			break;
+		}
+		m_workers << worker;
+		m_stats.peakGridBytes += worker->m_grid->bytes();
+	}
+
+	m_workerCount = qMax(1, m_workers.count());
+}
+
+qint64 MazeRouter::gridBudget() const {
+	// the master grid and every batch worker's grid share the memory budget
+	int grids = m_workerCount > 1 ? m_workerCount + 1 : 1;
+	return m_memoryBudget / grids;
+}
+
+void MazeRouter::deleteWorkers() {
+	Q_FOREACH (MazeRouter * worker, m_workers) {
+		delete worker;
+	}
+	m_workers.clear();
+}
+
+int MazeRouter::routeBatch(NetList & netList, Score & currentScore, Score & bestScore, const QSizeF gridSize, QList<NetOrdering> & allOrderings, int run, int batchCount)
+{
+	// route allOrderings[run .. run + batchCount) at the same time, one ordering per worker, and return
+	// how many of them the serial loop would have got through. Each ordering is scored from scratch, which
+	// is what Score::setOrdering() leaves the serial loop with, against its own copy of allOrderings.
+	// OrderingQueue::merge() then replays the workers' move-backs in ordering order against the real list.
+
+	QVector<Score> scores(batchCount);
+	QVector< QList<NetOrdering> > orderings(batchCount);
+	for (int i = 0; i < batchCount; i++) {
+		scores[i].setOrdering(allOrderings.at(run + i));
+		scores[i].anyUnrouted = false;
+		orderings[i] = allOrderings;
+	}
+
+	QList< QFuture<bool> > futures;
+	for (int i = 0; i < batchCount; i++) {
+		MazeRouter * worker = m_workers.at(i);
+		worker->m_cancelled = m_cancelled.load();
+		worker->m_stopTracing = m_stopTracing.load();
+		worker->m_renderCache = m_renderCache;
+		Score * score = &scores[i];
+		QList<NetOrdering> * workerOrderings = &orderings[i];
+		futures << QtConcurrent::run([worker, &netList, score, gridSize, workerOrderings]() {
+			return worker->routeNets(netList, false, *score, gridSize, *workerOrderings);
+		});
+	}
+
+	bool running = true;
+	while (running) {
+		QThread::msleep(BatchPollInterval);
+		running = false;
+		for (int i = 0; i < batchCount; i++) {
+			m_workers.at(i)->m_cancelled = m_cancelled.load();
+			m_workers.at(i)->m_stopTracing = m_stopTracing.load();
+			if (!futures.at(i).isFinished()) running = true;
+		}
+	}
+
+	for (int i = 0; i < batchCount; i++) {
+		MazeRouter * worker = m_workers.at(i);
+		for (auto it = worker->m_renderCache.constBegin(); it != worker->m_renderCache.constEnd(); ++it) {
+			if (!m_renderCache.contains(it.key())) {
+				m_renderCache.insert(it.key(), it.value());
+			}
+		}
+		m_renderCacheHits += worker->m_renderCacheHits;
+		m_renderCacheMisses += worker->m_renderCacheMisses;
+		worker->m_renderCacheHits = worker->m_renderCacheMisses = 0;
+		m_corridorRoutes += worker->m_corridorRoutes;
+		m_corridorFallbacks += worker->m_corridorFallbacks;
+		worker->m_corridorRoutes = worker->m_corridorFallbacks = 0;
+		m_regionRoutes += worker->m_regionRoutes;
+		worker->m_regionRoutes = 0;
+		for (int step = 0; step < RegionSteps; step++) {
+			m_regionFallbacks[step] += worker->m_regionFallbacks.at(step);
+			worker->m_regionFallbacks[step] = 0;
+		}
+		m_budgetHits += worker->m_budgetHits;
+		worker->m_budgetHits = 0;
+		m_nodesExpanded += worker->m_nodesExpanded;
+		worker->m_nodesExpanded = 0;
+	}
+
+	if (m_cancelled || m_stopTracing) {
+		// the workers gave up part way, so there is nothing to replay
+		Q_FOREACH (const Score & score, scores) {
+			if (betterScore(score, bestScore)) {
+				bestScore = score;
+			}
+		}
+		currentScore = scores.last();
+		return 1;
+	}
+
+	auto reroute = [&](int i, Score & score) {
+		score = Score();
+		score.setOrdering(allOrderings.at(run + i));
+		routeNets(netList, false, score, gridSize, allOrderings);
+	};
+	auto keep = [&](const Score & score) {
+		currentScore = score;
+		if (betterScore(currentScore, bestScore)) {
+			bestScore = currentScore;
+		}
+		return bestScore.anyUnrouted;
+	};
+	return OrderingQueue::merge(scores, m_lookahead, allOrderings, reroute, keep);
+}
+
+QList<SceneCopper> MazeRouter::sceneCopper(NetList & netList, int z, const QSet<ItemBase *> & skip) {
+	// every piece of copper on one routing layer, straight from its scene shape, with the routed net it is on.
+	// Non-connector copper inside a part footprint is not modeled; copper items without
+	// connectors (logos and the like) are treated as their whole shape.
+
+	QHash<ConnectorItem *, int> netOf;
+	Q_FOREACH (Net * net, netList.nets) {
+		Q_FOREACH (ConnectorItem * connectorItem, *(net->net)) {
+			netOf.insert(connectorItem, net->id);
+			ConnectorItem * cross = connectorItem->getCrossLayerConnectorItem();
+			if (cross) netOf.insert(cross, net->id);
+		}
+	}
+
+	ViewGeometry::WireFlags skipFlags = (ViewGeometry::RatsnestFlag | ViewGeometry::NormalFlag | ViewGeometry::PCBTraceFlag | ViewGeometry::SchematicTraceFlag) ^ m_sketchWidget->getTraceFlag();
+
+	QList<SceneCopper> coppers;
+	auto addCopper = [&coppers](const QPainterPath & scenePath, int netIndex, const QList<ConnectorItem *> & connectorItems) {
+		SceneCopper copper;
+		copper.path = scenePath;
+		copper.netIndex = netIndex;
+		copper.connectorItems = connectorItems;
+		coppers.append(copper);
+	};
+
+	LayerList viewLayerIDs = m_sketchWidget->routingLayers(z == 0 ? ViewLayer::NewBottom : ViewLayer::NewTop);
+	Q_FOREACH (QGraphicsItem * item, m_sketchWidget->scene()->items(m_maxRect)) {
+		auto * itemBase = dynamic_cast<ItemBase *>(item);
+		if (itemBase == nullptr) continue;
+		if (itemBase->layerHidden() || !itemBase->isVisible()) continue;
+		if (!viewLayerIDs.contains(itemBase->viewLayerID())) continue;
+		if (skip.contains(itemBase->layerKinChief())) continue;
+
+		auto * pad = qobject_cast<Pad *>(itemBase);
+		if (pad && pad->copperBlocker()) continue;		// left out of the master documents as well
+
+		auto * wire = qobject_cast<TraceWire *>(itemBase);
+		if (wire) {
+			// a trace belongs to whichever routed net it touches
+			QList<ConnectorItem *> equi;
+			equi << wire->connector0();
+			ConnectorItem::collectEqualPotential(equi, m_bothSidesNow, skipFlags);
+			int netIndex = -1;
+			Q_FOREACH (ConnectorItem * connectorItem, equi) {
+				netIndex = netOf.value(connectorItem, -1);
+				if (netIndex >= 0) break;
+			}
+			QList<ConnectorItem *> ends;
+			ends << wire->connector0() << wire->connector1();
+			addCopper(wire->mapToScene(wire->shape()), netIndex, ends);
+			continue;
+		}
+
+		if (itemBase->cachedConnectorItems().isEmpty()) {
+			addCopper(itemBase->mapToScene(itemBase->shape()), -1, QList<ConnectorItem *>());
+			continue;
+		}
+
+		Q_FOREACH (ConnectorItem * connectorItem, itemBase->cachedConnectorItems()) {
+			QList<ConnectorItem *> self;
+			self << connectorItem;
+			addCopper(connectorItem->mapToScene(connectorItem->shape()), netOf.value(connectorItem, -1), self);
+		}
+	}
+
+	return coppers;
+}
+
+void MazeRouter::collectCopperShapes(NetList & netList) {
+	// rasterize the copper once per run, instead of rendering the master documents for every net in every round
+
+	QTransform toGrid = QTransform::fromTranslate(-m_maxRect.left(), -m_maxRect.top()) * QTransform::fromScale(1 / m_gridPixels, 1 / m_gridPixels);
+	QRect gridRect(0, 0, m_grid->x, m_grid->y);
+	QPen keepoutPen(Qt::black, 0, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
+
+	int cellCount = 0;
+	for (int z = 0; z < 2; z++) {
+		m_copperShapes[z].clear();
+		m_copperShapeIndex[z].clear();
+		if (z == 1 && !m_bothSidesNow) break;
+
+		Q_FOREACH (const SceneCopper & copper, sceneCopper(netList, z, QSet<ItemBase *>())) {
+			CopperShape copperShape;
+			copperShape.netIndex = copper.netIndex;
+			copperShape.footprint = rasterizePath(toGrid.map(copper.path), gridRect);
+			copperShape.obstacle = rasterizePath(toGrid.map(GraphicsUtils::shapeFromPath(copper.path, keepoutPen, 2 * m_keepoutPixels, true)), gridRect);
+			cellCount += copperShape.obstacle.count();
+			int index = m_copperShapes[z].count();
+			m_copperShapes[z].append(copperShape);
+			Q_FOREACH (ConnectorItem * connectorItem, copper.connectorItems) {
+				m_copperShapeIndex[z].insert(connectorItem, index);
+				ConnectorItem * cross = connectorItem->getCrossLayerConnectorItem();
+				if (cross) m_copperShapeIndex[z].insert(cross, index);
+			}
+		}
+	}
+
+	DebugDialog::debug(QString("autorouter copper shapes: %1 + %2, %3 obstacle cells").arg(m_copperShapes[0].count()).arg(m_copperShapes[1].count()).arg(cellCount));
+}
+
+void MazeRouter::rasterizeObstacles(int netIndex, int z) {
+	Q_FOREACH (const CopperShape & copperShape, m_copperShapes[z]) {
+		if (copperShape.netIndex >= 0 && copperShape.netIndex == netIndex) continue;
+
+		Q_FOREACH (QPoint p, copperShape.obstacle) {
+			m_grid->setAt(p.x(), p.y(), z, GridPartObstacle);
+		}
+	}
+}
+
+QList<QPoint> MazeRouter::rasterizeSubnet(QList<ConnectorItem *> & subnet, int z, GridValue value) {
+	QList<QPoint> points;
+	QSet<int> done;
+	Q_FOREACH (ConnectorItem * connectorItem, subnet) {
+		int index = m_copperShapeIndex[z].value(connectorItem, -1);
+		if (index < 0 || done.contains(index)) continue;
+
+		done.insert(index);
+		Q_FOREACH (QPoint p, m_copperShapes[z].at(index).footprint) {
+			if (m_grid->at(p.x(), p.y(), z) == value) continue;
+
+			m_grid->setAt(p.x(), p.y(), z, value);
+			points.append(p);
+		}
+	}
+
+	return points;
+}
+
+int MazeRouter::routeNegotiated(NetList & netList, Score & bestScore, const QSizeF gridSize, QList<NetOrdering> & allOrderings, int totalToRoute) {
+	// PathFinder-style: route every net against soft costs for cells other nets use, then make the cells
+	// that ended up shared more expensive and route everything again, until no cell is shared.
+	// bestScore only ever holds a legal result: nets still sharing cells are left out of it,
+	// so the usual final pass reroutes them against hard obstacles (and jumpers)
+	m_congestion = new CongestionMap(m_grid->x, m_grid->y, m_grid->z, m_keepoutGridInt, m_halfGridViaSize, m_halfGridJumperSize, m_bothSidesNow);
+	m_stats.peakGridBytes += (qint64) m_grid->x * m_grid->y * m_grid->z * (2 * sizeof(quint16) + sizeof(quint32));
+
+	Score score;
+	score.setOrdering(allOrderings.first());
+	double presentFactor = 1;
+	auto sharedCells = 0;
+	auto pass = 0;
+	while (pass < m_maxCycles) {
+		QString msg = tr("best so far: %1 of %2 routed").arg(bestScore.totalRoutedCount).arg(totalToRoute);
+		msg += tr(" with %n vias", "", bestScore.totalViaCount);
+		if (pass > 0) {
+			msg += " ";
+			msg += tr("(%n shared cells)", "", sharedCells);
+		}
+		Q_EMIT setProgressMessage(msg);
+		Q_EMIT setCycleMessage(tr("pass %1 of:").arg(pass + 1));
+		Q_EMIT setProgressValue(pass);
+
+		m_congestion->presentFactor = qMin(MaxPresentFactor, qRound(presentFactor));
+		score.anyUnrouted = false;
+		routeNets(netList, false, score, gridSize, allOrderings);
+		pass++;
+		if (m_cancelled || m_stopTracing) break;
+
+		QSet<int> shared = m_congestion->sharedNets(score, sharedCells);
+		Score legal = score;
+		Q_FOREACH (int netIndex, shared) {
+			removeNetTraces(legal, netIndex);
+			legal.anyUnrouted = true;
+		}
+		if (betterScore(legal, bestScore)) {
+			bestScore = legal;
+		}
+		DebugDialog::debug(QString("negotiated pass %1: %2 shared cells, %3 nets sharing, %4 routed").arg(pass).arg(sharedCells).arg(shared.count()).arg(legal.totalRoutedCount));
+		if (sharedCells == 0) break;		// anything still unrouted is blocked by parts, not by other nets
+
+		presentFactor *= PresentGrowth;
+	}
+
+	delete m_congestion;
+	m_congestion = nullptr;
+	return pass;
+}
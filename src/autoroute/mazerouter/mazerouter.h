@@ -22,6 +22,7 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 #define MAZEROUTER_H
 
 #include <QAction>
+#include <QBitArray>
 #include <QHash>
 #include <QVector>
 #include <QList>
@@ -32,24 +33,21 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 #include <QProgressDialog>
 #include <QUndoCommand>
 #include <QPointer>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QPainterPath>
 
 #include <queue>
 
 #include "../../viewlayer.h"
 #include "../autorouter.h"
+#include "../drc.h"
+#include "../clearanceindex.h"
+#include "gridqueue.h"
+#include "displaytiles.h"
+#include "orderingqueue.h"
 
-typedef quint64 GridValue;
-
-struct GridPoint {
-	int x, y, z;
-	GridValue baseCost = 0;
-	double qCost = 0.0;
-	uchar flags = 0;
-
-	bool operator<(const GridPoint&) const;
-	GridPoint(QPoint p, int zed) : x(p.x()), y(p.y()), z(zed) { }
-	constexpr GridPoint() : x(0), y(0), z(0) { }
-};
+class GridTiles;
 
 struct PointZ {
 	QPointF p;
@@ -78,10 +76,6 @@ struct Trace {
 	Trace() = default;
 };
 
-struct NetOrdering {
-	QList<int> order;
-};
-
 struct Score {
 	NetOrdering ordering;
 	QMultiHash<int, Trace> traces;
@@ -91,11 +85,31 @@ struct Score {
 	int totalViaCount = 0;
 	int reorderNet = -1;
 	bool anyUnrouted = false;
+	QSet<int> incompleteNets;		// routed, but with a connection left unrouted
 
 	Score() = default;
 	void setOrdering(const NetOrdering &);
 };
 
+struct AutorouteStats {
+	int connectionsToRoute = 0;
+	int connectionsRouted = 0;
+	int viaCount = 0;
+	int jumperCount = 0;
+	qint64 peakGridBytes = 0;	// master grid plus any worker grids alive at the same time
+	int gridTileSpills = 0;		// tiled grids: tiles written out to stay within the memory budget
+	qint64 nodesExpanded = 0;	// grid points popped and expanded by route(), all threads
+	qint64 makeMastersMs = 0;
+	qint64 routeMs = 0;			// the search: every routeNets() pass
+	qint64 createTracesMs = 0;	// not counting optimizeTraces()
+	qint64 optimizeTracesMs = 0;
+	int corridorRoutes = 0;			// connections first searched inside a coarse corridor
+	int corridorFallbacks = 0;		// ...that found no path there
+	int regionRoutes = 0;			// connections first searched inside a box around source and target
+	QVector<int> regionFallbacks;	// per box size: connections that found no path inside it and widened
+	int budgetHits = 0;				// connections given up after expanding their node budget
+};
+
 struct Nearest {
 	int i = 0, j = 0;
 	double distance = 0.0;
@@ -104,21 +118,70 @@ struct Nearest {
 };
 
 struct Grid {
+	enum Kind {
+		Dense,
+		Compact,
+		Tiled
+	};
+
 	/// @todo replace this with std::unique_ptr<GridValue[]>
 	GridValue * data = nullptr;
+	// compact backend: obstacles live in bit planes, everything else in a 32-bit cell
+	quint32 * cells = nullptr;
+	quint64 * planes = nullptr;
+	int planeWords = 0;
+	// tiled backend: 32-bit cells in tiles made on first write, within a memory budget
+	GridTiles * tiles = nullptr;
+	QHash<qint64, GridValue> overflow;		// compact and tiled: cells whose cost does not fit in 32 bits
 	int x = 0;
 	int y = 0;
 	int z = 0;
 
-	Grid(int x, int y, int layers);
+	Grid(int x, int y, int layers, Kind kind = Dense, qint64 budget = 0);
     ~Grid();
 
+	static Kind kindFor(int x, int y, int layers, qint64 budget);
+	Kind kind() const;
+	bool allocated() const;
+	qint64 bytes() const;
+	int tileSpills() const;
 	GridValue at(int x, int y, int z) const;
 	void setAt(int x, int y, int z, GridValue value);
 	QList<QPoint> init(int x, int y, int z, int width, int height, const QImage &, GridValue value, bool collectPoints);
 	QList<QPoint> init4(int x, int y, int z, int width, int height, const QImage *, GridValue value, bool collectPoints);
 	void clear();
 	void copy(int fromIndex, int toIndex);
+	QList<QRect> touched(int z) const;			// where cells may have changed since forgetTouched(): the whole layer unless tiled
+	void forgetTouched();
+};
+
+struct CongestionMap {
+	// negotiated congestion: present counts the nets whose traces (plus keepout) cover a cell,
+	// history accumulates on cells that were still shared at the end of an earlier pass
+	CongestionMap(int x, int y, int z, int keepout, int halfVia, int halfJumper, bool bothSides);
+
+	GridValue cost(int x, int y, int z) const;
+	void addNet(int netIndex, const QList<Trace> &);
+	void removeNet(int netIndex);
+	QSet<int> sharedNets(const Score &, int & sharedCells);
+
+	int presentFactor = 1;
+
+protected:
+	void stamp(QVector<int> & cells, int cx, int cy, int cz, int half);
+
+	int m_x;
+	int m_y;
+	int m_z;
+	int m_keepout;
+	int m_halfVia;
+	int m_halfJumper;
+	bool m_bothSides;
+	QVector<quint16> m_present;
+	QVector<quint16> m_history;
+	QVector<quint32> m_mark;
+	quint32 m_generation = 0;
+	QHash<int, QVector<int> > m_netCells;		// cells counted in m_present for each routed net
 };
 
 
@@ -128,13 +191,38 @@ struct NetElements {
 	QList<QDomElement> notNet;
 };
 
+struct CopperShape {
+	// grid cells covered by a piece of copper, rasterized once per autoroute run
+	QVector<QPoint> footprint;
+	QVector<QPoint> obstacle;		// footprint grown by the keepout
+	int netIndex = -1;				// -1: not on any net being routed, so always an obstacle
+};
+
+struct ConnectorGeometry {
+	// what the search needs from a connector, read from the scene before the search starts
+	QPointF terminalPoint;			// sceneAdjustedTerminalPoint()
+	QRectF sceneRect;
+	QRectF partRect;				// the part it is attached to
+	ViewLayer::ViewLayerID viewLayerID = ViewLayer::UnknownLayer;		// attachedToViewLayerID()
+	ConnectorItem * crossLayer = nullptr;
+	QString partID;					// the part's id(), as the master docs have it
+	QString svgID;					// fullPinInfo() in the part's view and layer
+	QString terminalID;
+};
+
+struct SceneCopper {
+	QPainterPath path;				// scene coordinates
+	int netIndex = -1;				// -1: not on any net being routed
+	QList<ConnectorItem *> connectorItems;
+};
+
 struct RouteThing {
 	QRectF r;
 	QRectF r4;
 	QList<ViewLayer::ViewLayerPlacement> layerSpecs;
 	Nearest nearest;
-	std::priority_queue<GridPoint> sourceQ;
-	std::priority_queue<GridPoint> targetQ;
+	GridQueue sourceQ;
+	GridQueue targetQ;
 	QPoint gridSourcePoint;
 	QPoint gridTargetPoint;
 	GridValue sourceValue;
@@ -146,6 +234,10 @@ struct RouteThing {
 	bool unrouted;
 	NetElements netElements[2];
 	QSet<int> avoids;
+	QBitArray corridor;		// coarse tiles route() may expand into; empty means the whole board
+	int corridorColumns = 0;
+	QRect region;			// cells route() may expand into; empty means the whole board
+	bool overBudget = false;
 };
 
 struct TraceThing {
@@ -169,6 +261,12 @@ struct ConnectionThing {
 	QList<ConnectorItem *> values(ConnectorItem * s);
 };
 
+struct RouteResult {
+	// what the routing thread hands back to start(): traces in grid coordinates, no scene items yet
+	Score bestScore;
+	int rounds = 0;
+};
+
 typedef bool (*JumperWillFitFunction)(GridPoint &, const Grid *, int halfSize);
 typedef double (*CostFunction)(const QPoint & p1, const QPoint & p2);
 
@@ -183,18 +281,26 @@ public:
 	~MazeRouter();
 
 	void start();
+	void setRunLimits(int maxCycles, bool bothSides);
+	void setIncremental(bool);
+	const AutorouteStats & stats() const;
 
 protected:
 	void setUpWidths(double width);
 	int findPinsWithin(QList<ConnectorItem *> * net);
 	bool makeBoard(QImage *, double keepout, const QRectF & r);
 	bool makeMasters(QString &);
+	void search(RouteResult &, NetList &, const QSizeF gridSize, const NetOrdering & initialOrdering, int totalToRoute);
 	bool routeNets(NetList &, bool makeJumper, Score & currentScore, const QSizeF gridSize, QList<NetOrdering> & allOrderings);
 	bool routeOne(bool makeJumper, Score & currentScore, int netIndex, RouteThing &, QList<NetOrdering> & allOrderings);
 	void findNearestPair(QList< QList<ConnectorItem *> > & subnets, Nearest &);
 	void findNearestPair(QList< QList<ConnectorItem *> > & subnets, int i, QList<ConnectorItem *> & inet, Nearest &);
 	QList<QPoint> renderSource(QDomDocument * masterDoc, int z, ViewLayer::ViewLayerPlacement, Grid * grid, QList<QDomElement> & netElements, QList<ConnectorItem *> & subnet, GridValue value, bool clearElements, const QRectF & r);
 	QList<GridPoint> route(RouteThing &, int & viaCount);
+	bool makeCorridor(RouteThing &);
+	int tileCost(int column, int row);
+	QRect searchRegion(RouteThing &, int step);
+	void undoExpansion(Grid * grid, const QRect & area = QRect());
 	void expand(GridPoint &, RouteThing &);
 	void expandOne(GridPoint &, RouteThing &, int dx, int dy, int dz, bool crossLayer);
 	bool viaWillFit(GridPoint &, Grid * grid);
@@ -212,30 +318,61 @@ protected:
 	void traceAvoids(QList<Trace> & traces, int netIndex, RouteThing & routeThing);
 	bool routeNext(bool makeJumper, RouteThing &, QList< QList<ConnectorItem *> > & subnets, Score & currentScore, int netIndex, QList<NetOrdering> & allOrderings);
 	void cleanUpNets(NetList &);
-	void createTraces(NetList & netList, Score & bestScore, QUndoCommand * parentCommand);
+	void createTraces(NetList & netList, Score & bestScore, AutorouteResultCommand * resultCommand);
 	void createTrace(Trace &, QList<GridPoint> &, TraceThing &, ConnectionThing &, Net *);
 	void removeColinear(QList<GridPoint> & gridPoints);
 	void removeSteps(QList<GridPoint> & gridPoints);
 	void removeStep(int ix, QList<GridPoint> & gridPoints);
 	ConnectorItem * findAnchor(GridPoint gp, TraceThing &, Net * net, QPointF & p, bool & onTrace, ConnectorItem * already);
 	ConnectorItem * findAnchor(GridPoint gp, const QRectF &, TraceThing &, Net * net, QPointF & p, bool & onTrace, ConnectorItem * already);
-	void addConnectionToUndo(ConnectorItem * from, ConnectorItem * to, QUndoCommand * parentCommand);
-	void addViaToUndo(Via *, QUndoCommand * parentCommand);
-	void addJumperToUndo(JumperItem *, QUndoCommand * parentCommand);
+	void addConnectionToUndo(ConnectorItem * from, ConnectorItem * to, AutorouteResultCommand * resultCommand);
+	void addViaToUndo(Via *, AutorouteResultCommand * resultCommand);
+	void addJumperToUndo(JumperItem *, AutorouteResultCommand * resultCommand);
 	void routeJumper(int netIndex, RouteThing &, Score & currentScore);
 	void insertTrace(Trace & newTrace, int netIndex, Score & currentScore, int viaCount, bool incRouted);
 	SymbolPaletteItem * makeNetLabel(GridPoint & center, SymbolPaletteItem * pairedNetLabel, uchar traceFlags);
-	void addNetLabelToUndo(SymbolPaletteItem * netLabel, QUndoCommand * parentCommand);
+	void addNetLabelToUndo(SymbolPaletteItem * netLabel, AutorouteResultCommand * resultCommand);
 	GridPoint lookForJumper(GridPoint initial, GridValue targetValue, QPoint targetLocation);
 	void expandOneJ(GridPoint & gridPoint, std::priority_queue<GridPoint> & pq, int dx, int dy, int dz, GridValue targetValue, QPoint targetLocation, QSet<int> & already);
 	void removeOffBoardAnd(bool isPCBType, bool removeSingletons, bool bothSides);
 	void optimizeTraces(QList<int> & order, QMultiHash<int, QList< QPointer<TraceWire> > > &, QMultiHash<int, Via *> &, QMultiHash<int, JumperItem *> &, QMultiHash<int, SymbolPaletteItem *> &, NetList &, ConnectionThing &);
 	void reducePoints(QList<QPointF> & points, QPointF topLeft, QList<TraceWire *> & bundle, int startIndex, int endIndex, ConnectionThing &, int netIndex, ViewLayer::ViewLayerPlacement);
+	void indexCopperClearance(NetList &, QMultiHash<int, QList< QPointer<TraceWire> > > &, QMultiHash<int, Via *> &, QMultiHash<int, JumperItem *> &);
+	void indexTraceClearance(int netIndex, ViewLayer::ViewLayerPlacement, QList<int> & order, QMultiHash<int, QList< QPointer<TraceWire> > > &, QMultiHash<int, Via *> &, QMultiHash<int, JumperItem *> &);
+	bool shortcutClears(const QLineF &, double halfWidth, int netIndex, ViewLayer::ViewLayerPlacement);
+	bool onBoard(const QLineF &) const;
+	int routeBatch(NetList &, Score & currentScore, Score & bestScore, const QSizeF gridSize, QList<NetOrdering> & allOrderings, int run, int batchCount);
+	void snapshotConnectors(NetList &);
+	ConnectorGeometry geometry(ConnectorItem *) const;
+	void createWorkers();
+	void deleteWorkers();
+	qint64 gridBudget() const;
+	QList<SceneCopper> sceneCopper(NetList &, int z, const QSet<ItemBase *> & skip);
+	void collectCopperShapes(NetList &);
+	void rasterizeObstacles(int netIndex, int z);
+	QList<QPoint> rasterizeSubnet(QList<ConnectorItem *> & subnet, int z, GridValue value);
+	int routeNegotiated(NetList &, Score & bestScore, const QSizeF gridSize, QList<NetOrdering> & allOrderings, int totalToRoute);
+	bool startRun();
+	void releaseRun();
+	QSet<ItemBase *> autoroutedItems(QList<ConnectorItem *> * net);
+	QSet<ItemBase *> ripUpItems();
+	void addRipUpAnchor(QList<ConnectorItem *> * net);
+	void findChangedNets();
+	bool widenRipUp(NetList &, const Score & bestScore);
+
+protected:
+	MazeRouter(const MazeRouter * master);    // worker copy used by routeBatch()
 
 public Q_SLOTS:
 	void incCommandProgress();
 	void setMaxCycles(int);
 
+protected Q_SLOTS:
+	void showDisplay(int iz, bool reset, const DisplayTileImages &);
+
+Q_SIGNALS:
+	void displaySnapshot(int iz, bool reset, const DisplayTileImages &);
+
 protected:
 	LayerList m_viewLayerIDs;
 	QHash<ViewLayer::ViewLayerPlacement, QDomDocument *> m_masterDocs;
@@ -246,11 +383,11 @@ protected:
 	int m_halfGridJumperSize;
 	double m_gridPixels;
 	double m_standardWireWidth;
-	QImage * m_displayImage[2] = { nullptr, nullptr };
+	DisplayTiles * m_displayTiles[2] = { nullptr, nullptr };
 	QImage * m_boardImage;
 	QImage * m_spareImage;
 	QImage * m_spareImage2;
-	QGraphicsPixmapItem * m_displayItem[2] = { nullptr, nullptr };
+	DisplayTilesItem * m_displayItem[2] = { nullptr, nullptr };
 	bool m_temporaryBoard;
 	CostFunction m_costFunction;
 	JumperWillFitFunction m_jumperWillFitFunction;
@@ -259,6 +396,41 @@ protected:
 	int m_cleanupCount;
 	int m_netLabelIndex;
 	int m_commandCount;
+	int m_workerCount;
+	int m_lookahead;
+	GridQueue::Kind m_queueKind;
+	QList<MazeRouter *> m_workers;
+	AutorouteStats m_stats;
+	QHash<QByteArray, QList<QPoint> > m_renderCache;		// init4() points per (subnet, layer)
+	int m_renderCacheHits = 0;
+	int m_renderCacheMisses = 0;
+	bool m_geometryRaster = false;
+	bool m_indexedShortcuts = false;
+	QList<CopperShape> m_copperShapes[2];
+	QHash<ConnectorItem *, int> m_copperShapeIndex[2];		// connector -> index into m_copperShapes
+	QHash<ConnectorItem *, ConnectorGeometry> m_connectorGeometry;
+	QList<NetIDs> m_netIDs;			// DRC::netIDs() of each net, by net index
+	bool m_negotiated = false;
+	CongestionMap * m_congestion = nullptr;		// only while routeNegotiated() runs
+	bool m_corridors = false;
+	QElapsedTimer m_displayTimer[2];
+	int m_corridorRoutes = 0;
+	int m_corridorFallbacks = 0;
+	bool m_regions = false;
+	int m_regionRoutes = 0;
+	QVector<int> m_regionFallbacks;
+	int m_nodeBudgetPercent = 0;			// of the grid's cells, 0 for no budget
+	qint64 m_nodeBudget = 0;				// per connection
+	int m_budgetHits = 0;
+	qint64 m_memoryBudget = 0;				// bytes for all the grids of a run, 0 for no limit
+	qint64 m_nodesExpanded = 0;
+	ClearanceIndex m_copperClearance[2];		// optimizeTraces(): part copper and kept traces, per layer
+	ClearanceIndex m_traceClearance;			// optimizeTraces(): the other nets' new traces, vias and jumpers
+	QBitArray m_offBoard;						// routing-grid cells off the board or inside its keepout
+	int m_offBoardColumns = 0;
+	bool m_incremental = false;
+	int m_ripUpRound = 0;
+	QList<ConnectorItem *> m_ripUpAnchors;		// incremental runs: one part connector of each net to rip up
 };
 
 #endif
@@ -0,0 +1,57 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+#include "orderingqueue.h"
+
+#include <QtGlobal>
+
+bool OrderingQueue::contains(const QList<NetOrdering> & allOrderings, const QList<int> & order) {
+	Q_FOREACH (NetOrdering ordering, allOrderings) {
+		if (ordering.order == order) return true;
+	}
+
+	return false;
+}
+
+int OrderingQueue::moveBack(const QList<int> & order, int index, int lookahead, QList<NetOrdering> & allOrderings) {
+	if (index <= 0) {
+		return 0;  // nowhere to move back to
+	}
+
+	QList<int> moved(order);
+	int netIndex = moved.takeAt(index);
+	int queued = 0;
+	for (int i = index - 1; i >= 0 && queued < lookahead; i--) {
+		moved.insert(i, netIndex);
+		if (!contains(allOrderings, moved)) {
+			NetOrdering newOrdering;
+			newOrdering.order = moved;
+			allOrderings.append(newOrdering);
+			queued++;
+		}
+		moved.removeAt(i);
+	}
+
+	return queued;
+}
+
+int OrderingQueue::batchCount(int run, int maxCycles, int queued, int workers) {
+	return qMin(workers, qMin(maxCycles, queued) - run);
+}
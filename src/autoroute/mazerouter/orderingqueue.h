@@ -0,0 +1,67 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+#ifndef ORDERINGQUEUE_H
+#define ORDERINGQUEUE_H
+
+#include <QList>
+#include <QVector>
+
+struct NetOrdering {
+	QList<int> order;
+};
+
+// The net orderings MazeRouter::search() tries, in the order it tries them.  When a net cannot be
+// routed, moveBack() queues the ordering with that net moved to the nearest earlier place not tried
+// yet; with a lookahead of more than one it also queues the places after that.  Those queued orderings
+// are what the batch workers route at the same time.  merge() then replays the workers' move-backs in
+// queue order, so the queue and the best score come out as they do routing one ordering at a time.
+
+class OrderingQueue
+{
+public:
+	static bool contains(const QList<NetOrdering> &, const QList<int> & order);
+	// queues up to lookahead orderings with order[index] moved earlier and returns how many
+	static int moveBack(const QList<int> & order, int index, int lookahead, QList<NetOrdering> & allOrderings);
+	// how many queued orderings from run on can be routed at the same time
+	static int batchCount(int run, int maxCycles, int queued, int workers);
+
+	// scores[i] is allOrderings[run + i] routed against a copy of allOrderings.  A score that stopped at
+	// reorderNet has its move-back replayed here; when the net has nowhere new to go, the serial loop
+	// would have kept routing, so reroute(i, score) does that.  keep(score) takes each score in turn
+	// and returns false where the serial loop would stop.  Returns how many scores were taken.
+	template <typename Score, typename Reroute, typename Keep>
+	static int merge(QVector<Score> & scores, int lookahead, QList<NetOrdering> & allOrderings, Reroute reroute, Keep keep) {
+		for (int i = 0; i < scores.count(); i++) {
+			Score & score = scores[i];
+			if (score.reorderNet >= 0) {
+				int index = score.ordering.order.indexOf(score.reorderNet);
+				if (moveBack(score.ordering.order, index, lookahead, allOrderings) == 0) {
+					reroute(i, score);
+				}
+			}
+			if (!keep(score)) return i + 1;
+		}
+
+		return scores.count();
+	}
+};
+
+#endif
@@ -0,0 +1,57 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+#include "searchstages.h"
+
+SearchStages::SearchStages(qint64 nodeBudget, bool bounded) :
+	m_nodeBudget(nodeBudget),
+	m_bounded(bounded)
+{
+}
+
+bool SearchStages::expand() {
+	m_expanded++;
+	if (m_nodeBudget <= 0 || ++m_stageExpanded < m_nodeBudget) return true;
+
+	if (!m_bounded) m_overBudget = true;
+	return false;
+}
+
+void SearchStages::widen(bool bounded) {
+	m_bounded = bounded;
+	m_stage++;
+	m_stageExpanded = 0;
+}
+
+bool SearchStages::bounded() const {
+	return m_bounded;
+}
+
+bool SearchStages::overBudget() const {
+	return m_overBudget;
+}
+
+int SearchStages::stage() const {
+	return m_stage;
+}
+
+qint64 SearchStages::expanded() const {
+	return m_expanded;
+}
@@ -0,0 +1,52 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+#ifndef SEARCHSTAGES_H
+#define SEARCHSTAGES_H
+
+#include <QtGlobal>
+
+// The node budget of one connection in MazeRouter::route().  The search widens in stages: the
+// coarse corridor, then boxes around source and target, then the whole board.  Every stage starts
+// over from the seeds and gets the whole budget, so a bounded stage that runs out only widens the
+// search; the connection is given up only when the whole board runs out.
+
+class SearchStages
+{
+public:
+	SearchStages(qint64 nodeBudget, bool bounded);
+
+	bool expand();						// counts one node; false once this stage has spent the budget
+	void widen(bool bounded);			// on to the next stage, which counts from zero
+	bool bounded() const;
+	bool overBudget() const;			// the whole board ran out of budget
+	int stage() const;
+	qint64 expanded() const;			// over all stages
+
+protected:
+	qint64 m_nodeBudget = 0;
+	bool m_bounded = false;
+	int m_stage = 0;
+	qint64 m_stageExpanded = 0;
+	qint64 m_expanded = 0;
+	bool m_overBudget = false;
+};
+
+#endif
@@ -0,0 +1,75 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+#include "pixelscan.h"
+
+#include <QtEndian>
+
+#include <cstring>
+
+static constexpr int WordBits = 64;
+
+static inline quint64 wordAt(const uchar * line, int word, int bytesPerLine) {
+	// big endian, so the leftmost pixel is the top bit, as it is in its byte
+	int offset = word * (WordBits / 8);
+	if (offset + (WordBits / 8) <= bytesPerLine) return qFromBigEndian<quint64>(line + offset);
+
+	// QImage only pads scanlines to 32 bits; what is past the end counts as white
+	uchar tail[WordBits / 8];
+	memset(tail, 0xff, sizeof(tail));
+	memcpy(tail, line + offset, bytesPerLine - offset);
+	return qFromBigEndian<quint64>(tail);
+}
+
+int PixelScan::collisions(const uchar * line1, const uchar * line2, int bytesPerLine, int x1, int x2, uchar * display, uchar clr, int * xs, int maxXs, bool firstHit) {
+	if (x1 >= x2) return 0;
+
+	int count = 0;
+	int firstWord = x1 / WordBits;
+	int lastWord = (x2 - 1) / WordBits;
+	for (int word = firstWord; word <= lastWord; word++) {
+		quint64 bits = ~wordAt(line1, word, bytesPerLine) & ~wordAt(line2, word, bytesPerLine);
+		if (word == firstWord) bits &= ~Q_UINT64_C(0) >> (x1 % WordBits);
+		if (word == lastWord) bits &= ~Q_UINT64_C(0) << (WordBits - 1 - ((x2 - 1) % WordBits));
+		if (bits == 0) continue;
+
+		int base = word * WordBits;
+		if (firstHit) {
+			int x = base + qCountLeadingZeroBits(bits);
+			if (display) display[x] = clr;
+			if (maxXs > 0) xs[0] = x;
+			return 1;
+		}
+
+		// a run of colliding pixels at a time, so the display is written with memset
+		while (bits != 0) {
+			int lead = qCountLeadingZeroBits(bits);
+			int run = qMin((int) qCountLeadingZeroBits((quint64) ~(bits << lead)), WordBits - lead);
+			if (display) memset(display + base + lead, clr, run);
+			for (int i = 0; i < run && count + i < maxXs; i++) {
+				xs[count + i] = base + lead + i;
+			}
+			count += run;
+			bits &= run == WordBits ? 0 : ~(((Q_UINT64_C(1) << run) - 1) << (WordBits - lead - run));
+		}
+	}
+
+	return count;
+}
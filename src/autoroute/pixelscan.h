@@ -0,0 +1,40 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+#ifndef PIXELSCAN_H
+#define PIXELSCAN_H
+
+#include <QtGlobal>
+
+// The collision test of the DRC.  The net and the keepout-widened rest of the board are rendered
+// into two Format_Mono images (MSB first, white is 1) and a pixel collides where both are black.
+// collisions() takes one scanline of each and ANDs their inverses a 64-bit word at a time,
+// skipping empty words and finding the colliding pixels of the others by counting leading zeros.
+
+class PixelScan
+{
+public:
+	// looks at the pixels in [x1, x2); marks each colliding one with clr in display, an Indexed8
+	// scanline (when not null), writes the x of the first maxXs of them to xs and returns how many
+	// there are.  With firstHit it stops at the first one, so the answer is 0 or 1.
+	static int collisions(const uchar * line1, const uchar * line2, int bytesPerLine, int x1, int x2, uchar * display, uchar clr, int * xs, int maxXs, bool firstHit);
+};
+
+#endif
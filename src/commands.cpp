@@ -2335,6 +2335,146 @@ QString PackItemsCommand::getParamString() const {
 	       ;
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+AutorouteResultCommand::AutorouteResultCommand(SketchWidget * sketchWidget, QUndoCommand * parent)
+	: SimulationCommand(BaseCommand::CrossView, sketchWidget, parent)
+{
+}
+
+AutorouteResultCommand::~AutorouteResultCommand()
+{
+	if (m_checkSticky) {
+		delete m_checkSticky;
+	}
+}
+
+void AutorouteResultCommand::addItem(const Item & item) {
+	m_items.append(item);
+}
+
+void AutorouteResultCommand::addConnection(const Connection & connection) {
+	m_connections.append(connection);
+}
+
+int AutorouteResultCommand::count() const {
+	return m_items.count() + m_connections.count();
+}
+
+void AutorouteResultCommand::undo()
+{
+	// the reverse of redo(); the properties go with the items
+	SuspendedViews suspended = suspendUpdates();
+	for (int i = m_connections.count() - 1; i >= 0; i--) {
+		const Connection & connection = m_connections.at(i);
+		m_sketchWidget->changeConnection(connection.fromID, connection.fromConnectorID, connection.toID, connection.toConnectorID, connection.viewLayerPlacement, false, true, false);
+		stepProgress(false);
+	}
+	if (m_checkSticky) {
+		m_checkSticky->undo();
+	}
+	for (int i = m_items.count() - 1; i >= 0; i--) {
+		m_sketchWidget->deleteItemForCommand(m_items.at(i).id, true, true, false);
+		stepProgress(false);
+	}
+	resumeUpdates(suspended);
+	SimulationCommand::undo();
+}
+
+void AutorouteResultCommand::redo()
+{
+	SuspendedViews suspended = suspendUpdates();
+	Q_FOREACH (const Item & item, m_items) {
+		m_sketchWidget->addItemForCommand(item.moduleID, item.viewLayerPlacement, BaseCommand::CrossView, item.viewGeometry, item.id, -1, nullptr);
+		if (!item.prop.isEmpty()) {
+			m_sketchWidget->setProp(item.id, item.prop, item.propValue, true, true);
+		}
+		if (item.resizeJumper) {
+			m_sketchWidget->resizeJumperItem(item.id, item.jumperPos, item.jumperC0, item.jumperC1);
+		}
+		if (item.wireWidth > 0) {
+			m_sketchWidget->changeWireWidthForCommand(item.id, item.wireWidth);
+			m_sketchWidget->changeWireColorForCommand(item.id, item.wireColor, item.wireOpacity);
+		}
+		stepProgress(true);
+	}
+
+	if (m_checkSticky) {
+		m_checkSticky->redo();
+	}
+	else {
+		// the first time through, collect what sticks to what for all the items in one CheckStickyCommand
+		Q_FOREACH (const Item & item, m_items) {
+			if (!item.checkSticky) continue;
+
+			if (m_checkSticky == nullptr) {
+				m_checkSticky = new CheckStickyCommand(m_sketchWidget, BaseCommand::SingleView, item.id, false, CheckStickyCommand::RemoveOnly, nullptr);
+				m_checkSticky->redo();
+			}
+			else {
+				m_sketchWidget->checkStickyForCommand(item.id, false, false, m_checkSticky);
+			}
+		}
+	}
+
+	Q_FOREACH (const Connection & connection, m_connections) {
+		m_sketchWidget->changeConnection(connection.fromID, connection.fromConnectorID, connection.toID, connection.toConnectorID, connection.viewLayerPlacement, true, true, false);
+		stepProgress(true);
+	}
+	resumeUpdates(suspended);
+	SimulationCommand::redo();
+}
+
+QList<SketchWidget *> AutorouteResultCommand::sketchWidgets() {
+	auto * mainWindow = dynamic_cast<MainWindow *>(m_sketchWidget->nativeParentWidget());
+	if (mainWindow) return mainWindow->sketchWidgets();
+
+	QList<SketchWidget *> sketchWidgets;
+	sketchWidgets << m_sketchWidget;
+	return sketchWidgets;
+}
+
+AutorouteResultCommand::SuspendedViews AutorouteResultCommand::suspendUpdates() {
+	// items are added in every view, so each view repaints once after the batch rather than after every item
+	SuspendedViews suspended;
+	Q_FOREACH (SketchWidget * sketchWidget, sketchWidgets()) {
+		sketchWidget->setIgnoreSelectionChangeEvents(true);
+		suspended.ignoring << sketchWidget;
+		if (sketchWidget->updatesEnabled()) {
+			sketchWidget->setUpdatesEnabled(false);
+			suspended.repainting << sketchWidget;
+		}
+	}
+	return suspended;
+}
+
+void AutorouteResultCommand::resumeUpdates(const SuspendedViews & suspended) {
+	// only undo what suspendUpdates() did, so a view the caller already set to ignore selection changes
+	// (MainWindow::autoroute does, around the whole run) keeps ignoring them
+	Q_FOREACH (SketchWidget * sketchWidget, suspended.ignoring) {
+		sketchWidget->setIgnoreSelectionChangeEvents(false);
+	}
+	Q_FOREACH (SketchWidget * sketchWidget, suspended.repainting) {
+		sketchWidget->setUpdatesEnabled(true);
+	}
+}
+
+void AutorouteResultCommand::stepProgress(bool redo) {
+	// one step per item or connection, as when each was a command of its own
+	if (!m_commandProgress.active()) return;
+
+	if (redo) m_commandProgress.emitRedo();
+	else m_commandProgress.emitUndo();
+}
+
+QString AutorouteResultCommand::getParamString() const {
+	return QString("AutorouteResultCommand ")
+	       + BaseCommand::getParamString() +
+	       QString(" items:%1 connections:%2")
+	       .arg(m_items.count())
+	       .arg(m_connections.count());
+}
+
 ////////////////////////////////////
 
 TemporaryCommand::TemporaryCommand(const QString & text) : QUndoCommand(text), m_enabled(true) { }
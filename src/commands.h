@@ -23,6 +23,7 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QUndoCommand>
 #include <QHash>
+#include <QVector>
 #include <QPainterPath>
 
 #include "viewgeometry.h"
@@ -1220,4 +1221,66 @@ protected:
 
 /////////////////////////////////////////////
 
+class AutorouteResultCommand : public SimulationCommand
+{
+	// everything an autorouter run adds: the new traces, vias, jumpers and net labels, then their connections,
+	// kept as flat lists and applied or removed as one batch, with the views' updates suspended meanwhile
+
+public:
+	struct Item {
+		QString moduleID;
+		ViewLayer::ViewLayerPlacement viewLayerPlacement = ViewLayer::NewTop;
+		ViewGeometry viewGeometry;
+		long id = 0;
+		bool checkSticky = false;
+		double wireWidth = 0;			// traces only
+		QString wireColor;
+		double wireOpacity = 1;
+		QString prop;					// "hole size" for vias, "label" for net labels
+		QString propValue;
+		bool resizeJumper = false;
+		QPointF jumperPos;
+		QPointF jumperC0;
+		QPointF jumperC1;
+	};
+
+	struct Connection {
+		long fromID = 0;
+		QString fromConnectorID;
+		long toID = 0;
+		QString toConnectorID;
+		ViewLayer::ViewLayerPlacement viewLayerPlacement = ViewLayer::NewTop;
+	};
+
+public:
+	AutorouteResultCommand(class SketchWidget *, QUndoCommand * parent);
+	~AutorouteResultCommand();
+
+	void addItem(const Item &);
+	void addConnection(const Connection &);
+	int count() const;				// progress steps, as for the separate commands this replaces
+	void undo();
+	void redo();
+
+protected:
+	struct SuspendedViews {
+		QList<SketchWidget *> ignoring;		// views whose selection-change count this command raised
+		QList<SketchWidget *> repainting;	// views whose updates this command disabled
+	};
+
+protected:
+	QString getParamString() const;
+	QList<SketchWidget *> sketchWidgets();
+	SuspendedViews suspendUpdates();
+	void resumeUpdates(const SuspendedViews &);
+	void stepProgress(bool redo);
+
+protected:
+	QVector<Item> m_items;
+	QVector<Connection> m_connections;
+	CheckStickyCommand * m_checkSticky = nullptr;	// made by the first redo(), not a child
+};
+
+/////////////////////////////////////////////
+
 #endif // COMMANDS_H
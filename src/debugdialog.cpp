@@ -32,9 +32,13 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDir>
 #include <QtDebug>
 #include <QIcon>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
 
 DebugDialog* DebugDialog::singleton = nullptr;
 QFile DebugDialog::m_file;
+static QMutex DebugMutex;				// the gerber export logs from the thread pool
 
 #ifdef QT_NO_DEBUG
 bool DebugDialog::m_enabled = false;
@@ -164,8 +168,16 @@ void DebugDialog::debug(QString message, DebugLevel debugLevel, QObject * ancest
 
 	if (!m_enabled) return;
 
+	QMutexLocker locker(&DebugMutex);
 
 	if (singleton == nullptr) {
+		QCoreApplication * app = QCoreApplication::instance();
+		if (app == nullptr || QThread::currentThread() != app->thread()) {
+			// the dialog is a widget, so only the GUI thread may create it; until then other threads just go to stderr
+			qDebug() << message;
+			return;
+		}
+
 		new DebugDialog();
 		//singleton->show();
 	}
@@ -56,6 +56,9 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 #include "dialogs/recoverydialog.h"
 #include "processeventblocker.h"
 #include "autoroute/checker.h"
+#include "autoroute/drc.h"
+#include "autoroute/mazerouter/mazerouter.h"
+#include "items/via.h"
 #include "sketch/sketchwidget.h"
 #include "sketch/pcbsketchwidget.h"
 #include "help/firsttimehelpdialog.h"
@@ -84,6 +87,12 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 #include <QTemporaryFile>
 #include <QDir>
 #include <QMetaType>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QXmlStreamWriter>
 
 #ifdef LINUX_32
 #define PLATFORM_NAME "linux-32bit"
@@ -417,6 +426,7 @@ int FApplication::init() {
 		        (m_arguments[i].compare("--folder", Qt::CaseInsensitive) == 0))
 		{
 			FolderUtils::setApplicationPath(m_arguments[i + 1]);
+			m_serviceArguments << m_arguments[i] << m_arguments[i + 1];
 			// delete these so we don't try to process them as files later
 			toRemove << i << i + 1;
 		}
@@ -428,6 +438,7 @@ int FApplication::init() {
 		        (m_arguments[i].compare("--partsparent", Qt::CaseInsensitive) == 0))
 		{
 			FolderUtils::setAppPartsPath(m_arguments[i + 1]);
+			m_serviceArguments << m_arguments[i] << m_arguments[i + 1];
 			// delete these so we don't try to process them as files later
 			toRemove << i << i + 1;
 		}
@@ -442,6 +453,7 @@ int FApplication::init() {
 		   )
 		{
 			PaletteModel::setFzpOverrideFolder(m_arguments[i + 1]);
+			m_serviceArguments << m_arguments[i] << m_arguments[i + 1];
 			// delete these so we don't try to process them as files later
 			toRemove << i << i + 1;
 		}
@@ -453,12 +465,28 @@ int FApplication::init() {
 			toRemove << i << i + 1;
 		}
 
-		//if ((m_arguments[i].compare("-drc", Qt::CaseInsensitive) == 0) ||
-		//	(m_arguments[i].compare("--drc", Qt::CaseInsensitive) == 0)) {
-		//	m_serviceType = ServiceType::DRCService;
-		//	m_outputFolder = m_arguments[i + 1];
-		//	toRemove << i << i + 1;
-		//}
+		if ((m_arguments[i].compare("-drc", Qt::CaseInsensitive) == 0) ||
+			(m_arguments[i].compare("--drc", Qt::CaseInsensitive) == 0)) {
+			m_serviceType = ServiceType::DRCService;
+			m_outputFolder = m_arguments[i + 1];		// where the reports go
+			toRemove << i << i + 1;
+			// then the sketches and folders of them, up to the next option
+			for (int j = i + 2; j < m_arguments.count() && !m_arguments[j].startsWith("-"); j++) {
+				m_drcInputs << m_arguments[j];
+				toRemove << j;
+			}
+		}
+
+		if (m_arguments[i].compare("-jobs", Qt::CaseInsensitive) == 0) {
+			m_drcJobs = qMax(0, m_arguments[i + 1].toInt());
+			toRemove << i << i + 1;
+		}
+
+		if (m_arguments[i].compare("-drcname", Qt::CaseInsensitive) == 0) {
+			// only passed to -drc worker processes
+			m_drcReportName = m_arguments[i + 1];
+			toRemove << i << i + 1;
+		}
 
 		if ((m_arguments[i].compare("-db", Qt::CaseInsensitive) == 0) ||
 		        (m_arguments[i].compare("-database", Qt::CaseInsensitive) == 0) ||
@@ -532,6 +560,44 @@ int FApplication::init() {
 			toRemove << i << i + 1;
 		}
 
+		if ((m_arguments[i].compare("-autoroute", Qt::CaseInsensitive) == 0) ||
+			(m_arguments[i].compare("--autoroute", Qt::CaseInsensitive) == 0)) {
+			toRemove << i << i + 1;
+			if (i + 2 < m_arguments.count()) {
+				m_serviceType = ServiceType::AutorouteService;
+				m_autorouteInput = m_arguments[i + 1];
+				m_outputFolder = m_arguments[i + 2];		// actually the path of the routed .fzz
+				toRemove << i + 2;
+			}
+		}
+
+		if (m_arguments[i].compare("-keepout", Qt::CaseInsensitive) == 0) {
+			m_autorouteKeepout = m_arguments[i + 1];
+			m_serviceArguments << m_arguments[i] << m_arguments[i + 1];
+			toRemove << i << i + 1;
+		}
+
+		if (m_arguments[i].compare("-viahole", Qt::CaseInsensitive) == 0) {
+			m_autorouteViaHoleSize = m_arguments[i + 1];
+			toRemove << i << i + 1;
+		}
+
+		if (m_arguments[i].compare("-viaring", Qt::CaseInsensitive) == 0) {
+			m_autorouteViaRingThickness = m_arguments[i + 1];
+			toRemove << i << i + 1;
+		}
+
+		if (m_arguments[i].compare("-maxcycles", Qt::CaseInsensitive) == 0) {
+			m_autorouteMaxCycles = qMax(0, m_arguments[i + 1].toInt());
+			toRemove << i << i + 1;
+		}
+
+		if (m_arguments[i].compare("-bothsides", Qt::CaseInsensitive) == 0) {
+			QString value = m_arguments[i + 1].toLower();
+			m_autorouteBothSides = !(value == "0" || value == "no" || value == "false" || value == "off");
+			toRemove << i << i + 1;
+		}
+
 		if (m_arguments[i].compare("-ep", Qt::CaseInsensitive) == 0) {
 			m_externalProcessPath = m_arguments[i + 1];
 			toRemove << i << i + 1;
@@ -878,8 +944,10 @@ int FApplication::serviceStartup() {
 		return 0;
 
 	case ServiceType::DRCService:
-		runDRCService();
-		return 0;
+		return runDRCService() ? 0 : -1;
+
+	case ServiceType::AutorouteService:
+		return runAutorouteService() ? 0 : -1;
 
 	case ServiceType::DatabaseService:
 		runDatabaseService();
@@ -1099,60 +1167,480 @@ void FApplication::runGedaService() {
 }
 
 
-void FApplication::runDRCService() {
-	m_started = true;
-	initService();
-	DebugDialog::setEnabled(true);
+static constexpr int DRCWorkerPollInterval = 50;		// ms between looks at the worker processes
 
-	try {
-		QDir dir(m_outputFolder);
-		QStringList filters;
-		filters << "*.fzz";
-		QStringList filenames = dir.entryList(filters, QDir::Files);
-		Q_FOREACH (QString filename, filenames) {
-			QString filepath = dir.absoluteFilePath(filename);
-			MainWindow * mainWindow = openWindowForService(false, 3);
-			if (mainWindow == nullptr) continue;
+static QStringList drcReportNames(const QStringList & filepaths) {
+	// sketches with the same name in different folders get their input number appended
+	QHash<QString, int> counts;
+	Q_FOREACH (QString filepath, filepaths) {
+		counts[QFileInfo(filepath).completeBaseName().toLower()]++;
+	}
 
-			mainWindow->setCloseSilently(true);
+	QStringList names;
+	for (int i = 0; i < filepaths.count(); i++) {
+		QString name = QFileInfo(filepaths.at(i)).completeBaseName();
+		if (counts.value(name.toLower()) > 1) name += QString("-%1").arg(i + 1);
+		names << name;
+	}
+	return names;
+}
+
+static QString drcReportPath(const QString & reportFolder, const QString & reportName, const QString & suffix) {
+	return QDir(reportFolder).absoluteFilePath(reportName + suffix);
+}
+
+static bool writeJUnitReport(const QJsonObject & report, const QString & path) {
+	// one test case per board, failing with the list of its violations
+	QFile file(path);
+	if (!file.open(QFile::WriteOnly | QFile::Text)) return false;
+
+	QString name = QFileInfo(report.value("file").toString()).fileName();
+	QJsonArray boards = report.value("boards").toArray();
+	QString error = report.value("error").toString();
+	int failures = 0;
+	Q_FOREACH (QJsonValue board, boards) {
+		if (!board.toObject().value("violations").toArray().isEmpty()) failures++;
+	}
+
+	QXmlStreamWriter xml(&file);
+	xml.setAutoFormatting(true);
+	xml.writeStartDocument();
+	xml.writeStartElement("testsuite");
+	xml.writeAttribute("name", "DRC " + name);
+	xml.writeAttribute("tests", QString::number(error.isEmpty() ? boards.count() : 1));
+	xml.writeAttribute("failures", QString::number(failures));
+	xml.writeAttribute("errors", QString::number(error.isEmpty() ? 0 : 1));
+	xml.writeAttribute("time", QString::number(report.value("wallTimeMs").toDouble() / 1000));
+
+	if (!error.isEmpty()) {
+		xml.writeStartElement("testcase");
+		xml.writeAttribute("classname", name);
+		xml.writeAttribute("name", "load");
+		xml.writeStartElement("error");
+		xml.writeAttribute("message", error);
+		xml.writeEndElement();
+		xml.writeEndElement();
+	}
+
+	Q_FOREACH (QJsonValue value, boards) {
+		QJsonObject board = value.toObject();
+		QJsonArray violations = board.value("violations").toArray();
+		xml.writeStartElement("testcase");
+		xml.writeAttribute("classname", name);
+		xml.writeAttribute("name", QString("%1 (%2)").arg(board.value("instanceTitle").toString()).arg(board.value("id").toVariant().toLongLong()));
+		xml.writeAttribute("time", QString::number(board.value("phases").toObject().value("totalMs").toDouble() / 1000));
+		if (!violations.isEmpty()) {
+			QStringList lines;
+			Q_FOREACH (QJsonValue violation, violations) {
+				QJsonObject area = violation.toObject().value("area").toObject();
+				lines << QString("%1 at %2,%3 mm: %4")
+				      .arg(violation.toObject().value("kind").toString())
+				      .arg(area.value("x").toDouble(), 0, 'f', 3)
+				      .arg(area.value("y").toDouble(), 0, 'f', 3)
+				      .arg(violation.toObject().value("message").toString());
+			}
+			xml.writeStartElement("failure");
+			xml.writeAttribute("type", "DRC");
+			xml.writeAttribute("message", QString("%1 DRC violations").arg(violations.count()));
+			xml.writeCharacters(lines.join("\n"));
+			xml.writeEndElement();
+		}
+		xml.writeEndElement();
+	}
+
+	xml.writeEndElement();
+	xml.writeEndDocument();
+	return true;
+}
+
+static QJsonObject drcFileSummary(const QJsonObject & report, const QString & reportPath) {
+	QJsonObject summary;
+	summary.insert("file", report.value("file"));
+	summary.insert("ok", report.value("ok").toBool());
+	summary.insert("violations", report.value("violations").toInt());
+	summary.insert("report", reportPath);
+	if (report.contains("error")) summary.insert("error", report.value("error"));
+	return summary;
+}
 
-			if (!mainWindow->loadWhich(filepath, false, false, false, "")) {
-				DebugDialog::debug(QString("failed to load '%1'").arg(filepath));
-				mainWindow->close();
-				delete mainWindow;
-				continue;
+bool FApplication::runDRCService() {
+	// every sketch gets a JSON and a JUnit report in the output folder, and a JSON summary goes to stdout;
+	// with more than one sketch they are checked in worker processes, each running this with -jobs 1 and one sketch
+	m_started = true;
+	FMessageBox::BlockMessages = true;
+
+	QElapsedTimer timer;
+	timer.start();
+
+	QStringList filepaths;
+	Q_FOREACH (QString input, m_drcInputs) {
+		QFileInfo info(input);
+		if (info.isDir()) {
+			QDir dir(input);
+			Q_FOREACH (QString filename, dir.entryList(QStringList("*.fzz"), QDir::Files, QDir::Name)) {
+				filepaths << dir.absoluteFilePath(filename);
 			}
+		}
+		else {
+			filepaths << info.absoluteFilePath();
+		}
+	}
+
+	int jobs = qMin(m_drcJobs > 0 ? m_drcJobs : QThread::idealThreadCount(), filepaths.count());
+	QStringList reportNames = drcReportNames(filepaths);
+	if (!m_drcReportName.isEmpty() && filepaths.count() == 1) {
+		reportNames = QStringList(m_drcReportName);
+	}
+
+	QJsonObject summary;
+	summary.insert("reports", m_outputFolder);
+	summary.insert("jobs", jobs);
+
+	QJsonArray files;
+	bool ok = true;
+	if (filepaths.isEmpty()) {
+		summary.insert("error", "no sketches to check");
+		ok = false;
+	}
+	else if (!QDir().mkpath(m_outputFolder)) {
+		summary.insert("error", QString("unable to create '%1'").arg(m_outputFolder));
+		ok = false;
+	}
+	else if (jobs > 1) {
+		ok = runDRCServiceWorkers(filepaths, reportNames, jobs, files);
+	}
+	else {
+		initService();
+		for (int i = 0; i < filepaths.count(); i++) {
+			QJsonObject report = runDRCServiceFile(filepaths.at(i), reportNames.at(i));
+			files.append(drcFileSummary(report, drcReportPath(m_outputFolder, reportNames.at(i), ".drc.json")));
+			if (!report.value("ok").toBool()) ok = false;
+		}
+	}
+
+	summary.insert("files", files);
+	summary.insert("ok", ok);
+	summary.insert("wallTimeMs", timer.elapsed());
+
+	QTextStream cout(stdout);
+	cout << QJsonDocument(summary).toJson(QJsonDocument::Indented);
+	return ok;
+}
+
+bool FApplication::runDRCServiceWorkers(const QStringList & filepaths, const QStringList & reportNames, int jobs, QJsonArray & files) {
+	// each worker is a fresh process, so a sketch that crashes Fritzing only fails itself
+	QHash<QProcess *, int> running;
+	QHash<int, int> exitCodes;
+	int next = 0;
+	while (next < filepaths.count() || !running.isEmpty()) {
+		while (running.count() < jobs && next < filepaths.count()) {
+			int index = next++;
+			// a worker that dies before writing must not leave an old report to be read as its own
+			QFile::remove(drcReportPath(m_outputFolder, reportNames.at(index), ".drc.json"));
+			QFile::remove(drcReportPath(m_outputFolder, reportNames.at(index), ".drc.xml"));
 
-			mainWindow->showPCBView();
+			auto * process = new QProcess;
+			process->setStandardOutputFile(QProcess::nullDevice());
+			process->setStandardErrorFile(QProcess::nullDevice());
+			QStringList args = m_serviceArguments;
+			args << "-drc" << m_outputFolder << filepaths.at(index) << "-jobs" << "1" << "-drcname" << reportNames.at(index);
+			process->start(QCoreApplication::applicationFilePath(), args);
+			running.insert(process, index);
+		}
+
+		Q_FOREACH (QProcess * process, running.keys()) {
+			if (process->state() != QProcess::NotRunning && !process->waitForFinished(DRCWorkerPollInterval / running.count())) continue;
 
-			int moved = mainWindow->pcbView()->checkLoadedTraces();
-			if (moved > 0) {
-				QMessageBox::warning(nullptr, QObject::tr("Fritzing"), QObject::tr("%1 wires moved from their saved position in %2.").arg(moved).arg(filepath));
-				DebugDialog::debug(QString("\ncheckloadedtraces %1\n").arg(filepath));
+			exitCodes.insert(running.value(process), process->exitStatus() == QProcess::NormalExit ? process->exitCode() : -1);
+			running.remove(process);
+			delete process;
+		}
+	}
+
+	bool ok = true;
+	for (int i = 0; i < filepaths.count(); i++) {
+		QString filepath = filepaths.at(i);
+		QString reportPath = drcReportPath(m_outputFolder, reportNames.at(i), ".drc.json");
+		QFile file(reportPath);
+		QJsonObject report;
+		if (file.open(QFile::ReadOnly)) {
+			report = QJsonDocument::fromJson(file.readAll()).object();
+		}
+		if (report.isEmpty()) {
+			report.insert("file", filepath);
+			report.insert("ok", false);
+			report.insert("error", QString("worker exited with code %1 and no report").arg(exitCodes.value(i)));
+		}
+		files.append(drcFileSummary(report, reportPath));
+		if (!report.value("ok").toBool()) ok = false;
+	}
+
+	return ok;
+}
+
+QJsonObject FApplication::runDRCServiceFile(const QString & filepath, const QString & reportName) {
+	QElapsedTimer timer;
+	timer.start();
+
+	QJsonObject report;
+	report.insert("file", filepath);
+
+	// an old report must not pass for this run's if this one fails to write
+	QString jsonPath = drcReportPath(m_outputFolder, reportName, ".drc.json");
+	QString junitPath = drcReportPath(m_outputFolder, reportName, ".drc.xml");
+	QFile::remove(jsonPath);
+	QFile::remove(junitPath);
+
+	QString error;
+	MainWindow * mainWindow = openWindowForService(false, 3);
+	if (mainWindow == nullptr) {
+		error = "unable to open a window";
+	}
+	else {
+		mainWindow->setCloseSilently(true);
+		if (mainWindow->loadWhich(filepath, false, false, false, "")) {
+			report.insert("loadMs", timer.elapsed());
+			try {
+				error = runDRCServiceAux(mainWindow, report);
+			}
+			catch (const QString & msg) {
+				error = msg;
+			}
+			catch (...) {
+				error = "unexpected exception";
 			}
+		}
+		else {
+			error = QString("failed to load '%1'").arg(filepath);
+		}
+		mainWindow->close();
+		delete mainWindow;
+	}
 
+	report.insert("ok", error.isEmpty() && report.value("violations").toInt() == 0);
+	if (!error.isEmpty()) {
+		report.insert("error", error);
+	}
+	report.insert("wallTimeMs", timer.elapsed());
 
-			Checker::checkDonuts(mainWindow, true);
-			Checker::checkText(mainWindow, true);
+	QFile file(jsonPath);
+	if (file.open(QFile::WriteOnly)) {
+		file.write(QJsonDocument(report).toJson(QJsonDocument::Indented));
+		file.close();
+	}
+	else {
+		DebugDialog::debug(QString("unable to write '%1'").arg(jsonPath));
+	}
+	if (!writeJUnitReport(report, junitPath)) {
+		DebugDialog::debug(QString("unable to write '%1'").arg(junitPath));
+	}
 
-			QList<ItemBase *> boards = mainWindow->pcbView()->findBoard();
-			Q_FOREACH (ItemBase * boardItem, boards) {
-				mainWindow->pcbView()->selectAllItems(false, false);
-				boardItem->setSelected(true);
-				mainWindow->newDesignRulesCheck(false);
+	return report;
+}
+
+QString FApplication::runDRCServiceAux(MainWindow * mainWindow, QJsonObject & report) {
+	mainWindow->showPCBView();
+	PCBSketchWidget * pcbView = mainWindow->pcbView();
+
+	report.insert("movedWires", pcbView->checkLoadedTraces());
+	Checker::checkDonuts(mainWindow, false);
+	Checker::checkText(mainWindow, false);
+
+	// the sketch's own keepout unless -keepout says otherwise
+	double keepoutMils = pcbView->getKeepout() * 1000 / GraphicsUtils::SVGDPI;
+	if (!m_autorouteKeepout.isEmpty()) {
+		bool ok;
+		double inches = TextUtils::convertToInches(m_autorouteKeepout, &ok, false);
+		if (!ok) {
+			return QString("bad value '%1' for -keepout; expecting a number with units, e.g. 10mil or 0.4mm").arg(m_autorouteKeepout);
+		}
+		keepoutMils = inches * 1000;
+	}
+	report.insert("keepoutMils", keepoutMils);
+
+	QList<ItemBase *> boards = pcbView->findBoard();
+	if (boards.isEmpty()) {
+		return "the sketch has no board";
+	}
+
+	QJsonArray boardReports;
+	int violationCount = 0;
+	ProcessEventBlocker::block();
+	Q_FOREACH (ItemBase * board, boards) {
+		pcbView->selectAllItems(false, false);
+		board->setSelected(true);
+
+		QElapsedTimer timer;
+		timer.start();
+		DRC drc(pcbView, board);
+		drc.start(false, keepoutMils);
+		const DRCStats & stats = drc.stats();
+
+		QJsonObject boardReport;
+		boardReport.insert("id", (double) board->id());
+		boardReport.insert("title", board->title());
+		boardReport.insert("instanceTitle", board->instanceTitle());
+
+		QJsonObject phases;
+		phases.insert("netsMs", stats.netsMs);
+		phases.insert("bordersMs", stats.bordersMs);
+		phases.insert("netChecksMs", stats.netChecksMs);
+		phases.insert("holesMs", stats.holesMs);
+		phases.insert("copperBothMs", stats.copperBothMs);
+		phases.insert("totalMs", timer.elapsed());
+		boardReport.insert("phases", phases);
+
+		QJsonArray violations;
+		Q_FOREACH (const DRCViolation & violation, stats.violations) {
+			QJsonObject v;
+			v.insert("kind", violation.kind);
+			v.insert("message", violation.message);
+			QJsonObject area;									// mm from the board's top left
+			area.insert("x", violation.area.x() * 25.4);
+			area.insert("y", violation.area.y() * 25.4);
+			area.insert("width", violation.area.width() * 25.4);
+			area.insert("height", violation.area.height() * 25.4);
+			v.insert("area", area);
+			if (violation.itemID >= 0) {
+				QJsonObject part;
+				part.insert("id", (double) violation.itemID);
+				part.insert("title", violation.title);
+				part.insert("instanceTitle", violation.instanceTitle);
+				v.insert("part", part);
 			}
+			violations.append(v);
+		}
+		boardReport.insert("violations", violations);
+		violationCount += violations.count();
+		boardReports.append(boardReport);
+	}
+	ProcessEventBlocker::unblock();
+
+	report.insert("boards", boardReports);
+	report.insert("violations", violationCount);
+	return "";
+}
 
+bool FApplication::runAutorouteService() {
+	m_started = true;
+	FMessageBox::BlockMessages = true;
+
+	QElapsedTimer timer;
+	timer.start();
+
+	QJsonObject summary;
+	summary.insert("input", m_autorouteInput);
+	summary.insert("output", m_outputFolder);
+
+	QString error;
+	if (!m_outputFolder.endsWith(FritzingBundleExtension, Qt::CaseInsensitive)) {
+		error = QString("output file must end with %1").arg(FritzingBundleExtension);
+	}
+	else {
+		initService();
+		MainWindow * mainWindow = openWindowForService(false, 3);
+		if (mainWindow == nullptr) {
+			error = "unable to open a window";
+		}
+		else {
+			mainWindow->setCloseSilently(true);
+			if (mainWindow->loadWhich(m_autorouteInput, false, false, false, "")) {
+				error = runAutorouteServiceAux(mainWindow, summary);
+			}
+			else {
+				error = QString("failed to load '%1'").arg(m_autorouteInput);
+			}
 			mainWindow->close();
 			delete mainWindow;
 		}
 	}
-	catch (const QString & msg) {
-		DebugDialog::debug(msg);
+
+	summary.insert("ok", error.isEmpty());
+	if (!error.isEmpty()) {
+		summary.insert("error", error);
 	}
-	catch (...) {
-		// Not sure why this was originally added.
-		DebugDialog::debug("runDRCService: discarding exception");
+	summary.insert("wallTimeMs", timer.elapsed());
+
+	QTextStream cout(stdout);
+	cout << QJsonDocument(summary).toJson(QJsonDocument::Indented);
+	return error.isEmpty();
+}
+
+QString FApplication::runAutorouteServiceAux(MainWindow * mainWindow, QJsonObject & summary) {
+	mainWindow->showPCBView();
+	PCBSketchWidget * pcbView = mainWindow->pcbView();
+
+	QList<ItemBase *> boards = pcbView->findBoard();
+	if (boards.count() != 1) {
+		return QString("the sketch has %1 boards; the autorouter handles exactly one").arg(boards.count());
+	}
+
+	// the command-line overrides apply to this run only; they are not saved with the sketch
+	QHash<QString, QString> savedSettings = pcbView->getAutorouterSettings();
+	QHash<QString, QString> autorouterSettings = savedSettings;
+	QList< QPair<QString, QString> > overrides;
+	overrides << qMakePair(DRC::KeepoutSettingName, m_autorouteKeepout)
+	          << qMakePair(Via::AutorouteViaHoleSize, m_autorouteViaHoleSize)
+	          << qMakePair(Via::AutorouteViaRingThickness, m_autorouteViaRingThickness);
+	for (const auto & setting : overrides) {
+		if (setting.second.isEmpty()) continue;
+
+		bool ok;
+		TextUtils::convertToInches(setting.second, &ok, false);
+		if (!ok) {
+			return QString("bad value '%1' for %2; expecting a number with units, e.g. 10mil or 0.4mm").arg(setting.second, setting.first);
+		}
+		autorouterSettings.insert(setting.first, setting.second);
+	}
+	pcbView->setAutorouterSettings(autorouterSettings);
+
+	pcbView->scene()->clearSelection();
+	pcbView->setIgnoreSelectionChangeEvents(true);
+	ProcessEventBlocker::block();
+
+	auto * autorouter = new MazeRouter(pcbView, boards.first(), true);
+	autorouter->setRunLimits(m_autorouteMaxCycles, m_autorouteBothSides);
+	autorouter->start();
+	AutorouteStats stats = autorouter->stats();
+	delete autorouter;
+
+	ProcessEventBlocker::unblock();
+	pcbView->setIgnoreSelectionChangeEvents(false);
+	pcbView->setAutorouterSettings(savedSettings);
+
+	summary.insert("connections", stats.connectionsToRoute);
+	summary.insert("routed", stats.connectionsRouted);
+	summary.insert("vias", stats.viaCount);
+	summary.insert("jumpers", stats.jumperCount);
+	summary.insert("peakGridBytes", stats.peakGridBytes);
+	summary.insert("gridTileSpills", stats.gridTileSpills);
+	summary.insert("nodesExpanded", stats.nodesExpanded);
+	QJsonObject phases;
+	phases.insert("makeMastersMs", stats.makeMastersMs);
+	phases.insert("routeMs", stats.routeMs);
+	phases.insert("createTracesMs", stats.createTracesMs);
+	phases.insert("optimizeTracesMs", stats.optimizeTracesMs);
+	summary.insert("phases", phases);
+	QJsonObject bounds;
+	bounds.insert("corridorRoutes", stats.corridorRoutes);
+	bounds.insert("corridorFallbacks", stats.corridorFallbacks);
+	bounds.insert("regionRoutes", stats.regionRoutes);
+	QJsonArray regionFallbacks;
+	Q_FOREACH (int count, stats.regionFallbacks) regionFallbacks.append(count);
+	bounds.insert("regionFallbacks", regionFallbacks);
+	bounds.insert("budgetHits", stats.budgetHits);
+	summary.insert("bounds", bounds);
+	summary.insert("bothSides", m_autorouteBothSides && pcbView->routeBothSides());
+
+	if (!mainWindow->saveAsAux(m_outputFolder)) {
+		return QString("unable to save '%1'").arg(m_outputFolder);
+	}
+
+	if (stats.connectionsRouted < stats.connectionsToRoute) {
+		return QString("%1 of %2 connections could not be routed").arg(stats.connectionsToRoute - stats.connectionsRouted).arg(stats.connectionsToRoute);
 	}
+
+	return "";
 }
 
 void FApplication::runKicadFootprintService() {
@@ -38,6 +38,8 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 #include "referencemodel/referencemodel.h"
 
 class FileProgressDialog;
+class QJsonObject;
+class QJsonArray;
 
 class FServer : public QTcpServer
 {
@@ -167,7 +169,12 @@ protected:
 	bool notify(QObject *receiver, QEvent *e);
 	void initService();
 	void runPortService();
-	void runDRCService();
+	bool runDRCService();
+	QJsonObject runDRCServiceFile(const QString & filepath, const QString & reportName);
+	QString runDRCServiceAux(MainWindow *, QJsonObject & report);
+	bool runDRCServiceWorkers(const QStringList & filepaths, const QStringList & reportNames, int jobs, QJsonArray & files);
+	bool runAutorouteService();
+	QString runAutorouteServiceAux(MainWindow *, QJsonObject & summary);
 	void runGedaService();
 	void runDatabaseService();
 	void runKicadFootprintService();
@@ -208,6 +215,7 @@ protected:
 		PortService,
 		DRCService,
 		ExportAllService,
+		AutorouteService,
 		NoService
 	};
 
@@ -234,6 +242,16 @@ protected:
 	QString m_outputFolder;
 	QString m_portRootFolder;
 	QString m_panelFilename;
+	QString m_autorouteInput;
+	QString m_autorouteKeepout;
+	QString m_autorouteViaHoleSize;
+	QString m_autorouteViaRingThickness;
+	int m_autorouteMaxCycles = 0;
+	bool m_autorouteBothSides = true;
+	QStringList m_drcInputs;						// .fzz files and folders of them
+	int m_drcJobs = 0;								// worker processes; 0 for one per core
+	QString m_drcReportName;						// a worker's report name, chosen by the parent process
+	QStringList m_serviceArguments;					// the options a worker process needs as well
 	QHash<QString, struct LockedFile *> m_lockedFiles;
 	int m_portNumber = 0;
 	FServer * m_fServer = nullptr;
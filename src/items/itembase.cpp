@@ -2454,8 +2454,12 @@ void ItemBase::setTransform2(const QTransform & transform)
 }
 
 void ItemBase::renderOne(QDomDocument * masterDoc, QImage * image, const QRectF & renderRect) {
-	QByteArray byteArray = masterDoc->toByteArray();
-	QSvgRenderer renderer(byteArray);
+	renderOne(masterDoc->toByteArray(), image, renderRect);
+}
+
+void ItemBase::renderOne(const QByteArray & svg, QImage * image, const QRectF & renderRect) {
+	// safe off the main thread: needs nothing but the svg and the image
+	QSvgRenderer renderer(svg);
 	QPainter painter;
 	painter.begin(image);
 	painter.setRenderHint(QPainter::Antialiasing, false);
@@ -422,6 +422,7 @@ public:
 	static QString translatePropertyName(const QString & key);
 	static void setReferenceModel(ReferenceModel *);
 	static void renderOne(QDomDocument *, QImage *, const QRectF & renderRect);
+	static void renderOne(const QByteArray & svg, QImage *, const QRectF & renderRect);
 
 
 };
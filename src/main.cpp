@@ -126,16 +126,24 @@ int main(int argc, char *argv[])
 			     "Options:\n"
 			     "\n"
 			     "User options:\n"
+			     "  -autoroute IN OUT             autoroute the PCB of sketch IN and save it as OUT (.fzz); prints a JSON summary\n"
+			     "  -bothsides yes|no             with -autoroute, route on both layers of a two-layer board (default yes)\n"
 			     "  -d, -debug                    run Fritzing in debug mode, providing additional debug information\n"
-			     //" drc filename : runs a design rule check on the given sketch file\n"
+			     "  -drc OUT IN...                design rules check the sketches IN (.fzz files or folders of them); writes JSON and JUnit reports to OUT,\n"
+			     "                                named after each sketch, with its input number appended when two sketches share a name\n"
 			     "  -f, -folder FOLDER            use Fritzing parts, sketches, bins and translations in folders under FOLDER\n"
 			     "  -geda FOLDER                  convert all gEDA footprint (.fp) files in FOLDER to Fritzing SVGs\n"
 			     "  -g, -gerber FOLDER            export all sketches in FOLDER to Gerber, in the same folder\n"
 			     "  -h, -help                     print this help message\n"
+			     "  -jobs NUMBER                  with -drc, check NUMBER sketches at a time in separate processes (default one per core)\n"
 			     "  -kicad FOLDER                 convert all Kicad footprint (.mod) files in FOLDER to Fritzing SVGs\n"
+			     "  -keepout DISTANCE             with -autoroute or -drc, keepout such as 10mil or 0.25mm\n"
 			     "  -kicadschematic FOLDER        convert all Kicad schematic (.lib) files in FOLDER to Fritzing SVGs\n"
+			     "  -maxcycles NUMBER             with -autoroute, try at most NUMBER net orderings\n"
 			     "  -port NUMBER                  run Fritzing as a server process on port NUMBER\n"
 			     "  -svg FOLDER                   export all sketches in FOLDER to SVGs of all views, in the same folder\n"
+			     "  -viahole SIZE                 with -autoroute, via hole diameter such as 0.4mm\n"
+			     "  -viaring SIZE                 with -autoroute, via ring thickness such as 0.2mm\n"
 			     "\n"
 			     "Administrator option:\n"
 			     "  -db, -database FILE           rebuild the internal parts database FILE\n"
@@ -149,6 +157,11 @@ int main(int argc, char *argv[])
 			     "The -geda, -kicad, -kicadschematic, -gerber SVG options all exit Fritzing after the conversion process is complete;\n"
 			     "these options are mutually exclusive.\n"
 			     "\n"
+			     "The -autoroute option also exits when done; the exit code is nonzero if the sketch could not be loaded or saved,\n"
+			     "or if any connection is left unrouted (OUT is still saved with the best routing found).\n"
+			     "The -drc option exits when done; the exit code is nonzero if any sketch could not be checked or has violations.\n"
+			     "To run it on a machine without a display, set QT_QPA_PLATFORM=offscreen.\n"
+			     "\n"
 #ifndef PKGDATADIR
 			     "Usually, the Fritzing executable is stored in the same folder that contains the parts/bins/sketches/translations folders,\n"
 			     "or the executable is in a child folder of the p/b/s/t folder.\n"
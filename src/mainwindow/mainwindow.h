@@ -364,6 +364,7 @@ protected Q_SLOTS:
 	void updateItemMenu();
 
 	void newAutoroute();
+	void rerouteChangedNets();
 	void orderFab();
 	void activeLayerTop();
 	void activeLayerBottom();
@@ -421,6 +422,7 @@ protected Q_SLOTS:
 	void openProgramWindow();
 	void linkToProgramFile(const QString & filename, Platform * platform, bool addLink, bool strong);
 	QStringList newDesignRulesCheck();
+	void setLiveDRC(bool);
 	void subSwapSlot(SketchWidget *, ItemBase *, const QString & newModuleID, ViewLayer::ViewLayerPlacement, long & newID, QUndoCommand * parentCommand);
 	void updateLayerMenuSlot();
 	bool save();
@@ -548,6 +550,7 @@ protected:
 	SketchToolButton *createShareButton(SketchAreaWidget *parent);
 	SketchToolButton *createFlipButton(SketchAreaWidget *parent);
 	SketchToolButton *createAutorouteButton(SketchAreaWidget *parent);
+	void autoroute(bool incremental);
 	SketchToolButton *createOrderFabButton(SketchAreaWidget *parent);
 	void updateOrderFabMenu(SketchToolButton* orderFabButton);
 	QWidget *createActiveLayerButton(SketchAreaWidget *parent);
@@ -667,6 +670,7 @@ protected:
 
 	QPointer<SketchAreaWidget> m_pcbWidget;
 	QPointer<class PCBSketchWidget> m_pcbGraphicsView;
+	QPointer<class LiveDRC> m_liveDRC;
 
 	QPointer<SketchAreaWidget> m_welcomeWidget;
 	class WelcomeView * m_welcomeView = nullptr;
@@ -853,6 +857,7 @@ protected:
 	QMenu *m_schematicTraceMenu = nullptr;
 	QMenu *m_breadboardTraceMenu = nullptr;
 	QAction *m_newAutorouteAct = nullptr;
+	QAction *m_rerouteChangedNetsAct = nullptr;
 	QAction *m_orderFabAct = nullptr;
 	QAction *m_activeLayerTopAct = nullptr;
 	QAction *m_activeLayerBottomAct = nullptr;
@@ -886,6 +891,7 @@ protected:
 	QAction *m_clearGroundFillSeedsAct = nullptr;
 	QAction *m_setGroundFillKeepoutAct = nullptr;
 	QAction *m_newDesignRulesCheckAct = nullptr;
+	QAction *m_liveDRCAct = nullptr;
 	QAction *m_autorouterSettingsAct = nullptr;
 	QAction *m_fabQuoteAct = nullptr;
 	QAction *m_tidyWiresAct = nullptr;
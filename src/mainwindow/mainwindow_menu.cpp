@@ -38,6 +38,7 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 #include "../autoroute/mazerouter/mazerouter.h"
 #include "../autoroute/autorouteprogressdialog.h"
 #include "../autoroute/drc.h"
+#include "../autoroute/livedrc.h"
 #include "../items/resizableboard.h"
 #include "../items/jumperitem.h"
 #include "../items/via.h"
@@ -1574,7 +1575,9 @@ void MainWindow::createTraceMenus()
 {
 	m_pcbTraceMenu = menuBar()->addMenu(tr("&Routing"));
 	m_pcbTraceMenu->addAction(m_newAutorouteAct);
+	m_pcbTraceMenu->addAction(m_rerouteChangedNetsAct);
 	m_pcbTraceMenu->addAction(m_newDesignRulesCheckAct);
+	m_pcbTraceMenu->addAction(m_liveDRCAct);
 	m_pcbTraceMenu->addAction(m_autorouterSettingsAct);
 	m_pcbTraceMenu->addAction(m_fabQuoteAct);
 
@@ -1614,6 +1617,7 @@ void MainWindow::createTraceMenus()
 
 	m_schematicTraceMenu = menuBar()->addMenu(tr("&Routing"));
 	m_schematicTraceMenu->addAction(m_newAutorouteAct);
+	m_schematicTraceMenu->addAction(m_rerouteChangedNetsAct);
 	m_schematicTraceMenu->addAction(m_excludeFromAutorouteAct);
 	m_schematicTraceMenu->addAction(m_showUnroutedAct);
 	m_schematicTraceMenu->addAction(m_selectAllTracesAct);
@@ -2787,6 +2791,10 @@ void MainWindow::createTraceMenuActions() {
 	m_newAutorouteAct->setShortcut(tr("Shift+Ctrl+A"));
 	connect(m_newAutorouteAct, SIGNAL(triggered()), this, SLOT(newAutoroute()));
 
+	m_rerouteChangedNetsAct = new QAction(tr("Reroute Changed Nets"), this);
+	m_rerouteChangedNetsAct->setStatusTip(tr("Autoroute only the connections that are missing or whose traces no longer keep their clearance, keeping the other autorouted traces"));
+	connect(m_rerouteChangedNetsAct, SIGNAL(triggered()), this, SLOT(rerouteChangedNets()));
+
 	createOrderFabAct();
 	createActiveLayerActions();
 
@@ -2894,6 +2902,15 @@ void MainWindow::createTraceMenuActions() {
 	m_newDesignRulesCheckAct->setShortcut(tr("Shift+Ctrl+D"));
 	connect(m_newDesignRulesCheckAct, SIGNAL(triggered()), this, SLOT(newDesignRulesCheck()));
 
+	m_liveDRCAct = new QAction(tr("Live DRC"), this);
+	m_liveDRCAct->setStatusTip(tr("Keep checking for parts that are too close together while the board is edited"));
+	m_liveDRCAct->setCheckable(true);
+	QSettings liveDRCSettings;
+	bool liveDRC = liveDRCSettings.value(DRC::LiveSettingName, false).toBool();
+	m_liveDRCAct->setChecked(liveDRC);
+	setLiveDRC(liveDRC);
+	connect(m_liveDRCAct, SIGNAL(toggled(bool)), this, SLOT(setLiveDRC(bool)));
+
 	m_autorouterSettingsAct = new QAction(tr("Autorouter/DRC settings..."), this);
 	m_autorouterSettingsAct->setStatusTip(tr("Set autorouting parameters including keepout..."));
 	connect(m_autorouterSettingsAct, SIGNAL(triggered()), this, SLOT(autorouterSettings()));
@@ -3009,6 +3026,14 @@ void MainWindow::createOrderFabAct() {
 
 
 void MainWindow::newAutoroute() {
+	autoroute(false);
+}
+
+void MainWindow::rerouteChangedNets() {
+	autoroute(true);
+}
+
+void MainWindow::autoroute(bool incremental) {
 	auto * pcbSketchWidget = qobject_cast<PCBSketchWidget *>(m_currentGraphicsView);
 	if (pcbSketchWidget == nullptr) return;
 
@@ -3044,7 +3069,9 @@ void MainWindow::newAutoroute() {
 	pcbSketchWidget->scene()->clearSelection();
 	pcbSketchWidget->setIgnoreSelectionChangeEvents(true);
 	Autorouter * autorouter = nullptr;
-	autorouter = new MazeRouter(pcbSketchWidget, board, true);
+	auto * mazeRouter = new MazeRouter(pcbSketchWidget, board, true);
+	mazeRouter->setIncremental(incremental);
+	autorouter = mazeRouter;
 
 	connect(autorouter, SIGNAL(wantTopVisible()), this, SLOT(activeLayerTop()), Qt::DirectConnection);
 	connect(autorouter, SIGNAL(wantBottomVisible()), this, SLOT(activeLayerBottom()), Qt::DirectConnection);
@@ -3056,8 +3083,9 @@ void MainWindow::newAutoroute() {
 	connect(&progress, SIGNAL(best()), autorouter, SLOT(useBest()), Qt::DirectConnection);
 	connect(&progress, SIGNAL(spinChange(int)), autorouter, SLOT(setMaxCycles(int)), Qt::DirectConnection);
 
-	connect(autorouter, SIGNAL(setMaximumProgress(int)), &progress, SLOT(setMaximum(int)), Qt::DirectConnection);
-	connect(autorouter, SIGNAL(setProgressValue(int)), &progress, SLOT(setValue(int)), Qt::DirectConnection);
+	// the autorouter emits these from its routing thread as well, so let Qt queue them
+	connect(autorouter, SIGNAL(setMaximumProgress(int)), &progress, SLOT(setMaximum(int)));
+	connect(autorouter, SIGNAL(setProgressValue(int)), &progress, SLOT(setValue(int)));
 	connect(autorouter, SIGNAL(setProgressMessage(const QString &)), &progress, SLOT(setMessage(const QString &)));
 	connect(autorouter, SIGNAL(setProgressMessage2(const QString &)), &progress, SLOT(setMessage2(const QString &)));
 	connect(autorouter, SIGNAL(setCycleMessage(const QString &)), &progress, SLOT(setSpinLabel(const QString &)));
@@ -4287,6 +4315,22 @@ void MainWindow::linkToProgramFile(const QString & filename, Platform * platform
 	}
 }
 
+void MainWindow::setLiveDRC(bool on)
+{
+	QSettings settings;
+	settings.setValue(DRC::LiveSettingName, on);
+
+	if (!on) {
+		delete m_liveDRC;
+		m_liveDRC = nullptr;
+		return;
+	}
+
+	if (m_liveDRC == nullptr) {
+		m_liveDRC = new LiveDRC(m_pcbGraphicsView);
+	}
+}
+
 QStringList MainWindow::newDesignRulesCheck()
 {
 	return newDesignRulesCheck(true);
@@ -0,0 +1,132 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+#include "partcopper.h"
+#include "modelpart.h"
+#include "../connectors/connector.h"
+#include "../connectors/svgidlayer.h"
+#include "../debugdialog.h"
+#include "../utils/textutils.h"
+
+#include <QDateTime>
+#include <QDomDocument>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+struct CacheEntry {
+	PartCopper::Info info;
+	QDateTime fzpModified;
+	QDateTime svgModified;
+	bool ok = false;
+};
+
+static QMutex CacheMutex;
+static QHash<QString, CacheEntry> Cache;			// moduleID and svg path -> what was found
+
+static QStringList missingCopper(ModelPart * modelPart, const QString & layerName, ViewLayer::ViewLayerID viewLayerID, const QDomElement & root) {
+	QDomElement copperElement = TextUtils::findElementWithAttribute(root, "id", layerName);
+	QStringList missing;
+
+	Q_FOREACH (Connector * connector, modelPart->connectors()) {
+		if (connector == nullptr) continue;
+
+		SvgIdLayer * svgIdLayer = connector->fullPinInfo(ViewLayer::PCBView, viewLayerID);
+		if (svgIdLayer == nullptr) {
+			DebugDialog::debug(QString("missing pin info for %1 %2").arg(modelPart->moduleID()).arg(connector->connectorSharedID()));
+			missing << connector->connectorSharedID();
+			continue;
+		}
+
+		QDomElement element = TextUtils::findElementWithAttribute(copperElement, "id", svgIdLayer->m_svgId);
+		if (element.isNull()) {
+			missing << connector->connectorSharedID();
+		}
+	}
+
+	return missing;
+}
+
+static bool readInfo(ModelPart * modelPart, const QString & svgPath, PartCopper::Info & info) {
+	QString fzpPath = modelPart->path();
+	QFile file(fzpPath);
+	if (!file.open(QFile::ReadOnly)) {
+		DebugDialog::debug(QString("unable to open %1").arg(fzpPath));
+		return false;
+	}
+
+	QString fzp = file.readAll();
+	file.close();
+
+	info.copper0 = fzp.contains("copper0");
+	info.copper1 = fzp.contains("copper1");
+	if (!info.copper1 && !info.copper0) return true;
+
+	QFile file2(svgPath);
+	if (!file2.open(QFile::ReadOnly)) {
+		DebugDialog::debug(QString("part svg file open failure %1").arg(svgPath));
+		return false;
+	}
+
+	QString svg = file2.readAll();
+	file2.close();
+
+	QDomDocument doc;
+	QString errorStr;
+	auto errorLine = 0;
+	auto errorColumn = 0;
+	if (!doc.setContent(svg, &errorStr, &errorLine, &errorColumn)) {
+		DebugDialog::debug(QString("part svg xml failure %1 %2 %3 %4").arg(svgPath).arg(errorStr).arg(errorLine).arg(errorColumn));
+		return false;
+	}
+
+	QDomElement root = doc.documentElement();
+	if (info.copper0) info.missing0 = missingCopper(modelPart, "copper0", ViewLayer::Copper0, root);
+	if (info.copper1) info.missing1 = missingCopper(modelPart, "copper1", ViewLayer::Copper1, root);
+	return true;
+}
+
+bool PartCopper::info(ModelPart * modelPart, const QString & svgPath, Info & info) {
+	// a stat of each file is all a part already seen costs
+	QDateTime fzpModified = QFileInfo(modelPart->path()).lastModified();
+	QDateTime svgModified = QFileInfo(svgPath).lastModified();
+	QString key = modelPart->moduleID() + '\n' + svgPath;
+
+	{
+		QMutexLocker locker(&CacheMutex);
+		auto it = Cache.constFind(key);
+		if (it != Cache.constEnd() && it->fzpModified == fzpModified && it->svgModified == svgModified) {
+			info = it->info;
+			return it->ok;
+		}
+	}
+
+	CacheEntry entry;
+	entry.fzpModified = fzpModified;
+	entry.svgModified = svgModified;
+	entry.ok = readInfo(modelPart, svgPath, entry.info);
+
+	QMutexLocker locker(&CacheMutex);
+	Cache.insert(key, entry);
+	info = entry.info;
+	return entry.ok;
+}
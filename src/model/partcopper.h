@@ -0,0 +1,47 @@
+/*******************************************************************
+
+Part of the Fritzing project - http://fritzing.org
+Copyright (c) 2007-2019 Fritzing
+
+Fritzing is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Fritzing is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
+
+********************************************************************/
+
+#ifndef PARTCOPPER_H
+#define PARTCOPPER_H
+
+#include <QString>
+#include <QStringList>
+
+class ModelPart;
+
+// Which copper layers a part's fzp mentions, and which of its connectors have no element in those
+// layers of its pcb svg.  Working that out means reading both files, so the answer is kept for the
+// life of the process, per moduleID and svg, and only worked out again when either file changes.
+
+class PartCopper
+{
+public:
+	struct Info {
+		bool copper0 = false;
+		bool copper1 = false;
+		QStringList missing0;			// connector ids, for the layers the fzp mentions
+		QStringList missing1;
+	};
+
+	// false when a file could not be read or parsed
+	static bool info(ModelPart *, const QString & svgPath, Info &);
+};
+
+#endif
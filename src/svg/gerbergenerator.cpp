@@ -18,14 +18,15 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 
 ********************************************************************/
 
-#include <QBuffer>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QSvgRenderer>
+#include <QtConcurrentRun>
 #include <qmath.h>
 
 #include "gerbergenerator.h"
 
+#include "../autoroute/pixelscan.h"
 #include "../connectors/connectoritem.h"
 #include "../connectors/svgidlayer.h"
 #include "../debugdialog.h"
@@ -57,17 +58,16 @@ const double GerberGenerator::MaskClearanceMils = 5;
 
 ////////////////////////////////////////////
 
-bool pixelsCollide(QImage * image1, QImage * image2, int x1, int y1, int x2, int y2) {
+bool pixelsCollide(const QImage * image1, const QImage * image2, int x1, int y1, int x2, int y2) {
+	// both are Format_Mono and the same size, so this is the DRC's scanline test, stopping at the first hit
+	x1 = qMax(x1, 0);
+	y1 = qMax(y1, 0);
+	x2 = qMin(x2, image1->width());
+	y2 = qMin(y2, image1->height());
+	int bytesPerLine = image1->bytesPerLine();
+	int x;
 	for (int y = y1; y < y2; y++) {
-		for (int x = x1; x < x2; x++) {
-			QRgb p1 = image1->pixel(x, y);
-			if (p1 == 0xffffffff) continue;
-
-			QRgb p2 = image2->pixel(x, y);
-			if (p2 == 0xffffffff) continue;
-
-			//DebugDialog::debug(QString("p1:%1 p2:%2").arg(p1, 0, 16).arg(p2, 0, 16));
-
+		if (PixelScan::collisions(image1->constScanLine(y), image2->constScanLine(y), bytesPerLine, x1, x2, nullptr, 0, &x, 1, true) > 0) {
 			return true;
 		}
 	}
@@ -94,105 +94,166 @@ void GerberGenerator::exportToGerber(const QString & prefix, const QString & exp
 
 	exportPickAndPlace(prefix, exportDir, board, sketchWidget, displayMessageBoxes);
 
-	LayerList viewLayerIDs = ViewLayer::copperLayers(ViewLayer::NewBottom);
-	int copperInvalidCount = doCopper(board, sketchWidget, viewLayerIDs, "Copper0", CopperBottomSuffix, prefix, exportDir, displayMessageBoxes);
-
-	if (sketchWidget->boardLayers() == 2) {
-		viewLayerIDs = ViewLayer::copperLayers(ViewLayer::NewTop);
-		copperInvalidCount += doCopper(board, sketchWidget, viewLayerIDs, "Copper1", CopperTopSuffix, prefix, exportDir, displayMessageBoxes);
-	}
+	QRectF boardRect = board->sceneBoundingRect();
+	boardRect.moveTo(0, 0);
+	int boardLayers = sketchWidget->boardLayers();
 
-	LayerList maskLayerIDs = ViewLayer::maskLayers(ViewLayer::NewBottom);
-	QString maskBottom, maskTop;
-	int maskInvalidCount = doMask(maskLayerIDs, "Mask0", MaskBottomSuffix, board, sketchWidget, prefix, exportDir, displayMessageBoxes, maskBottom);
+	// everything that needs the sketch happens here on the gui thread; the layers are clipped, converted and saved afterwards
+	QVector<LayerJob> jobs;
 
-	if (sketchWidget->boardLayers() == 2) {
-		maskLayerIDs = ViewLayer::maskLayers(ViewLayer::NewTop);
-		maskInvalidCount += doMask(maskLayerIDs, "Mask1", MaskTopSuffix, board, sketchWidget, prefix, exportDir, displayMessageBoxes, maskTop);
+	doCopper(board, sketchWidget, ViewLayer::copperLayers(ViewLayer::NewBottom), "Copper0", CopperBottomSuffix, displayMessageBoxes, jobs);
+	if (boardLayers == 2) {
+		doCopper(board, sketchWidget, ViewLayer::copperLayers(ViewLayer::NewTop), "Copper1", CopperTopSuffix, displayMessageBoxes, jobs);
 	}
 
-	maskLayerIDs = ViewLayer::maskLayers(ViewLayer::NewBottom);
-	int pasteMaskInvalidCount = doPasteMask(maskLayerIDs, "PasteMask0", PasteMaskBottomSuffix, board, sketchWidget, prefix, exportDir, displayMessageBoxes);
+	int maskBottom = doMask(ViewLayer::maskLayers(ViewLayer::NewBottom), "Mask0", MaskBottomSuffix, board, sketchWidget, displayMessageBoxes, jobs);
+	int maskTop = -1;
+	if (boardLayers == 2) {
+		maskTop = doMask(ViewLayer::maskLayers(ViewLayer::NewTop), "Mask1", MaskTopSuffix, board, sketchWidget, displayMessageBoxes, jobs);
+	}
 
-	if (sketchWidget->boardLayers() == 2) {
-		maskLayerIDs = ViewLayer::maskLayers(ViewLayer::NewTop);
-		pasteMaskInvalidCount += doPasteMask(maskLayerIDs, "PasteMask1", PasteMaskTopSuffix, board, sketchWidget, prefix, exportDir, displayMessageBoxes);
+	doPasteMask(ViewLayer::maskLayers(ViewLayer::NewBottom), "PasteMask0", PasteMaskBottomSuffix, board, sketchWidget, displayMessageBoxes, jobs);
+	if (boardLayers == 2) {
+		doPasteMask(ViewLayer::maskLayers(ViewLayer::NewTop), "PasteMask1", PasteMaskTopSuffix, board, sketchWidget, displayMessageBoxes, jobs);
 	}
 
-	LayerList silkLayerIDs = ViewLayer::silkLayers(ViewLayer::NewTop);
-	int silkInvalidCount = doSilk(silkLayerIDs, "Silk1", SilkTopSuffix, board, sketchWidget, prefix, exportDir, displayMessageBoxes, maskTop);
-	silkLayerIDs = ViewLayer::silkLayers(ViewLayer::NewBottom);
-	silkInvalidCount += doSilk(silkLayerIDs, "Silk0", SilkBottomSuffix, board, sketchWidget, prefix, exportDir, displayMessageBoxes, maskBottom);
+	// the silkscreen is clipped by the mask on its side
+	doSilk(ViewLayer::silkLayers(ViewLayer::NewTop), "Silk1", SilkTopSuffix, board, sketchWidget, displayMessageBoxes, maskTop, jobs);
+	doSilk(ViewLayer::silkLayers(ViewLayer::NewBottom), "Silk0", SilkBottomSuffix, board, sketchWidget, displayMessageBoxes, maskBottom, jobs);
 
 	// now do it for the outline/contour
-	LayerList outlineLayerIDs = ViewLayer::outlineLayers();
 	bool empty;
-	QString svgOutline = renderTo(outlineLayerIDs, board, sketchWidget, empty);
-	if (empty || svgOutline.isEmpty()) {
+	QString svgOutline = renderTo(ViewLayer::outlineLayers(), board, sketchWidget, empty);
+	bool outlineEmpty = empty || svgOutline.isEmpty();
+	if (outlineEmpty) {
 		displayMessage(QObject::tr("outline is empty"), displayMessageBoxes);
-		return;
+	}
+	else {
+		// at this point svgOutline must be a single element; a path element may contain cutouts
+		LayerJob job;
+		job.svg = cleanOutline(svgOutline);
+		job.svgSize = TextUtils::parseForWidthAndHeight(job.svg) * GraphicsUtils::StandardFritzingDPI;
+		job.layerName = "contour";
+		job.clipName = "board";
+		job.suffix = OutlineSuffix;
+		job.forWhy = SVG2gerber::ForOutline;
+		job.invalidIn = QObject::tr("the board outline layer");
+		jobs << job;
+
+		doDrill(board, sketchWidget, displayMessageBoxes, jobs);
+	}
+
+	runLayers(jobs, boardRect, boardLayers, exportDir, prefix);
+
+	QStringList invalidIn;
+	Q_FOREACH (const LayerJob & job, jobs) {
+		Q_FOREACH (const QString & message, job.messages) {
+			displayMessage(message, displayMessageBoxes);
+		}
+		if (job.invalidCount > 0 && !job.invalidIn.isEmpty() && !invalidIn.contains(job.invalidIn)) {
+			invalidIn << job.invalidIn;
+		}
 	}
 
-	svgOutline = cleanOutline(svgOutline);
-	// at this point svgOutline must be a single element; a path element may contain cutouts
-	QMultiHash<long, ConnectorItem *> treatAsCircle;
-	svgOutline = clipToBoard(svgOutline, board, "board", SVG2gerber::ForOutline, "", displayMessageBoxes, treatAsCircle);
-	QSizeF svgSize = TextUtils::parseForWidthAndHeight(svgOutline);
-
-	// create outline gerber from svg
-	SVG2gerber outlineGerber;
-	int outlineInvalidCount = outlineGerber.convert(svgOutline, sketchWidget->boardLayers() == 2, "contour", SVG2gerber::ForOutline, svgSize * GraphicsUtils::StandardFritzingDPI);
-
-	//DebugDialog::debug(QString("outline output: %1").arg(outlineGerber.getGerber()));
-	saveEnd("contour", exportDir, prefix, OutlineSuffix, displayMessageBoxes, outlineGerber);
-
-	doDrill(board, sketchWidget, prefix, exportDir, displayMessageBoxes);
-
-	if (outlineInvalidCount > 0 || silkInvalidCount > 0 || copperInvalidCount > 0 || (maskInvalidCount != 0) || (pasteMaskInvalidCount != 0)) {
-		QString s;
-		if (outlineInvalidCount > 0) s += QObject::tr("the board outline layer, ");
-		if (silkInvalidCount > 0) s += QObject::tr("silkscreen layer(s), ");
-		if (copperInvalidCount > 0) s += QObject::tr("copper layer(s), ");
-		if (maskInvalidCount > 0) s += QObject::tr("mask layer(s), ");
-		if (pasteMaskInvalidCount > 0) s += QObject::tr("paste mask layer(s), ");
-		s.chop(2);
-		displayMessage(QObject::tr("Unable to translate svg curves in %1").arg(s), displayMessageBoxes);
+	if (outlineEmpty) return;
+
+	if (invalidIn.count() > 0) {
+		displayMessage(QObject::tr("Unable to translate svg curves in %1").arg(invalidIn.join(", ")), displayMessageBoxes);
 	}
 
 }
 
-int GerberGenerator::doCopper(ItemBase * board, PCBSketchWidget * sketchWidget, LayerList & viewLayerIDs, const QString & copperName, const QString & copperSuffix, const QString & filename, const QString & exportDir, bool displayMessageBoxes)
+void GerberGenerator::runLayers(QVector<LayerJob> & jobs, const QRectF & boardRect, int boardLayers, const QString & exportDir, const QString & prefix)
 {
-	bool empty;
-	QString svg = renderTo(viewLayerIDs, board, sketchWidget, empty);
-	if (empty || svg.isEmpty()) {
-		displayMessage(QObject::tr("%1 layer export is empty.").arg(copperName), displayMessageBoxes);
-		return 0;
+	// a layer clipped by another runs after it in the same task; every other layer is a task of its own
+	QList< QList<int> > tasks;
+	for (int i = 0; i < jobs.count(); i++) {
+		if (jobs.at(i).clipBy >= 0) continue;
+
+		QList<int> task;
+		task << i;
+		for (int j = i + 1; j < jobs.count(); j++) {
+			if (jobs.at(j).clipBy == i) task << j;
+		}
+		tasks << task;
 	}
 
-	QMultiHash<long, ConnectorItem *> treatAsCircle;
+	DebugDialog::debug(QString("gerber export: %1 layers in %2 tasks").arg(jobs.count()).arg(tasks.count()));
+
+	LayerJob * data = jobs.data();			// detach here, not on the workers
+	QList< QFuture<void> > futures;
+	Q_FOREACH (const QList<int> & task, tasks) {
+		futures << QtConcurrent::run([data, task, boardRect, boardLayers, exportDir, prefix]() {
+			Q_FOREACH (int i, task) {
+				LayerJob & job = data[i];
+				runLayer(job, job.clipBy >= 0 ? data[job.clipBy].clipped : QString(), boardRect, boardLayers, exportDir, prefix);
+			}
+		});
+	}
+
+	Q_FOREACH (QFuture<void> future, futures) {
+		future.waitForFinished();
+	}
+}
+
+void GerberGenerator::runLayer(LayerJob & job, const QString & clipString, QRectF boardRect, int boardLayers, const QString & exportDir, const QString & prefix)
+{
+	QString svg = clipToBoard(job.svg, boardRect, job.clipName, job.forWhy, clipString, job.messages, job.donuts);
+	if (svg.isEmpty() && !job.failureMessage.isEmpty()) {
+		job.messages << job.failureMessage;
+		return;
+	}
+
+	job.clipped = svg;
+	job.invalidCount = doEnd(svg, boardLayers, job.layerName, job.forWhy, job.svgSize, exportDir, prefix, job.suffix, job.messages);
+}
+
+GerberGenerator::Donuts GerberGenerator::collectDonuts(ItemBase * board, PCBSketchWidget * sketchWidget)
+{
+	Donuts donuts;
 	Q_FOREACH (QGraphicsItem * item, sketchWidget->scene()->collidingItems(board)) {
 		auto * connectorItem = dynamic_cast<ConnectorItem *>(item);
 		if (connectorItem == nullptr) continue;
 		if (!connectorItem->isPath()) continue;
 		if (connectorItem->radius() == 0) continue;
 
-		treatAsCircle.insert(connectorItem->attachedToID(), connectorItem);
+		ItemBase * itemBase = connectorItem->attachedTo();
+		SvgIdLayer * svgIdLayer = connectorItem->connector()->fullPinInfo(itemBase->viewID(), itemBase->viewLayerID());
+		if (svgIdLayer == nullptr) continue;
+
+		Donut donut;
+		donut.svgId = svgIdLayer->m_svgId;
+		donut.radius = connectorItem->radius();
+		donut.strokeWidth = connectorItem->strokeWidth();
+		donuts.insert(connectorItem->attachedToID(), donut);
 	}
 
-	QSizeF svgSize = TextUtils::parseForWidthAndHeight(svg);
+	return donuts;
+}
 
-	svg = clipToBoard(svg, board, copperName, SVG2gerber::ForCopper, "", displayMessageBoxes, treatAsCircle);
-	if (svg.isEmpty()) {
-		displayMessage(QObject::tr("%1 layer export is empty (case 2).").arg(copperName), displayMessageBoxes);
-		return 0;
+void GerberGenerator::doCopper(ItemBase * board, PCBSketchWidget * sketchWidget, const LayerList & viewLayerIDs, const QString & copperName, const QString & copperSuffix, bool displayMessageBoxes, QVector<LayerJob> & jobs)
+{
+	bool empty;
+	QString svg = renderTo(viewLayerIDs, board, sketchWidget, empty);
+	if (empty || svg.isEmpty()) {
+		displayMessage(QObject::tr("%1 layer export is empty.").arg(copperName), displayMessageBoxes);
+		return;
 	}
 
-	return doEnd(svg, sketchWidget->boardLayers(), copperName, SVG2gerber::ForCopper, svgSize * GraphicsUtils::StandardFritzingDPI, exportDir, filename, copperSuffix, displayMessageBoxes);
+	LayerJob job;
+	job.svg = svg;
+	job.svgSize = TextUtils::parseForWidthAndHeight(svg) * GraphicsUtils::StandardFritzingDPI;
+	job.layerName = job.clipName = copperName;
+	job.suffix = copperSuffix;
+	job.forWhy = SVG2gerber::ForCopper;
+	job.donuts = collectDonuts(board, sketchWidget);
+	job.failureMessage = QObject::tr("%1 layer export is empty (case 2).").arg(copperName);
+	job.invalidIn = QObject::tr("copper layer(s)");
+	jobs << job;
 }
 
 
-int GerberGenerator::doSilk(LayerList silkLayerIDs, const QString & silkName, const QString & gerberSuffix, ItemBase * board, PCBSketchWidget * sketchWidget, const QString & filename, const QString & exportDir, bool displayMessageBoxes, const QString & clipString)
+void GerberGenerator::doSilk(const LayerList & silkLayerIDs, const QString & silkName, const QString & gerberSuffix, ItemBase * board, PCBSketchWidget * sketchWidget, bool displayMessageBoxes, int clipBy, QVector<LayerJob> & jobs)
 {
 
 	bool empty;
@@ -201,7 +262,7 @@ int GerberGenerator::doSilk(LayerList silkLayerIDs, const QString & silkName, co
 		if (silkLayerIDs.contains(ViewLayer::Silkscreen1)) {
 			displayMessage(QObject::tr("silk layer %1 export is empty").arg(silkName), displayMessageBoxes);
 		}
-		return 0;
+		return;
 	}
 
 	//QFile f(silkName + "original.svg");
@@ -210,26 +271,20 @@ int GerberGenerator::doSilk(LayerList silkLayerIDs, const QString & silkName, co
 	//fs << svgSilk;
 	//f.close();
 
-	QSizeF svgSize = TextUtils::parseForWidthAndHeight(svgSilk);
-
-	QMultiHash<long, ConnectorItem *> treatAsCircle;
-	svgSilk = clipToBoard(svgSilk, board, silkName, SVG2gerber::ForSilk, clipString, displayMessageBoxes, treatAsCircle);
-	if (svgSilk.isEmpty()) {
-		displayMessage(QObject::tr("silk export failure"), displayMessageBoxes);
-		return 0;
-	}
-
-	//QFile f2(silkName + "clipped.svg");
-	//f2.open(QFile::WriteOnly);
-	//QTextStream fs2(&f2);
-	//fs2 << svgSilk;
-	//f2.close();
-
-	return doEnd(svgSilk, sketchWidget->boardLayers(), silkName, SVG2gerber::ForSilk, svgSize * GraphicsUtils::StandardFritzingDPI, exportDir, filename, gerberSuffix, displayMessageBoxes);
+	LayerJob job;
+	job.svg = svgSilk;
+	job.svgSize = TextUtils::parseForWidthAndHeight(svgSilk) * GraphicsUtils::StandardFritzingDPI;
+	job.layerName = job.clipName = silkName;
+	job.suffix = gerberSuffix;
+	job.forWhy = SVG2gerber::ForSilk;
+	job.clipBy = clipBy;
+	job.failureMessage = QObject::tr("silk export failure");
+	job.invalidIn = QObject::tr("silkscreen layer(s)");
+	jobs << job;
 }
 
 
-int GerberGenerator::doDrill(ItemBase * board, PCBSketchWidget * sketchWidget, const QString & filename, const QString & exportDir, bool displayMessageBoxes)
+void GerberGenerator::doDrill(ItemBase * board, PCBSketchWidget * sketchWidget, bool displayMessageBoxes, QVector<LayerJob> & jobs)
 {
 	LayerList drillLayerIDs;
 	drillLayerIDs << ViewLayer::drillLayers();
@@ -238,30 +293,22 @@ int GerberGenerator::doDrill(ItemBase * board, PCBSketchWidget * sketchWidget, c
 	QString svgDrill = renderTo(drillLayerIDs, board, sketchWidget, empty);
 	if (empty || svgDrill.isEmpty()) {
 		displayMessage(QObject::tr("exported drill file is empty"), displayMessageBoxes);
-		return 0;
-	}
-
-	QSizeF svgSize = TextUtils::parseForWidthAndHeight(svgDrill);
-	QMultiHash<long, ConnectorItem *> treatAsCircle;
-	Q_FOREACH (QGraphicsItem * item, sketchWidget->scene()->collidingItems(board)) {
-		auto * connectorItem = dynamic_cast<ConnectorItem *>(item);
-		if (connectorItem == nullptr) continue;
-		if (!connectorItem->isPath()) continue;
-		if (connectorItem->radius() == 0) continue;
-
-		treatAsCircle.insert(connectorItem->attachedToID(), connectorItem);
-	}
-
-	svgDrill = clipToBoard(svgDrill, board, "Copper0", SVG2gerber::ForDrill, "", displayMessageBoxes, treatAsCircle);
-	if (svgDrill.isEmpty()) {
-		displayMessage(QObject::tr("drill export failure"), displayMessageBoxes);
-		return 0;
+		return;
 	}
 
-	return doEnd(svgDrill, sketchWidget->boardLayers(), "drill", SVG2gerber::ForDrill, svgSize * GraphicsUtils::StandardFritzingDPI, exportDir, filename, DrillSuffix, displayMessageBoxes);
+	LayerJob job;
+	job.svg = svgDrill;
+	job.svgSize = TextUtils::parseForWidthAndHeight(svgDrill) * GraphicsUtils::StandardFritzingDPI;
+	job.layerName = "drill";
+	job.clipName = "Copper0";
+	job.suffix = DrillSuffix;
+	job.forWhy = SVG2gerber::ForDrill;
+	job.donuts = collectDonuts(board, sketchWidget);
+	job.failureMessage = QObject::tr("drill export failure");
+	jobs << job;
 }
 
-int GerberGenerator::doMask(LayerList maskLayerIDs, const QString &maskName, const QString & gerberSuffix, ItemBase * board, PCBSketchWidget * sketchWidget, const QString & filename, const QString & exportDir, bool displayMessageBoxes, QString & clipString)
+int GerberGenerator::doMask(const LayerList & maskLayerIDs, const QString &maskName, const QString & gerberSuffix, ItemBase * board, PCBSketchWidget * sketchWidget, bool displayMessageBoxes, QVector<LayerJob> & jobs)
 {
 	// don't want these in the mask laqyer
 	QList<ItemBase *> copperLogoItems;
@@ -273,30 +320,28 @@ int GerberGenerator::doMask(LayerList maskLayerIDs, const QString &maskName, con
 
 	if (empty || svgMask.isEmpty()) {
 		displayMessage(QObject::tr("exported mask layer %1 is empty").arg(maskName), displayMessageBoxes);
-		return 0;
+		return -1;
 	}
 
 	svgMask = TextUtils::expandAndFill(svgMask, "black", MaskClearanceMils * 2);
 	if (svgMask.isEmpty()) {
 		displayMessage(QObject::tr("%1 mask export failure (2)").arg(maskName), displayMessageBoxes);
-		return 0;
-	}
-
-	QSizeF svgSize = TextUtils::parseForWidthAndHeight(svgMask);
-	QMultiHash<long, ConnectorItem *> treatAsCircle;
-
-	svgMask = clipToBoard(svgMask, board, maskName, SVG2gerber::ForMask, "", displayMessageBoxes, treatAsCircle);
-	if (svgMask.isEmpty()) {
-		displayMessage(QObject::tr("mask export failure"), displayMessageBoxes);
-		return 0;
+		return -1;
 	}
 
-	clipString = svgMask;
-
-	return doEnd(svgMask, sketchWidget->boardLayers(), maskName, SVG2gerber::ForMask, svgSize * GraphicsUtils::StandardFritzingDPI, exportDir, filename, gerberSuffix, displayMessageBoxes);
+	LayerJob job;
+	job.svg = svgMask;
+	job.svgSize = TextUtils::parseForWidthAndHeight(svgMask) * GraphicsUtils::StandardFritzingDPI;
+	job.layerName = job.clipName = maskName;
+	job.suffix = gerberSuffix;
+	job.forWhy = SVG2gerber::ForMask;
+	job.failureMessage = QObject::tr("mask export failure");
+	job.invalidIn = QObject::tr("mask layer(s)");
+	jobs << job;
+	return jobs.count() - 1;
 }
 
-int GerberGenerator::doPasteMask(LayerList maskLayerIDs, const QString &maskName, const QString & gerberSuffix, ItemBase * board, PCBSketchWidget * sketchWidget, const QString & filename, const QString & exportDir, bool displayMessageBoxes)
+void GerberGenerator::doPasteMask(const LayerList & maskLayerIDs, const QString &maskName, const QString & gerberSuffix, ItemBase * board, PCBSketchWidget * sketchWidget, bool displayMessageBoxes, QVector<LayerJob> & jobs)
 {
 	// don't want these in the mask laqyer
 	QList<ItemBase *> copperLogoItems;
@@ -311,42 +356,42 @@ int GerberGenerator::doPasteMask(LayerList maskLayerIDs, const QString &maskName
 
 	if (empty || svgMask.isEmpty()) {
 		displayMessage(QObject::tr("exported paste mask layer is empty"), displayMessageBoxes);
-		return 0;
+		return;
 	}
 
 	svgMask = sketchWidget->makePasteMask(svgMask, board, GraphicsUtils::StandardFritzingDPI, maskLayerIDs);
-	if (svgMask.isEmpty()) return 0;
-
-	QSizeF svgSize = TextUtils::parseForWidthAndHeight(svgMask);
-	QMultiHash<long, ConnectorItem *> treatAsCircle;
-	svgMask = clipToBoard(svgMask, board, maskName, SVG2gerber::ForCopper, "", displayMessageBoxes, treatAsCircle);
-	if (svgMask.isEmpty()) {
-		displayMessage(QObject::tr("mask export failure"), displayMessageBoxes);
-		return 0;
-	}
-
-	return doEnd(svgMask, sketchWidget->boardLayers(), maskName, SVG2gerber::ForCopper, svgSize * GraphicsUtils::StandardFritzingDPI, exportDir, filename, gerberSuffix, displayMessageBoxes);
+	if (svgMask.isEmpty()) return;
+
+	LayerJob job;
+	job.svg = svgMask;
+	job.svgSize = TextUtils::parseForWidthAndHeight(svgMask) * GraphicsUtils::StandardFritzingDPI;
+	job.layerName = job.clipName = maskName;
+	job.suffix = gerberSuffix;
+	job.forWhy = SVG2gerber::ForCopper;
+	job.failureMessage = QObject::tr("mask export failure");
+	job.invalidIn = QObject::tr("paste mask layer(s)");
+	jobs << job;
 }
 
 int GerberGenerator::doEnd(const QString & svg, int boardLayers, const QString & layerName, SVG2gerber::ForWhy forWhy, QSizeF svgSize,
-                           const QString & exportDir, const QString & prefix, const QString & suffix, bool displayMessageBoxes)
+                           const QString & exportDir, const QString & prefix, const QString & suffix, QStringList & messages)
 {
 	// create mask gerber from svg
 	SVG2gerber gerber;
 	int invalidCount = gerber.convert(svg, boardLayers == 2, layerName, forWhy, svgSize);
 
-	saveEnd(layerName, exportDir, prefix, suffix, displayMessageBoxes, gerber);
+	saveEnd(layerName, exportDir, prefix, suffix, gerber, messages);
 
 	return invalidCount;
 }
 
-bool GerberGenerator::saveEnd(const QString & layerName, const QString & exportDir, const QString & prefix, const QString & suffix, bool displayMessageBoxes, SVG2gerber & gerber)
+bool GerberGenerator::saveEnd(const QString & layerName, const QString & exportDir, const QString & prefix, const QString & suffix, SVG2gerber & gerber, QStringList & messages)
 {
 
 	QString outname = exportDir + "/" +  prefix + suffix;
 	QFile out(outname);
 	if (!out.open(QIODevice::WriteOnly | QIODevice::Text)) {
-		displayMessage(QObject::tr("%1 layer: unable to save to '%2'").arg(layerName, outname), displayMessageBoxes);
+		messages << QObject::tr("%1 layer: unable to save to '%2'").arg(layerName, outname);
 		return false;
 	}
 
@@ -368,46 +413,40 @@ void GerberGenerator::displayMessage(const QString & message, bool displayMessag
 	DebugDialog::debug(message);
 }
 
-QString GerberGenerator::imageToHash(const QImage& image) {
-	QElapsedTimer timer;
-	timer.start();
-
-	QByteArray arr;
-	QBuffer buffer(&arr);
-	buffer.open(QIODevice::WriteOnly);
-	image.save(&buffer, "PNG"); // PNG is lossless and this turned out to be MUCH faster than a pixel loop.
-
-	QByteArray hash = QCryptographicHash::hash(arr, QCryptographicHash::Md5);
-	return hash.toHex();
-};
+void GerberGenerator::renderImage(QImage & image, const QByteArray& svg, QRectF & target) {
+	QSvgRenderer renderer(svg);
+	QPainter painter;
+	painter.begin(&image);
+	renderer.render(&painter, target);
+	painter.end();
+	image.invertPixels(); // need white pixels on a black background for GroundPlaneGenerator
+}
 
-void GerberGenerator::repeatedImageRender(QImage & image, const QByteArray& svg, QRectF & target) {
-	QHash<QString, QImage> hashMap;
+void GerberGenerator::checkedImageRender(QImage & image, const QByteArray& svg, QRectF & target) {
+#ifdef QT_NO_DEBUG
+	renderImage(image, svg, target);
+#else
+	QHash<QByteArray, QImage> hashMap;
 	int counter = 0;
-	QString hash;
+	QByteArray hash;
 
-	// Tests show that the rendered images have sometimes gaps of one to roughly eight consecutive pixel on one scanline.
-	// This seems to happen more often on high CPU load.
-	// If we find two identical images, we assume the bug did not occure and continue.
-	// With large images (100 Megapixel) the likelihood increases, and 5 tries might not be enough, in which case we currently ignore the issue and just use one of the images.
+	// Rendered images used to have gaps of one to roughly eight consecutive pixels on one scanline, more often under high CPU load.
+	// Release builds render once; debug builds render until two images are identical, and say so when one is not,
+	// so a regression shows up in the debug log.  After 6 tries one of the images is used anyway.
+	// The images are compared by a hash of their raw bits, which is much cheaper than encoding them.
 	while (true) {
 		QImage tempImage = image;
-		QSvgRenderer renderer(svg);
-		QPainter painter;
-		painter.begin(&tempImage);
-		renderer.render(&painter, target);
-		painter.end();
-		tempImage.invertPixels(); // need white pixels on a black background for GroundPlaneGenerator
-		hash = imageToHash(tempImage);
+		renderImage(tempImage, svg, target);
+		hash = GraphicsUtils::imageBitsHash(tempImage);
 		if (hashMap.contains(hash)) {
 			break;
 		} else {
 			if (counter > 0) {
-				DebugDialog::debug(QString("Gerbergenerator: Image not in hash. count: %1 hash: %2").arg(counter).arg(hash));
+				DebugDialog::debug(QString("Gerbergenerator: Image not in hash. count: %1 hash: %2").arg(counter).arg(QString(hash)));
 			}
 			hashMap.insert(hash, tempImage);
 			if (counter >= 5) {
-				DebugDialog::debug(QString("Gerbergenerator: Too many tries to find identical image. Aborting loop. count: %1 hash: %2").arg(counter).arg(hash));
+				DebugDialog::debug(QString("Gerbergenerator: Too many tries to find identical image. Aborting loop. count: %1 hash: %2").arg(counter).arg(QString(hash)));
 				break;
 			}
 			counter++;
@@ -415,15 +454,10 @@ void GerberGenerator::repeatedImageRender(QImage & image, const QByteArray& svg,
 	}
 
 	image = hashMap.value(hash);
+#endif
 }
 
-QString GerberGenerator::clipToBoard(QString svgString, ItemBase * board, const QString & layerName, SVG2gerber::ForWhy forWhy, const QString & clipString, bool displayMessageBoxes, QMultiHash<long, ConnectorItem *> & treatAsCircle) {
-	QRectF source = board->sceneBoundingRect();
-	source.moveTo(0, 0);
-	return clipToBoard(svgString, source, layerName, forWhy, clipString, displayMessageBoxes, treatAsCircle);
-}
-
-QString GerberGenerator::clipToBoard(QString svgString, QRectF & boardRect, const QString & layerName, SVG2gerber::ForWhy forWhy, const QString & clipString, bool displayMessageBoxes, QMultiHash<long, ConnectorItem *> & treatAsCircle) {
+QString GerberGenerator::clipToBoard(QString svgString, QRectF & boardRect, const QString & layerName, SVG2gerber::ForWhy forWhy, const QString & clipString, QStringList & messages, const Donuts & donuts) {
 	// document 1 will contain svg that is easy to convert to gerber
 	QDomDocument domDocument1;
 	QString errorStr;
@@ -456,11 +490,11 @@ QString GerberGenerator::clipToBoard(QString svgString, QRectF & boardRect, cons
 		}
 	}
 
-	handleDonuts(root1, treatAsCircle);
+	handleDonuts(root1, donuts);
 
 	bool multipleContours = false;
 	if (forWhy == SVG2gerber::ForOutline) {
-		multipleContours = dealWithMultipleContours(root1, displayMessageBoxes);
+		multipleContours = dealWithMultipleContours(root1, messages);
 	}
 	(void)multipleContours;
 
@@ -569,7 +603,7 @@ QString GerberGenerator::clipToBoard(QString svgString, QRectF & boardRect, cons
 		painter.end();
 
 #ifndef QT_NO_DEBUG
-		clipImage->save(FolderUtils::getTopLevelUserDataStorePath() + "/clip.png");
+		clipImage->save(QString("%1/clip_%2.png").arg(FolderUtils::getTopLevelUserDataStorePath(), layerName));
 #endif
 
 	}
@@ -742,10 +776,10 @@ QString GerberGenerator::clipToBoard(QString svgString, QRectF & boardRect, cons
 			QByteArray svg = TextUtils::removeXMLEntities(domDocument2.toString()).toUtf8();
 			image.fill(0xffffffff);
 
-			repeatedImageRender(image, svg, target);
+			checkedImageRender(image, svg, target);
 
 #ifndef QT_NO_DEBUG
-			image.save(FolderUtils::getTopLevelUserDataStorePath() + "/preclip_output.png");
+			image.save(QString("%1/preclip_output_%2.png").arg(FolderUtils::getTopLevelUserDataStorePath(), layerName));
 #endif
 
 			if (clipImage != nullptr) {
@@ -761,7 +795,7 @@ QString GerberGenerator::clipToBoard(QString svgString, QRectF & boardRect, cons
 			}
 
 #ifndef QT_NO_DEBUG
-			image.save(FolderUtils::getTopLevelUserDataStorePath() + "/output.png");
+			image.save(QString("%1/output_%2.png").arg(FolderUtils::getTopLevelUserDataStorePath(), layerName));
 #endif
 
 			QString path = makePath(image, res / GraphicsUtils::StandardFritzingDPI, "#000000");
@@ -827,10 +861,10 @@ void GerberGenerator::mergeOutlineElement(QImage & image, QRectF & target, doubl
 	image.fill(0xffffffff);
 	QByteArray svg = TextUtils::removeXMLEntities(document.toString()).toUtf8();
 
-	repeatedImageRender(image, svg, target);		// need white pixels on a black background for GroundPlaneGenerator
+	checkedImageRender(image, svg, target);		// need white pixels on a black background for GroundPlaneGenerator
 
 #ifndef QT_NO_DEBUG
-	image.save(QString("%2/output%1.png").arg(ix).arg(FolderUtils::getTopLevelUserDataStorePath()));
+	image.save(QString("%1/output_%2_%3.png").arg(FolderUtils::getTopLevelUserDataStorePath(), layerName).arg(ix));
 #else
 	Q_UNUSED(ix);
 #endif
@@ -893,7 +927,7 @@ QString GerberGenerator::makePath(QImage & image, double unit, const QString & c
 	return path + paths + "' />\n";
 }
 
-bool GerberGenerator::dealWithMultipleContours(QDomElement & root, bool displayMessageBoxes) {
+bool GerberGenerator::dealWithMultipleContours(QDomElement & root, QStringList & messages) {
 	bool multipleContours = false;
 	bool contoursOK = true;
 
@@ -922,7 +956,7 @@ bool GerberGenerator::dealWithMultipleContours(QDomElement & root, bool displayM
 		    QObject::tr("Fritzing is unable to process the cutouts in this custom PCB shape. ") +
 		    QObject::tr("You may need to reload the shape SVG. ") +
 		    QObject::tr("Fritzing requires that you make cutouts using a shape 'subtraction' or 'difference' operation in your vector graphics editor.");
-		displayMessage(msg, displayMessageBoxes);
+		messages << msg;
 		return false;
 	}
 
@@ -1092,19 +1126,17 @@ void GerberGenerator::exportPickAndPlace(const QString & prefix, const QString &
 	out.close();
 }
 
-void GerberGenerator::handleDonuts(QDomElement & root1, QMultiHash<long, ConnectorItem *> & treatAsCircle) {
+void GerberGenerator::handleDonuts(QDomElement & root1, const Donuts & donuts) {
 	// most of this would not be necessary if we cached cleaned SVGs
 
 	static const QString unique("%%%%%%%%%%%%%%%%%%%%%%%%_________________________________%%%%%%%%%%%%%%%%%%%%%%%%%%%%%");
 
 	QDomNodeList nodeList = root1.elementsByTagName("path");
-	if (treatAsCircle.count() > 0) {
+	if (donuts.count() > 0) {
 		QStringList ids;
-		Q_FOREACH (ConnectorItem * connectorItem, treatAsCircle.values()) {
-			ItemBase * itemBase = connectorItem->attachedTo();
-			SvgIdLayer * svgIdLayer = connectorItem->connector()->fullPinInfo(itemBase->viewID(), itemBase->viewLayerID());
-			DebugDialog::debug(QString("treat as circle %1").arg(svgIdLayer->m_svgId));
-			ids << svgIdLayer->m_svgId;
+		Q_FOREACH (const Donut & donut, donuts.values()) {
+			DebugDialog::debug(QString("treat as circle %1").arg(donut.svgId));
+			ids << donut.svgId;
 		}
 
 		for (int n = 0; n < nodeList.count(); n++) {
@@ -1116,33 +1148,31 @@ void GerberGenerator::handleDonuts(QDomElement & root1, QMultiHash<long, Connect
 			if (!ids.contains(id)) continue;
 
 			QString pid;
-			ConnectorItem * connectorItem = nullptr;
+			const Donut * donut = nullptr;
 			for (QDomElement parent = path.parentNode().toElement(); !parent.isNull(); parent = parent.parentNode().toElement()) {
 				pid = parent.attribute("partID");
 				if (pid.isEmpty()) continue;
 
-				QList<ConnectorItem *> connectorItems = treatAsCircle.values(pid.toLong());
-				if (connectorItems.count() == 0) break;
+				auto candidates = donuts.equal_range(pid.toLong());
+				if (candidates.first == candidates.second) break;
 
-				Q_FOREACH (ConnectorItem * candidate, connectorItems) {
-					ItemBase * itemBase = candidate->attachedTo();
-					SvgIdLayer * svgIdLayer = candidate->connector()->fullPinInfo(itemBase->viewID(), itemBase->viewLayerID());
-					if (svgIdLayer->m_svgId == id) {
-						connectorItem = candidate;
+				for (auto candidate = candidates.first; candidate != candidates.second; ++candidate) {
+					if (candidate->svgId == id) {
+						donut = &(*candidate);
 						break;
 					}
 				}
 
-				if (connectorItem != nullptr) break;
+				if (donut != nullptr) break;
 			}
-			if (connectorItem == nullptr) continue;
+			if (donut == nullptr) continue;
 
 			//QString string;
 			//QTextStream stream(&string);
 			//path.save(stream, 0);
 			//DebugDialog::debug("path " + string);
 
-			connectorItem->debugInfo("make path");
+			DebugDialog::debug(QString("make path %1 %2").arg(pid).arg(id));
 			path.setAttribute("id", unique);
 			QSvgRenderer renderer;
 			renderer.load(root1.ownerDocument().toByteArray());
@@ -1155,8 +1185,8 @@ void GerberGenerator::handleDonuts(QDomElement & root1, QMultiHash<long, Connect
 			QPointF p = bounds.center();
 			circle.setAttribute("cx", QString::number(p.x()));
 			circle.setAttribute("cy", QString::number(p.y()));
-			circle.setAttribute("r", QString::number(connectorItem->radius() * GraphicsUtils::StandardFritzingDPI / GraphicsUtils::SVGDPI));
-			circle.setAttribute("stroke-width", QString::number(connectorItem->strokeWidth() * GraphicsUtils::StandardFritzingDPI / GraphicsUtils::SVGDPI));
+			circle.setAttribute("r", QString::number(donut->radius * GraphicsUtils::StandardFritzingDPI / GraphicsUtils::SVGDPI));
+			circle.setAttribute("stroke-width", QString::number(donut->strokeWidth * GraphicsUtils::StandardFritzingDPI / GraphicsUtils::SVGDPI));
 
 		}
 	}
@@ -22,19 +22,33 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 #define GERBERGENERATOR_H
 
 #include <QString>
+#include <QStringList>
+#include <QMultiHash>
+#include <QVector>
 
 #include "../viewlayer.h"
 #include "svg2gerber.h"
 
+class ItemBase;
+class PCBSketchWidget;
+
 class GerberGenerator
 {
 
 public:
-	static void exportToGerber(const QString & prefix, const QString & exportDir, class ItemBase * board, class PCBSketchWidget *, bool displayMessageBoxes);
-	static QString clipToBoard(QString svgString, QRectF & boardRect, const QString & layerName, SVG2gerber::ForWhy, const QString & clipString, bool displayMessageBoxes, QMultiHash<long, class ConnectorItem *> & treatAsCircle);
-	static QString clipToBoard(QString svgString, ItemBase * board, const QString & layerName, SVG2gerber::ForWhy, const QString & clipString, bool displayMessageBoxes, QMultiHash<long, class ConnectorItem *> & treatAsCircle);
+	// a connector drawn as a path that is exported as a round pad, taken from the sketch up front
+	struct Donut {
+		QString svgId;
+		double radius = 0;
+		double strokeWidth = 0;
+	};
+	typedef QMultiHash<long, Donut> Donuts;			// by the id of the part the connector is on
+
+public:
+	static void exportToGerber(const QString & prefix, const QString & exportDir, ItemBase * board, PCBSketchWidget *, bool displayMessageBoxes);
+	static QString clipToBoard(QString svgString, QRectF & boardRect, const QString & layerName, SVG2gerber::ForWhy, const QString & clipString, QStringList & messages, const Donuts & donuts);
 	static int doEnd(const QString & svg, int boardLayers, const QString & layerName, SVG2gerber::ForWhy forWhy, QSizeF svgSize,
-	                 const QString & exportDir, const QString & prefix, const QString & suffix, bool displayMessageBoxes);
+	                 const QString & exportDir, const QString & prefix, const QString & suffix, QStringList & messages);
 	static QString cleanOutline(const QString & svgOutline);
 
 public:
@@ -54,21 +68,44 @@ public:
 	static const double MaskClearanceMils;
 
 protected:
-	static int doSilk(LayerList silkLayerIDs, const QString & silkName, const QString & gerberSuffix, ItemBase * board, PCBSketchWidget * sketchWidget, const QString & filename, const QString & exportDir, bool displayMessageBoxes, const QString & clipString);
-	static int doMask(LayerList maskLayerIDs, const QString & maskName, const QString & gerberSuffix, ItemBase * board, PCBSketchWidget * sketchWidget, const QString & filename, const QString & exportDir, bool displayMessageBoxes, QString & clipString);
-	static int doPasteMask(LayerList maskLayerIDs, const QString & maskName, const QString & gerberSuffix, ItemBase * board, PCBSketchWidget * sketchWidget, const QString & filename, const QString & exportDir, bool displayMessageBoxes);
-	static int doCopper(ItemBase * board, PCBSketchWidget * sketchWidget, LayerList & viewLayerIDs, const QString & copperName, const QString & copperSuffix, const QString & filename, const QString & exportDir, bool displayMessageBoxes);
-	static int doDrill(ItemBase * board, PCBSketchWidget * sketchWidget, const QString & filename, const QString & exportDir, bool displayMessageBoxes);
+	// One gerber file.  Its svg is rendered from the sketch on the gui thread; clipping, conversion
+	// and saving only use what is here, so the layers run on the thread pool side by side.
+	struct LayerJob {
+		QString svg;
+		QSizeF svgSize;
+		QString layerName;
+		QString clipName;						// the layer name while clipping, when it differs
+		QString suffix;
+		SVG2gerber::ForWhy forWhy = SVG2gerber::ForCopper;
+		Donuts donuts;
+		int clipBy = -1;						// the job whose clipped svg clips this one; it runs first, in the same task
+		QString failureMessage;					// when nothing is left after clipping
+		QString invalidIn;						// names the layer when svg curves can't be translated
+
+		QString clipped;
+		int invalidCount = 0;
+		QStringList messages;					// shown on the gui thread once every layer is done
+	};
+
+protected:
+	static void doSilk(const LayerList & silkLayerIDs, const QString & silkName, const QString & gerberSuffix, ItemBase * board, PCBSketchWidget * sketchWidget, bool displayMessageBoxes, int clipBy, QVector<LayerJob> & jobs);
+	static int doMask(const LayerList & maskLayerIDs, const QString & maskName, const QString & gerberSuffix, ItemBase * board, PCBSketchWidget * sketchWidget, bool displayMessageBoxes, QVector<LayerJob> & jobs);
+	static void doPasteMask(const LayerList & maskLayerIDs, const QString & maskName, const QString & gerberSuffix, ItemBase * board, PCBSketchWidget * sketchWidget, bool displayMessageBoxes, QVector<LayerJob> & jobs);
+	static void doCopper(ItemBase * board, PCBSketchWidget * sketchWidget, const LayerList & viewLayerIDs, const QString & copperName, const QString & copperSuffix, bool displayMessageBoxes, QVector<LayerJob> & jobs);
+	static void doDrill(ItemBase * board, PCBSketchWidget * sketchWidget, bool displayMessageBoxes, QVector<LayerJob> & jobs);
+	static void runLayers(QVector<LayerJob> & jobs, const QRectF & boardRect, int boardLayers, const QString & exportDir, const QString & prefix);
+	static void runLayer(LayerJob & job, const QString & clipString, QRectF boardRect, int boardLayers, const QString & exportDir, const QString & prefix);
+	static Donuts collectDonuts(ItemBase * board, PCBSketchWidget * sketchWidget);
 	static void displayMessage(const QString & message, bool displayMessageBoxes);
-	static bool saveEnd(const QString & layerName, const QString & exportDir, const QString & prefix, const QString & suffix, bool displayMessageBoxes, SVG2gerber & gerber);
+	static bool saveEnd(const QString & layerName, const QString & exportDir, const QString & prefix, const QString & suffix, SVG2gerber & gerber, QStringList & messages);
 	static void mergeOutlineElement(QImage & image, QRectF & target, double res, QDomDocument & document, QString & svgString, int ix, const QString & layerName);
 	static QString makePath(QImage & image, double unit, const QString & colorString);
-	static bool dealWithMultipleContours(QDomElement & root, bool displayMessageBoxes);
+	static bool dealWithMultipleContours(QDomElement & root, QStringList & messages);
 	static void exportPickAndPlace(const QString & prefix, const QString & exportDir, ItemBase * board, PCBSketchWidget * sketchWidget, bool displayMessageBoxes);
-	static void handleDonuts(QDomElement & root1, QMultiHash<long, ConnectorItem *> & treatAsCircle);
+	static void handleDonuts(QDomElement & root1, const Donuts & donuts);
 	static QString renderTo(const LayerList &, ItemBase * board, PCBSketchWidget * sketchWidget, bool & empty);
-	static QString imageToHash(const QImage& image);
-	static void repeatedImageRender(QImage & image, const QByteArray& svg, QRectF & target);
+	static void renderImage(QImage & image, const QByteArray& svg, QRectF & target);
+	static void checkedImageRender(QImage & image, const QByteArray& svg, QRectF & target);
 
 };
 
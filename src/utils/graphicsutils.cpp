@@ -23,6 +23,7 @@ along with Fritzing.  If not, see <http://www.gnu.org/licenses/>.
 #include <QList>
 #include <QLineF>
 #include <QBuffer>
+#include <QCryptographicHash>
 #include <QtGlobal>
 #include <qmath.h>
 #include <QtDebug>
@@ -401,6 +402,24 @@ void GraphicsUtils::drawBorder(QImage * image, int border) {
 	painter.end();
 }
 
+QByteArray GraphicsUtils::imageBitsHash(const QImage & image) {
+	// only the bytes that hold pixels: the padding at the end of a scanline is whatever was in memory
+	int bytes = (image.width() * image.depth() + 7) / 8;
+	int spareBits = (bytes * 8) - (image.width() * image.depth());
+	uchar lastMask = image.format() == QImage::Format_MonoLSB ? (0xff >> spareBits) : (0xff << spareBits);
+
+	QCryptographicHash hash(QCryptographicHash::Md5);
+	for (int y = 0; y < image.height(); y++) {
+		const char * line = (const char *) image.constScanLine(y);
+		if (bytes > 1) hash.addData(QByteArray::fromRawData(line, bytes - 1));
+		if (bytes > 0) {
+			char last = line[bytes - 1] & lastMask;
+			hash.addData(QByteArray::fromRawData(&last, 1));
+		}
+	}
+	return hash.result().toHex();
+}
+
 bool almostEqual(qreal a, qreal b) {
 	static qreal nearly = 0.001;
 	return (qAbs(a - b) < nearly);
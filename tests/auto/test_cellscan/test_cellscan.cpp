@@ -0,0 +1,97 @@
+#define BOOST_TEST_MODULE CellScan Tests
+#include <boost/test/included/unit_test.hpp>
+
+#include "autoroute/mazerouter/cellscan.h"
+
+#include <random>
+#include <vector>
+
+/*
+CellScan::blackCells() replaces the per-cell loop of Grid::init4().  reference() is that loop,
+as it was, returning the cells it would have set; both versions must agree bit for bit.
+*/
+
+static std::vector<int> reference(const uchar * bits1, int bytesPerLine, int sx, int width)
+{
+	std::vector<int> cells;
+	for (int ix = sx; ix < sx + width; ix++) {
+		int byteOffset = ix >> 1;
+		uchar mask = ix & 1 ? 0x0f : 0xf0;
+
+		if ((*(bits1 + byteOffset) & mask) != mask) ;
+		else if ((*(bits1 + byteOffset + bytesPerLine) & mask) != mask) ;
+		else if ((*(bits1 + byteOffset + bytesPerLine + bytesPerLine) & mask) != mask) ;
+		else if ((*(bits1 + byteOffset + bytesPerLine + bytesPerLine + bytesPerLine) & mask) != mask) ;
+		else continue;  // "pixel" is all white
+
+		cells.push_back(ix);
+	}
+	return cells;
+}
+
+// a 4-row band of a Format_Mono image, gridWidth cells wide, with 32-bit aligned scanlines like QImage
+struct Band {
+	int bytesPerLine;
+	std::vector<uchar> bits;
+
+	Band(int gridWidth) : bytesPerLine(((gridWidth * 4 + 31) / 32) * 4), bits(bytesPerLine * 4, 0xff) {}
+};
+
+static void check(const Band & band, int sx, int width)
+{
+	std::vector<int> expected = reference(band.bits.data(), band.bytesPerLine, sx, width);
+	std::vector<int> cells(width + 1, -1);
+
+	int count = CellScan::blackCells(band.bits.data(), band.bytesPerLine, sx, width, cells.data());
+	BOOST_REQUIRE_EQUAL(count, (int) expected.size());
+	BOOST_CHECK(std::equal(expected.begin(), expected.end(), cells.begin()));
+
+	count = CellScan::blackCellsWords(band.bits.data(), band.bytesPerLine, sx, width, cells.data());
+	BOOST_REQUIRE_EQUAL(count, (int) expected.size());
+	BOOST_CHECK(std::equal(expected.begin(), expected.end(), cells.begin()));
+}
+
+BOOST_AUTO_TEST_CASE( cellscan_single_bits )
+{
+	// one black bit anywhere in the band, every cell window that contains it and some that do not
+	const int gridWidth = 150;
+	for (int row = 0; row < 4; row++) {
+		for (int bit = 0; bit < gridWidth * 4; bit += 7) {
+			Band band(gridWidth);
+			band.bits[(row * band.bytesPerLine) + (bit >> 3)] &= ~(0x80 >> (bit & 7));
+			check(band, 0, gridWidth);
+			check(band, 1, gridWidth - 1);
+			check(band, bit / 4, 1);
+			check(band, qMax(0, (bit / 4) - 33), qMin(gridWidth - qMax(0, (bit / 4) - 33), 70));
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE( cellscan_random )
+{
+	std::mt19937 random(20240611);
+	for (int round = 0; round < 2000; round++) {
+		int gridWidth = 1 + (random() % 300);
+		Band band(gridWidth);
+		// mostly white, like a board, with runs of black
+		int density = random() % 4;
+		for (uchar & byte : band.bits) {
+			if (density > 0 && (int) (random() % 64) < density) byte = random() & 0xff;
+		}
+		int sx = random() % gridWidth;
+		int width = 1 + (random() % (gridWidth - sx));
+		check(band, sx, width);
+	}
+}
+
+BOOST_AUTO_TEST_CASE( cellscan_all_black_and_all_white )
+{
+	Band white(200);
+	check(white, 0, 200);
+	check(white, 3, 130);
+
+	Band black(200);
+	std::fill(black.bits.begin(), black.bits.end(), 0);
+	check(black, 0, 200);
+	check(black, 5, 67);
+}
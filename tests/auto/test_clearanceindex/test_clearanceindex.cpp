@@ -0,0 +1,67 @@
+#define BOOST_TEST_MODULE ClearanceIndex Tests
+#include <boost/test/included/unit_test.hpp>
+
+#include "autoroute/clearanceindex.h"
+
+#include <QPolygonF>
+
+/*
+Clearance queries used by the maze router's trace optimizer.
+Distances are in scene units; a shape "touches" a trace when the gap is below the trace's half width.
+*/
+
+BOOST_AUTO_TEST_CASE( clearanceindex_distances )
+{
+	QLineF horizontal(0, 0, 10, 0);
+	BOOST_CHECK_CLOSE(ClearanceIndex::pointDistance(QPointF(5, 3), horizontal), 3.0, 1e-9);
+	BOOST_CHECK_CLOSE(ClearanceIndex::pointDistance(QPointF(13, 4), horizontal), 5.0, 1e-9);
+
+	BOOST_CHECK_EQUAL(ClearanceIndex::segmentDistance(horizontal, QLineF(5, -5, 5, 5)), 0.0);
+	BOOST_CHECK_CLOSE(ClearanceIndex::segmentDistance(horizontal, QLineF(0, 2, 10, 2)), 2.0, 1e-9);
+	BOOST_CHECK_CLOSE(ClearanceIndex::segmentDistance(horizontal, QLineF(12, 0, 20, 0)), 2.0, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE( clearanceindex_segments_and_circles )
+{
+	ClearanceIndex index;
+	BOOST_CHECK(index.clears(QLineF(0, 0, 100, 0), 5));
+
+	index.addSegment(QLineF(0, 20, 100, 20), 4, 1);
+	index.addCircle(QPointF(50, -20), 6, 2);
+	BOOST_CHECK_EQUAL(index.count(), 2);
+
+	// 20 apart, radius 4 + half width 5 leaves a gap
+	BOOST_CHECK(index.clears(QLineF(0, 0, 100, 0), 5));
+	BOOST_CHECK(!index.clears(QLineF(0, 0, 100, 0), 17));
+
+	// crossing the segment
+	BOOST_CHECK(!index.clears(QLineF(30, 0, 30, 40), 1));
+	// a net never collides with its own copper
+	BOOST_CHECK(index.clears(QLineF(30, 0, 30, 40), 1, 1));
+	BOOST_CHECK(!index.clears(QLineF(50, 0, 50, -40), 1, 1));
+	BOOST_CHECK(index.clears(QLineF(50, 0, 50, -40), 1, 2));
+
+	index.clear();
+	BOOST_CHECK_EQUAL(index.count(), 0);
+	BOOST_CHECK(index.clears(QLineF(30, 0, 30, 40), 1));
+}
+
+BOOST_AUTO_TEST_CASE( clearanceindex_polygons )
+{
+	ClearanceIndex index;
+	QPolygonF square;
+	square << QPointF(10, 10) << QPointF(20, 10) << QPointF(20, 20) << QPointF(10, 20) << QPointF(10, 10);
+	index.addPolygon(square, Qt::OddEvenFill);
+
+	// entirely inside
+	BOOST_CHECK(!index.clears(QLineF(12, 12, 18, 18), 0.5));
+	// passing by within the half width of an edge
+	BOOST_CHECK(!index.clears(QLineF(0, 8, 30, 8), 3));
+	BOOST_CHECK(index.clears(QLineF(0, 8, 30, 8), 1));
+	// far away, but with a bounding box around the polygon
+	BOOST_CHECK(index.clears(QLineF(0, 0, 30, 0), 1));
+
+	// degenerate polygons are ignored
+	index.addPolygon(QPolygonF() << QPointF(0, 0) << QPointF(5, 5), Qt::OddEvenFill);
+	BOOST_CHECK_EQUAL(index.count(), 1);
+}
@@ -0,0 +1,131 @@
+#define BOOST_TEST_MODULE CopperClearance Tests
+#include <boost/test/included/unit_test.hpp>
+
+#include "autoroute/copperclearance.h"
+
+#include <QPainterPath>
+
+/*
+The polygon DRC's clearance check.
+Distances are in scene units; two shapes overlap when the gap between them is below the keepout.
+*/
+
+static void addTraces(CopperClearance & clearance) {
+	// 10 apart, 2 wide: a gap of 8
+	clearance.addSegment(QLineF(0, 0, 100, 0), 2, 1);
+	clearance.addSegment(QLineF(0, 10, 100, 10), 2, 2);
+}
+
+static void addPads(CopperClearance & clearance) {
+	// the pads are 5 apart, the trace 28 from the round pad and 33 from the square one
+	QPainterPath pad;
+	pad.addEllipse(QPointF(0, 0), 10, 10);
+	clearance.addPath(pad, 1);
+	QPainterPath pad2;
+	pad2.addRect(15, -5, 10, 10);
+	clearance.addPath(pad2, 2);
+	clearance.addSegment(QLineF(-100, 40, 100, 40), 4, 3);
+}
+
+BOOST_AUTO_TEST_CASE( copperclearance_traces )
+{
+	CopperClearance empty(10);
+	BOOST_CHECK(empty.overlaps().isEmpty());
+
+	CopperClearance loose(5);
+	addTraces(loose);
+	BOOST_CHECK_EQUAL(loose.count(), 2);
+	BOOST_CHECK(loose.overlaps().isEmpty());
+
+	CopperClearance tight(10);
+	addTraces(tight);
+	QList<CopperClearance::Overlap> overlaps = tight.overlaps();
+	BOOST_REQUIRE_EQUAL(overlaps.count(), 1);
+	BOOST_CHECK_EQUAL(overlaps.at(0).first, 0);
+	BOOST_CHECK_EQUAL(overlaps.at(0).second, 1);
+	BOOST_REQUIRE(!overlaps.at(0).region.isEmpty());
+	QRectF r = overlaps.at(0).region.at(0).boundingRect();
+	BOOST_CHECK(r.top() > 0 && r.bottom() < 10);
+	BOOST_CHECK(r.left() < 1 && r.right() > 99);
+}
+
+BOOST_AUTO_TEST_CASE( copperclearance_owners )
+{
+	CopperClearance clearance(5);
+	clearance.addSegment(QLineF(0, 0, 100, 0), 2, 1);
+	clearance.addSegment(QLineF(50, -50, 50, 50), 2, 1);		// crossing, same net
+	BOOST_CHECK(clearance.overlaps().isEmpty());
+
+	// copper on no net collides with nets, never with itself
+	QPainterPath logo;
+	logo.addRect(200, 0, 20, 20);
+	clearance.addPath(logo, -1);
+	QPainterPath logo2;
+	logo2.addRect(210, 10, 20, 20);
+	clearance.addPath(logo2, -1);
+	BOOST_CHECK(clearance.overlaps().isEmpty());
+
+	clearance.addSegment(QLineF(190, 30, 240, 30), 2, 3);
+	QList<CopperClearance::Overlap> overlaps = clearance.overlaps();
+	BOOST_REQUIRE_EQUAL(overlaps.count(), 1);
+	BOOST_CHECK_EQUAL(overlaps.at(0).first, 3);
+	BOOST_CHECK_EQUAL(overlaps.at(0).second, 4);
+	BOOST_CHECK_EQUAL(clearance.owner(3), -1);
+	BOOST_CHECK_EQUAL(clearance.owner(4), 3);
+}
+
+BOOST_AUTO_TEST_CASE( copperclearance_pads )
+{
+	CopperClearance loose(4);
+	addPads(loose);
+	BOOST_CHECK(loose.overlaps().isEmpty());
+
+	CopperClearance closer(6);
+	addPads(closer);
+	BOOST_CHECK_EQUAL(closer.overlaps().count(), 1);
+
+	CopperClearance tight(30);
+	addPads(tight);
+	QList<CopperClearance::Overlap> overlaps = tight.overlaps();
+	BOOST_REQUIRE_EQUAL(overlaps.count(), 2);
+	BOOST_CHECK_EQUAL(overlaps.at(0).first, 0);
+	BOOST_CHECK_EQUAL(overlaps.at(0).second, 1);
+	BOOST_CHECK_EQUAL(overlaps.at(1).first, 0);
+	BOOST_CHECK_EQUAL(overlaps.at(1).second, 2);
+}
+
+BOOST_AUTO_TEST_CASE( copperclearance_incremental )
+{
+	CopperClearance clearance(30);
+	addPads(clearance);
+
+	// asking for some owners gives the pairs they are in, each once
+	QSet<int> owners;
+	owners << 3;
+	QList<CopperClearance::Overlap> overlaps = clearance.overlaps(owners);
+	BOOST_REQUIRE_EQUAL(overlaps.count(), 1);
+	BOOST_CHECK_EQUAL(overlaps.at(0).first, 0);
+	BOOST_CHECK_EQUAL(overlaps.at(0).second, 2);
+
+	owners << 1;
+	BOOST_CHECK_EQUAL(clearance.overlaps(owners).count(), 2);
+
+	// move the trace away: the old shape is gone, the new one gets the next index
+	clearance.removeOwner(3);
+	clearance.addSegment(QLineF(-100, 100, 100, 100), 4, 3);
+	BOOST_CHECK_EQUAL(clearance.count(), 4);
+	owners.clear();
+	owners << 3;
+	BOOST_CHECK(clearance.overlaps(owners).isEmpty());
+	overlaps = clearance.overlaps();
+	BOOST_REQUIRE_EQUAL(overlaps.count(), 1);
+	BOOST_CHECK_EQUAL(overlaps.at(0).second, 1);
+
+	// and back
+	clearance.removeOwner(3);
+	clearance.addSegment(QLineF(-100, 40, 100, 40), 4, 3);
+	overlaps = clearance.overlaps(owners);
+	BOOST_REQUIRE_EQUAL(overlaps.count(), 1);
+	BOOST_CHECK_EQUAL(overlaps.at(0).first, 0);
+	BOOST_CHECK_EQUAL(overlaps.at(0).second, 4);
+}
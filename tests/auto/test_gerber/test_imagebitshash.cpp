@@ -0,0 +1,62 @@
+#include <boost/test/unit_test.hpp>
+
+#include "utils/graphicsutils.h"
+
+#include <QImage>
+
+/*
+In debug builds GerberGenerator::checkedImageRender() renders until two images agree, comparing them by
+GraphicsUtils::imageBitsHash().  Only pixels may count: the padding at the end of each scanline
+holds whatever was in memory.
+*/
+
+static QImage monoImage(int width, int height, QImage::Format format) {
+	QImage image(width, height, format);
+	image.fill(0);
+	return image;
+}
+
+BOOST_AUTO_TEST_CASE( imagebitshash_pixels )
+{
+	QImage image = monoImage(37, 5, QImage::Format_Mono);
+	QImage same = monoImage(37, 5, QImage::Format_Mono);
+	BOOST_CHECK(GraphicsUtils::imageBitsHash(image) == GraphicsUtils::imageBitsHash(same));
+
+	// one pixel in the last, partly used byte of a scanline
+	same.setPixel(36, 2, 1);
+	BOOST_CHECK(GraphicsUtils::imageBitsHash(image) != GraphicsUtils::imageBitsHash(same));
+	image.setPixel(36, 2, 1);
+	BOOST_CHECK(GraphicsUtils::imageBitsHash(image) == GraphicsUtils::imageBitsHash(same));
+
+	// a gap in a scanline, as a bad render leaves
+	same.setPixel(3, 4, 1);
+	BOOST_CHECK(GraphicsUtils::imageBitsHash(image) != GraphicsUtils::imageBitsHash(same));
+}
+
+BOOST_AUTO_TEST_CASE( imagebitshash_padding )
+{
+	for (QImage::Format format : { QImage::Format_Mono, QImage::Format_MonoLSB }) {
+		QImage image = monoImage(37, 5, format);
+		QByteArray before = GraphicsUtils::imageBitsHash(image);
+
+		// 37 pixels leave 3 bits of the fifth byte and the three bytes after it unused
+		for (int y = 0; y < image.height(); y++) {
+			uchar * line = image.scanLine(y);
+			line[4] |= format == QImage::Format_Mono ? 0x07 : 0xe0;
+			for (int i = 5; i < image.bytesPerLine(); i++) line[i] = 0xff;
+		}
+		BOOST_CHECK(GraphicsUtils::imageBitsHash(image) == before);
+		BOOST_CHECK_EQUAL(image.pixelIndex(36, 0), 0);
+	}
+}
+
+BOOST_AUTO_TEST_CASE( imagebitshash_deeper )
+{
+	QImage image(10, 3, QImage::Format_ARGB32);
+	image.fill(0xffffffff);
+	QImage copy = image.copy();
+	BOOST_CHECK(GraphicsUtils::imageBitsHash(image) == GraphicsUtils::imageBitsHash(copy));
+	copy.setPixel(9, 2, 0xff000000);
+	BOOST_CHECK(GraphicsUtils::imageBitsHash(image) != GraphicsUtils::imageBitsHash(copy));
+	BOOST_CHECK_EQUAL(GraphicsUtils::imageBitsHash(image).size(), 32);
+}
@@ -0,0 +1,316 @@
+#define BOOST_TEST_MODULE GridQueue Tests
+#include <boost/test/included/unit_test.hpp>
+
+#include "autoroute/mazerouter/gridqueue.h"
+
+#include <QElapsedTimer>
+#include <QVector>
+#include <QtMath>
+
+/*
+Compares the Bucket frontier used by the maze router against the original Heap.
+The expansion is recorded once with the same cost model as MazeRouter::expandOne
+(unit step cost plus squared distance to the target, or plain distance for fractional costs)
+and then replayed into both queues.
+*/
+
+struct Op {
+	bool push;
+	GridPoint gridPoint;
+};
+
+static QVector<Op> recordExpansion(int size, bool fractional = false)
+{
+	QVector<Op> ops;
+	QVector<bool> seen(size * size, false);
+	QPoint target(size - 2, size / 3);
+	std::priority_queue<GridPoint> heap;
+
+	GridPoint start(QPoint(1, size / 2), 0);
+	heap.push(start);
+	ops.append({ true, start });
+	seen[start.y * size + start.x] = true;
+	while (!heap.empty()) {
+		GridPoint gp = heap.top();
+		heap.pop();
+		ops.append({ false, gp });
+		if (gp.x == target.x() && gp.y == target.y()) break;
+
+		static const int dx[] = { -1, 1, 0, 0 };
+		static const int dy[] = { 0, 0, -1, 1 };
+		for (int i = 0; i < 4; i++) {
+			GridPoint next(QPoint(gp.x + dx[i], gp.y + dy[i]), 0);
+			if (next.x <= 0 || next.y <= 0 || next.x >= size - 1 || next.y >= size - 1) continue;
+			if (next.x == size / 2 && next.y > 2) continue;         // a wall to walk around
+			if (seen[next.y * size + next.x]) continue;
+
+			seen[next.y * size + next.x] = true;
+			next.baseCost = gp.baseCost + 1;
+			double ddx = next.x - target.x();
+			double ddy = next.y - target.y();
+			double d = (ddx * ddx) + (ddy * ddy);
+			next.qCost = next.baseCost + (fractional ? qSqrt(d) : d);
+			if (next.x == target.x() && next.y == target.y()) next.flags = GridPointDone;
+			heap.push(next);
+			ops.append({ true, next });
+		}
+	}
+
+	return ops;
+}
+
+static QVector<double> replay(GridQueue & queue, const QVector<Op> & ops, int size)
+{
+	QVector<double> popped;
+	queue.setKind(queue.kind(), size, size);
+	for (const Op & op : ops) {
+		if (op.push) {
+			queue.push(op.gridPoint);
+		}
+		else {
+			popped.append(queue.top().qCost);
+			queue.pop();
+		}
+	}
+	return popped;
+}
+
+BOOST_AUTO_TEST_CASE( gridqueue_roundtrip )
+{
+	GridQueue queue;
+	queue.setKind(GridQueue::Bucket, 300, 200);
+
+	GridPoint gp(QPoint(299, 17), 1);
+	gp.baseCost = 1234;
+	gp.qCost = 5678;
+	gp.flags = GridPointDone;
+	queue.push(gp);
+
+	GridPoint low(QPoint(3, 4), 0);
+	low.qCost = 10;
+	queue.push(low);
+	BOOST_CHECK_EQUAL(queue.size(), 2u);
+
+	GridPoint top = queue.top();
+	BOOST_CHECK_EQUAL(top.x, 3);
+	BOOST_CHECK_EQUAL(top.y, 4);
+	BOOST_CHECK_EQUAL(top.z, 0);
+	queue.pop();
+
+	top = queue.top();
+	BOOST_CHECK_EQUAL(top.x, 299);
+	BOOST_CHECK_EQUAL(top.y, 17);
+	BOOST_CHECK_EQUAL(top.z, 1);
+	BOOST_CHECK_EQUAL(top.baseCost, 1234u);
+	BOOST_CHECK_EQUAL(top.qCost, 5678);
+	BOOST_CHECK_EQUAL(top.flags, GridPointDone);
+	queue.pop();
+	BOOST_REQUIRE(queue.empty());
+}
+
+BOOST_AUTO_TEST_CASE( gridqueue_large_base_cost )
+{
+	// base costs past 32 bits come back whole, as they do from the heap
+	const GridValue costs[] = { Q_UINT64_C(0xffffffff), Q_UINT64_C(0x100000000), Q_UINT64_C(0x123456789abcdef0) };
+	GridQueue::Kind kinds[] = { GridQueue::Heap, GridQueue::Bucket };
+	for (GridQueue::Kind kind : kinds) {
+		GridQueue queue;
+		queue.setKind(kind, 10, 10);
+		for (int i = 0; i < 3; i++) {
+			GridPoint gp(QPoint(i, 0), 0);
+			gp.baseCost = costs[i];
+			gp.qCost = i + 0.5;
+			queue.push(gp);
+		}
+		for (int i = 0; i < 3; i++) {
+			BOOST_CHECK_EQUAL(queue.top().baseCost, costs[i]);
+			queue.pop();
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE( gridqueue_lower_cost_after_pop )
+{
+	// the A* estimate makes queue costs non-monotone
+	GridQueue queue;
+	queue.setKind(GridQueue::Bucket, 10, 10);
+	GridPoint a(QPoint(1, 1), 0);
+	a.qCost = 50;
+	queue.push(a);
+	GridPoint b(QPoint(2, 1), 0);
+	b.qCost = 40;
+	queue.push(b);
+	BOOST_CHECK_EQUAL(queue.top().qCost, 40);
+	queue.pop();
+
+	GridPoint c(QPoint(3, 1), 0);
+	c.qCost = 20;
+	queue.push(c);
+	BOOST_CHECK_EQUAL(queue.top().qCost, 20);
+	queue.pop();
+	BOOST_CHECK_EQUAL(queue.top().qCost, 50);
+}
+
+BOOST_AUTO_TEST_CASE( gridqueue_fractional_costs )
+{
+	// costs that differ only in their fraction pop in order, and come back unchanged
+	GridQueue queue;
+	queue.setKind(GridQueue::Bucket, 10, 10);
+	const double costs[] = { 10.75, 10.25, 10.5, 0.125, 10.25, 11, 10 };
+	for (int i = 0; i < 7; i++) {
+		GridPoint gp(QPoint(i, 0), 0);
+		gp.qCost = costs[i];
+		queue.push(gp);
+	}
+
+	const double expected[] = { 0.125, 10, 10.25, 10.25, 10.5, 10.75, 11 };
+	for (double cost : expected) {
+		BOOST_REQUIRE(!queue.empty());
+		BOOST_CHECK_EQUAL(queue.top().qCost, cost);
+		queue.pop();
+	}
+	BOOST_CHECK(queue.empty());
+}
+
+BOOST_AUTO_TEST_CASE( gridqueue_costs_between_slots )
+{
+	// a queue that starts on a whole-number cost steps by whole units, so fractions share a slot
+	GridQueue queue;
+	queue.setKind(GridQueue::Bucket, 10, 10);
+	const double costs[] = { 20, 7.3, 7, 7.1, 7.3, 7.2 };
+	for (int i = 0; i < 6; i++) {
+		GridPoint gp(QPoint(i, 0), 0);
+		gp.qCost = costs[i];
+		queue.push(gp);
+	}
+
+	const int expected[] = { 2, 3, 5, 1, 4, 0 };
+	for (int x : expected) {
+		BOOST_REQUIRE(!queue.empty());
+		BOOST_CHECK_EQUAL(queue.top().x, x);
+		BOOST_CHECK_EQUAL(queue.top().qCost, costs[x]);
+		queue.pop();
+	}
+	BOOST_CHECK(queue.empty());
+}
+
+BOOST_AUTO_TEST_CASE( gridqueue_costs_outside_window )
+{
+	// costs too far from the window to fit in it still pop in order
+	GridQueue queue;
+	queue.setKind(GridQueue::Bucket, 10, 10);
+	const double costs[] = { 5000000, 3, 1e12, 4000000.5, 12, 1e300, 1 };
+	for (int i = 0; i < 7; i++) {
+		GridPoint gp(QPoint(i, 0), 0);
+		gp.qCost = costs[i];
+		queue.push(gp);
+	}
+	BOOST_CHECK_EQUAL(queue.size(), 7u);
+
+	const int expected[] = { 6, 1, 4, 3, 0, 2, 5 };
+	for (int x : expected) {
+		BOOST_REQUIRE(!queue.empty());
+		BOOST_CHECK_EQUAL(queue.top().x, x);
+		BOOST_CHECK_EQUAL(queue.top().qCost, costs[x]);
+		queue.pop();
+	}
+	BOOST_CHECK(queue.empty());
+
+	// once the window empties it starts over wherever the next cost is
+	GridPoint gp(QPoint(9, 9), 0);
+	gp.qCost = 1e12;
+	queue.push(gp);
+	BOOST_CHECK_EQUAL(queue.top().qCost, 1e12);
+	queue.pop();
+	BOOST_CHECK(queue.empty());
+}
+
+BOOST_AUTO_TEST_CASE( gridqueue_ties_pop_in_push_order )
+{
+	GridQueue queue;
+	queue.setKind(GridQueue::Bucket, 10, 10);
+	for (int x = 0; x < 4; x++) {
+		GridPoint gp(QPoint(x, 2), 0);
+		gp.qCost = 7.5;
+		queue.push(gp);
+	}
+	GridPoint lower(QPoint(9, 9), 0);
+	lower.qCost = 3;
+	queue.push(lower);
+	BOOST_CHECK_EQUAL(queue.top().x, 9);
+	queue.pop();
+
+	// a bucket that empties and fills again starts over
+	for (int x = 0; x < 4; x++) {
+		BOOST_CHECK_EQUAL(queue.top().x, x);
+		queue.pop();
+	}
+	GridPoint again(QPoint(5, 5), 0);
+	again.qCost = 7.5;
+	queue.push(again);
+	BOOST_CHECK_EQUAL(queue.top().x, 5);
+	queue.pop();
+	BOOST_CHECK(queue.empty());
+
+	// ties on a whole-number cost pop in push order too
+	for (int x = 0; x < 4; x++) {
+		GridPoint gp(QPoint(x, 3), 0);
+		gp.qCost = 12;
+		queue.push(gp);
+	}
+	for (int x = 0; x < 4; x++) {
+		BOOST_CHECK_EQUAL(queue.top().x, x);
+		queue.pop();
+	}
+	BOOST_CHECK(queue.empty());
+}
+
+BOOST_AUTO_TEST_CASE( gridqueue_matches_heap )
+{
+	const int size = 200;
+	bool fractional[] = { false, true };
+	for (bool f : fractional) {
+		QVector<Op> ops = recordExpansion(size, f);
+
+		GridQueue heap;
+		heap.setKind(GridQueue::Heap, size, size);
+		GridQueue bucket;
+		bucket.setKind(GridQueue::Bucket, size, size);
+
+		// ties may pop different cells, but every pop must see the same cost
+		BOOST_CHECK(replay(heap, ops, size) == replay(bucket, ops, size));
+	}
+}
+
+BOOST_AUTO_TEST_CASE( gridqueue_benchmark )
+{
+	const int size = 600;
+	const int repeats = 5;
+	bool fractional[] = { false, true };
+	for (bool f : fractional) {
+		QVector<Op> ops = recordExpansion(size, f);
+
+		// the reused queues must keep giving the heap's answer, and the bucket queue must be no slower.
+		// The fastest of the repeats is compared, to leave out warm-up and scheduling noise
+		QVector<double> expected;
+		qint64 best[2] = { 0, 0 };
+		GridQueue::Kind kinds[] = { GridQueue::Heap, GridQueue::Bucket };
+		for (GridQueue::Kind kind : kinds) {
+			GridQueue queue;
+			queue.setKind(kind, size, size);
+			for (int i = 0; i < repeats; i++) {
+				QElapsedTimer timer;
+				timer.start();
+				QVector<double> popped = replay(queue, ops, size);
+				qint64 elapsed = timer.nsecsElapsed();
+				if (i == 0 || elapsed < best[kind]) best[kind] = elapsed;
+				if (expected.isEmpty()) expected = popped;
+				BOOST_CHECK(popped == expected);
+			}
+			BOOST_TEST_MESSAGE((f ? "fractional " : "whole ") << (kind == GridQueue::Heap ? "heap:   " : "bucket: ")
+			                   << ops.count() << " ops, best of " << repeats << ", " << best[kind] / 1000000.0 << " ms");
+		}
+		BOOST_CHECK(!expected.isEmpty());
+		BOOST_CHECK_LE(best[GridQueue::Bucket], best[GridQueue::Heap]);
+	}
+}
@@ -0,0 +1,144 @@
+#define BOOST_TEST_MODULE GridTiles Tests
+#include <boost/test/included/unit_test.hpp>
+
+#include "autoroute/mazerouter/gridtiles.h"
+
+#include <random>
+#include <vector>
+
+/*
+GridTiles must read back whatever was written, whichever of its tiles are in memory,
+collapsed to a single value or written out to the temporary file at the time.
+*/
+
+struct Reference {
+	int x, y, z;
+	std::vector<quint32> cells;
+
+	Reference(int x, int y, int z) : x(x), y(y), z(z), cells(x * y * z, 0) {}
+	quint32 & at(int ix, int iy, int iz) { return cells[(((iz * y) + iy) * x) + ix]; }
+};
+
+static void checkAll(GridTiles & tiles, Reference & reference)
+{
+	for (int iz = 0; iz < reference.z; iz++) {
+		for (int iy = 0; iy < reference.y; iy++) {
+			for (int ix = 0; ix < reference.x; ix++) {
+				if (tiles.at(ix, iy, iz) != reference.at(ix, iy, iz)) {
+					BOOST_FAIL("cell " << ix << "," << iy << "," << iz << " differs");
+				}
+			}
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE( gridtiles_uniform_tiles_take_no_memory )
+{
+	GridTiles tiles(1000, 1000, 2, 0);
+	BOOST_CHECK_EQUAL(tiles.bytes(), 0);
+	BOOST_CHECK_EQUAL(tiles.at(999, 999, 1), 0u);
+
+	// writing a tile's own value leaves it alone
+	tiles.setAt(10, 10, 0, 0);
+	BOOST_CHECK_EQUAL(tiles.bytes(), 0);
+
+	tiles.setAt(10, 10, 0, 7);
+	BOOST_CHECK_EQUAL(tiles.bytes(), GridTiles::TileBytes);
+	BOOST_CHECK_EQUAL(tiles.at(10, 10, 0), 7u);
+	BOOST_CHECK_EQUAL(tiles.at(10, 10, 1), 0u);
+
+	tiles.copy(0, 1);
+	BOOST_CHECK_EQUAL(tiles.at(10, 10, 1), 7u);
+
+	tiles.clear();
+	BOOST_CHECK_EQUAL(tiles.at(10, 10, 0), 0u);
+	BOOST_CHECK_EQUAL(tiles.at(10, 10, 1), 0u);
+}
+
+BOOST_AUTO_TEST_CASE( gridtiles_eviction_keeps_values )
+{
+	// a 0 budget keeps only MinResidentTiles tiles in memory, of 16 x 11 x 2 (the edge tiles partial)
+	Reference reference(1000, 700, 2);
+	GridTiles tiles(reference.x, reference.y, reference.z, 0);
+	BOOST_CHECK_EQUAL(tiles.residentLimit(), GridTiles::MinResidentTiles);
+
+	std::mt19937 random(1);
+	for (int i = 0; i < 200000; i++) {
+		int ix = random() % reference.x;
+		int iy = random() % reference.y;
+		int iz = random() % reference.z;
+		switch (random() % 100) {
+			case 0:
+				tiles.copy(0, 1);
+				std::copy(reference.cells.begin(), reference.cells.begin() + (reference.x * reference.y), reference.cells.begin() + (reference.x * reference.y));
+				break;
+			case 1:
+				if (random() % 10 == 0) {
+					tiles.clear();
+					std::fill(reference.cells.begin(), reference.cells.end(), 0);
+				}
+				break;
+			default:
+				if (random() % 2) {
+					quint32 value = (random() % 3 == 0) ? 0 : random() % 5;
+					tiles.setAt(ix, iy, iz, value);
+					reference.at(ix, iy, iz) = value;
+				}
+				else if (tiles.at(ix, iy, iz) != reference.at(ix, iy, iz)) {
+					BOOST_FAIL("cell " << ix << "," << iy << "," << iz << " differs after " << i << " steps");
+				}
+				break;
+		}
+	}
+
+	BOOST_CHECK(tiles.spills() > 0);
+	BOOST_CHECK(tiles.bytes() <= (qint64) GridTiles::MinResidentTiles * GridTiles::TileBytes);
+	checkAll(tiles, reference);
+}
+
+BOOST_AUTO_TEST_CASE( gridtiles_evicted_uniform_tiles_collapse )
+{
+	// tiles whose cells all end up equal are dropped without being written out
+	Reference reference(64 * 20, 64 * 10, 1);
+	GridTiles tiles(reference.x, reference.y, reference.z, 0);
+	for (int iy = 0; iy < reference.y; iy++) {
+		for (int ix = 0; ix < reference.x; ix++) {
+			tiles.setAt(ix, iy, 0, 3);
+			reference.at(ix, iy, 0) = 3;
+		}
+	}
+
+	BOOST_CHECK_EQUAL(tiles.spills(), 0);
+	checkAll(tiles, reference);
+}
+
+BOOST_AUTO_TEST_CASE( gridtiles_touched_tiles )
+{
+	// clearing the maze router's expansion only visits the tiles written since it last did
+	GridTiles tiles(1000, 700, 2, 0);
+	BOOST_CHECK(tiles.touched(0).isEmpty());
+
+	tiles.setAt(10, 10, 0, 0);					// the tile's own value: nothing written
+	BOOST_CHECK(tiles.touched(0).isEmpty());
+
+	tiles.setAt(10, 10, 0, 5);
+	tiles.setAt(11, 12, 0, 5);
+	tiles.setAt(999, 699, 0, 5);
+	tiles.setAt(70, 3, 1, 5);
+	QList<QRect> touched = tiles.touched(0);
+	BOOST_REQUIRE_EQUAL(touched.count(), 2);
+	BOOST_CHECK(touched.at(0) == QRect(0, 0, GridTiles::TileSize, GridTiles::TileSize));
+	BOOST_CHECK(touched.at(1) == QRect(15 * GridTiles::TileSize, 10 * GridTiles::TileSize, 1000 - (15 * GridTiles::TileSize), 700 - (10 * GridTiles::TileSize)));
+	BOOST_REQUIRE_EQUAL(tiles.touched(1).count(), 1);
+	BOOST_CHECK(tiles.touched(1).at(0).contains(70, 3));
+
+	tiles.forgetTouched();
+	BOOST_CHECK(tiles.touched(0).isEmpty());
+	BOOST_CHECK(tiles.touched(1).isEmpty());
+	BOOST_CHECK_EQUAL(tiles.at(999, 699, 0), 5u);
+
+	// copying writes every tile of the target layer
+	tiles.copy(0, 1);
+	BOOST_CHECK_EQUAL(tiles.touched(1).count(), 16 * 11);
+	BOOST_CHECK(tiles.touched(0).isEmpty());
+}
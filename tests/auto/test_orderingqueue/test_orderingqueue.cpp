@@ -0,0 +1,222 @@
+#define BOOST_TEST_MODULE OrderingQueue Tests
+#include <boost/test/included/unit_test.hpp>
+
+#include "autoroute/mazerouter/orderingqueue.h"
+
+#include <QFuture>
+#include <QList>
+#include <QVector>
+#include <QtConcurrent>
+
+/*
+search() is MazeRouter::search() over a toy board.  routeNets() stands in for the real one: it routes
+the nets in order, and a net fails when one of its blockers went before it.  Like MazeRouter::routeOne(),
+the first failing net that moveBack() can queue new orderings for stops the pass.  With more than one
+worker, the queued orderings are routed in batches on the thread pool against copies of the queue and
+merged with OrderingQueue::merge(), as MazeRouter::routeBatch() does.
+*/
+
+static const int NetCount = 9;
+
+struct ToyScore {
+	NetOrdering ordering;
+	int routed = 0;
+	int reorderNet = -1;
+	bool anyUnrouted = false;
+};
+
+static bool Solvable = false;
+
+static QList<int> blockers(int net) {
+	QList<int> result;
+	if (Solvable) {
+		// the last few nets have to go first, in reverse
+		if (net >= NetCount - 3) result << net - 1;
+		return result;
+	}
+
+	// a fixed tangle: no ordering routes everything, so the search runs until maxCycles
+	for (int other = 0; other < NetCount; other++) {
+		if (other != net && ((net * 7 + other * 3) % 5) == 0) result << other;
+	}
+	return result;
+}
+
+static void routeNets(ToyScore & score, QList<NetOrdering> & allOrderings, int lookahead) {
+	const QList<int> & order = score.ordering.order;
+	for (int i = 0; i < order.count(); i++) {
+		bool blocked = false;
+		Q_FOREACH (int blocker, blockers(order.at(i))) {
+			if (order.indexOf(blocker) < i) blocked = true;
+		}
+		if (!blocked) {
+			score.routed++;
+			continue;
+		}
+
+		score.anyUnrouted = true;
+		if (score.reorderNet < 0 && OrderingQueue::moveBack(order, i, lookahead, allOrderings) > 0) {
+			score.reorderNet = order.at(i);
+			return;
+		}
+	}
+}
+
+static bool betterScore(const ToyScore & score, const ToyScore & bestScore) {
+	return bestScore.ordering.order.isEmpty() || score.routed > bestScore.routed;
+}
+
+struct Outcome {
+	QList<NetOrdering> allOrderings;
+	ToyScore bestScore;
+	int rounds = 0;
+	int batches = 0;
+};
+
+static Outcome search(int workers, int lookahead, int maxCycles) {
+	Outcome outcome;
+	NetOrdering initialOrdering;
+	for (int net = 0; net < NetCount; net++) initialOrdering.order << net;
+	QList<NetOrdering> & allOrderings = outcome.allOrderings;
+	allOrderings << initialOrdering;
+	ToyScore & bestScore = outcome.bestScore;
+
+	int run = 0;
+	while (run < maxCycles && run < allOrderings.count()) {
+		int batchCount = OrderingQueue::batchCount(run, maxCycles, allOrderings.count(), workers);
+		if (batchCount > 1) {
+			outcome.batches++;
+			QVector<ToyScore> scores(batchCount);
+			QVector< QList<NetOrdering> > orderings(batchCount);
+			QList< QFuture<void> > futures;
+			for (int i = 0; i < batchCount; i++) {
+				scores[i].ordering = allOrderings.at(run + i);
+				orderings[i] = allOrderings;
+				ToyScore * score = &scores[i];
+				QList<NetOrdering> * workerOrderings = &orderings[i];
+				futures << QtConcurrent::run([score, workerOrderings, lookahead]() {
+					routeNets(*score, *workerOrderings, lookahead);
+				});
+			}
+			Q_FOREACH (QFuture<void> future, futures) {
+				future.waitForFinished();
+			}
+
+			auto reroute = [&](int i, ToyScore & score) {
+				score = ToyScore();
+				score.ordering = allOrderings.at(run + i);
+				routeNets(score, allOrderings, lookahead);
+			};
+			auto keep = [&](const ToyScore & score) {
+				if (betterScore(score, bestScore)) bestScore = score;
+				return bestScore.anyUnrouted;
+			};
+			run += OrderingQueue::merge(scores, lookahead, allOrderings, reroute, keep) - 1;
+		}
+		else {
+			ToyScore score;
+			score.ordering = allOrderings.at(run);
+			routeNets(score, allOrderings, lookahead);
+			if (betterScore(score, bestScore)) bestScore = score;
+		}
+		if (!bestScore.anyUnrouted) break;
+
+		run++;
+	}
+
+	outcome.rounds = run;
+	return outcome;
+}
+
+static void checkSame(const Outcome & serial, const Outcome & batched) {
+	BOOST_CHECK_EQUAL(serial.rounds, batched.rounds);
+	BOOST_REQUIRE_EQUAL(serial.allOrderings.count(), batched.allOrderings.count());
+	for (int i = 0; i < serial.allOrderings.count(); i++) {
+		BOOST_CHECK(serial.allOrderings.at(i).order == batched.allOrderings.at(i).order);
+	}
+	BOOST_CHECK(serial.bestScore.ordering.order == batched.bestScore.ordering.order);
+	BOOST_CHECK_EQUAL(serial.bestScore.routed, batched.bestScore.routed);
+}
+
+BOOST_AUTO_TEST_CASE( orderingqueue_move_back_one )
+{
+	// the original move-back: the nearest earlier place that has not been tried
+	QList<NetOrdering> allOrderings;
+	NetOrdering ordering;
+	ordering.order << 0 << 1 << 2 << 3;
+	allOrderings << ordering;
+	NetOrdering tried;
+	tried.order << 0 << 1 << 3 << 2;
+	allOrderings << tried;
+
+	BOOST_CHECK_EQUAL(OrderingQueue::moveBack(ordering.order, 3, 1, allOrderings), 1);
+	BOOST_REQUIRE_EQUAL(allOrderings.count(), 3);
+	BOOST_CHECK(allOrderings.last().order == (QList<int>() << 0 << 3 << 1 << 2));
+
+	BOOST_CHECK_EQUAL(OrderingQueue::moveBack(ordering.order, 0, 1, allOrderings), 0);
+	BOOST_CHECK_EQUAL(allOrderings.count(), 3);
+}
+
+BOOST_AUTO_TEST_CASE( orderingqueue_move_back_lookahead )
+{
+	QList<NetOrdering> allOrderings;
+	NetOrdering ordering;
+	ordering.order << 0 << 1 << 2 << 3;
+	allOrderings << ordering;
+
+	BOOST_CHECK_EQUAL(OrderingQueue::moveBack(ordering.order, 3, 2, allOrderings), 2);
+	BOOST_REQUIRE_EQUAL(allOrderings.count(), 3);
+	BOOST_CHECK(allOrderings.at(1).order == (QList<int>() << 0 << 1 << 3 << 2));
+	BOOST_CHECK(allOrderings.at(2).order == (QList<int>() << 0 << 3 << 1 << 2));
+
+	// only the place left is queued
+	BOOST_CHECK_EQUAL(OrderingQueue::moveBack(ordering.order, 3, 2, allOrderings), 1);
+	BOOST_CHECK(allOrderings.last().order == (QList<int>() << 3 << 0 << 1 << 2));
+	BOOST_CHECK_EQUAL(OrderingQueue::moveBack(ordering.order, 3, 2, allOrderings), 0);
+}
+
+BOOST_AUTO_TEST_CASE( orderingqueue_no_batch_without_lookahead )
+{
+	// one move-back per pass never queues more than the next ordering
+	Outcome outcome = search(4, 1, 60);
+	BOOST_CHECK_EQUAL(outcome.batches, 0);
+	checkSame(search(1, 1, 60), outcome);
+}
+
+BOOST_AUTO_TEST_CASE( orderingqueue_batch_matches_serial )
+{
+	for (int lookahead = 2; lookahead <= 4; lookahead++) {
+		Outcome serial = search(1, lookahead, 60);
+		BOOST_CHECK_EQUAL(serial.batches, 0);
+		BOOST_CHECK_EQUAL(serial.rounds, 60);
+		for (int workers = 2; workers <= 5; workers++) {
+			Outcome batched = search(workers, lookahead, 60);
+			BOOST_CHECK(batched.batches > 0);
+			checkSame(serial, batched);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE( orderingqueue_batch_stops_where_serial_does )
+{
+	// the batch that holds the ordering routing everything is only taken up to it
+	Solvable = true;
+	for (int lookahead = 1; lookahead <= 4; lookahead++) {
+		Outcome serial = search(1, lookahead, 100);
+		BOOST_CHECK(!serial.bestScore.anyUnrouted);
+		BOOST_CHECK_EQUAL(serial.bestScore.routed, NetCount);
+		for (int workers = 2; workers <= 5; workers++) {
+			Outcome batched = search(workers, lookahead, 100);
+			BOOST_CHECK_EQUAL(batched.batches > 0, lookahead > 1);
+			checkSame(serial, batched);
+		}
+	}
+	Solvable = false;
+}
+
+BOOST_AUTO_TEST_CASE( orderingqueue_batch_stops_at_max_cycles )
+{
+	for (int maxCycles = 1; maxCycles <= 12; maxCycles++) {
+		checkSame(search(1, 3, maxCycles), search(3, 3, maxCycles));
+	}
+}
@@ -0,0 +1,125 @@
+#define BOOST_TEST_MODULE PixelScan Tests
+#include <boost/test/included/unit_test.hpp>
+
+#include "autoroute/pixelscan.h"
+
+#include <random>
+#include <vector>
+
+/*
+PixelScan::collisions() replaces the per-pixel loop of the DRC's pixelsCollide().  reference() is
+that loop, as it was, for one scanline; both must find the same pixels and mark the same display bytes.
+*/
+
+static std::vector<int> reference(const uchar * bits1, const uchar * bits2, int x1, int x2, std::vector<uchar> & display, uchar clr)
+{
+	static const uchar BitTable[] = { 128, 64, 32, 16, 8, 4, 2, 1 };
+	std::vector<int> xs;
+	for (int x = x1; x < x2; x++) {
+		int byteOffset = x >> 3;
+		uchar mask = BitTable[x & 7];
+
+		if ((*(bits1 + byteOffset) & mask) != 0) continue;
+		if ((*(bits2 + byteOffset) & mask) != 0) continue;
+
+		display[x] = clr;
+		xs.push_back(x);
+	}
+	return xs;
+}
+
+// one scanline of each Format_Mono image, 32-bit aligned like QImage, and of the Indexed8 display
+struct Lines {
+	int width;
+	int bytesPerLine;
+	std::vector<uchar> bits1;
+	std::vector<uchar> bits2;
+
+	Lines(int width) : width(width), bytesPerLine(((width + 31) / 32) * 4), bits1(bytesPerLine, 0xff), bits2(bytesPerLine, 0xff) {}
+};
+
+static void check(const Lines & lines, int x1, int x2)
+{
+	std::vector<uchar> expectedDisplay(lines.width, 0);
+	std::vector<int> expected = reference(lines.bits1.data(), lines.bits2.data(), x1, x2, expectedDisplay, 1);
+
+	std::vector<uchar> display(lines.width, 0);
+	std::vector<int> xs(lines.width + 1, -1);
+	int count = PixelScan::collisions(lines.bits1.data(), lines.bits2.data(), lines.bytesPerLine, x1, x2, display.data(), 1, xs.data(), lines.width, false);
+	BOOST_REQUIRE_EQUAL(count, (int) expected.size());
+	BOOST_CHECK(std::equal(expected.begin(), expected.end(), xs.begin()));
+	BOOST_CHECK(display == expectedDisplay);
+
+	// only as many positions as asked for, but still the full count
+	if (count > 2) {
+		std::fill(xs.begin(), xs.end(), -1);
+		BOOST_CHECK_EQUAL(PixelScan::collisions(lines.bits1.data(), lines.bits2.data(), lines.bytesPerLine, x1, x2, nullptr, 1, xs.data(), 2, false), count);
+		BOOST_CHECK_EQUAL(xs[1], expected[1]);
+		BOOST_CHECK_EQUAL(xs[2], -1);
+	}
+
+	// the first hit only
+	int first = -1;
+	count = PixelScan::collisions(lines.bits1.data(), lines.bits2.data(), lines.bytesPerLine, x1, x2, nullptr, 1, &first, 1, true);
+	BOOST_REQUIRE_EQUAL(count, expected.empty() ? 0 : 1);
+	if (count == 1) BOOST_CHECK_EQUAL(first, expected[0]);
+}
+
+static void clearBit(std::vector<uchar> & bits, int x)
+{
+	bits[x >> 3] &= ~(0x80 >> (x & 7));
+}
+
+BOOST_AUTO_TEST_CASE( pixelscan_single_bits )
+{
+	// one pixel black in both, and windows that contain it or just miss it
+	const int width = 300;
+	for (int x = 0; x < width; x += 5) {
+		Lines lines(width);
+		clearBit(lines.bits1, x);
+		clearBit(lines.bits2, x);
+		check(lines, 0, width);
+		check(lines, x, x + 1);
+		check(lines, x + 1, width);
+		check(lines, 0, x);
+		check(lines, qMax(0, x - 70), qMin(width, x + 3));
+	}
+}
+
+BOOST_AUTO_TEST_CASE( pixelscan_one_side_only )
+{
+	// black in one image only is not a collision
+	Lines lines(200);
+	std::fill(lines.bits1.begin(), lines.bits1.end(), 0);
+	check(lines, 0, 200);
+	check(lines, 17, 150);
+}
+
+BOOST_AUTO_TEST_CASE( pixelscan_random )
+{
+	std::mt19937 random(20240702);
+	for (int round = 0; round < 2000; round++) {
+		int width = 1 + (random() % 400);
+		Lines lines(width);
+		// runs of black in each, so there are words full of collisions and words with none
+		int density = random() % 8;
+		for (int i = 0; i < lines.bytesPerLine; i++) {
+			if ((int) (random() % 16) < density) lines.bits1[i] = random() & 0xff;
+			if ((int) (random() % 16) < density) lines.bits2[i] = (random() % 3) == 0 ? 0 : random() & 0xff;
+		}
+		int x1 = random() % width;
+		int x2 = x1 + 1 + (random() % (width - x1));
+		check(lines, x1, x2);
+	}
+}
+
+BOOST_AUTO_TEST_CASE( pixelscan_all_black )
+{
+	for (int width : { 1, 63, 64, 65, 96, 128, 200 }) {
+		Lines lines(width);
+		std::fill(lines.bits1.begin(), lines.bits1.end(), 0);
+		std::fill(lines.bits2.begin(), lines.bits2.end(), 0);
+		check(lines, 0, width);
+		check(lines, width / 3, width);
+	}
+}
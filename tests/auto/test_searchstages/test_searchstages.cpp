@@ -0,0 +1,117 @@
+#define BOOST_TEST_MODULE SearchStages Tests
+#include <boost/test/included/unit_test.hpp>
+
+#include "autoroute/mazerouter/searchstages.h"
+
+#include <QPoint>
+#include <QRect>
+#include <QVector>
+
+#include <deque>
+
+/*
+SearchStages counts the node budget of one connection the way MazeRouter::route() spends it.
+search() is route() on a toy board: a breadth-first search, first inside a corridor box around
+source and target, then over the whole board.  A wall between them has its only gap outside the
+box, so the corridor fails and only the whole board can route the connection.
+*/
+
+static const int Size = 30;
+static const QPoint Source(5, 15);
+static const QPoint Target(15, 15);
+static const QRect Corridor(4, 10, 13, 11);
+
+static bool wall(int x, int y) {
+	return x == 10 && y != Size - 2;
+}
+
+struct Result {
+	bool found = false;
+	bool overBudget = false;
+	int stage = 0;
+	QVector<qint64> stageNodes;
+};
+
+static Result search(qint64 budget) {
+	Result result;
+	SearchStages stages(budget, true);
+	while (true) {
+		QRect bound = stages.bounded() ? Corridor : QRect(0, 0, Size, Size);
+		QVector<bool> seen(Size * Size, false);
+		std::deque<QPoint> queue;
+		queue.push_back(Source);
+		seen[Source.y() * Size + Source.x()] = true;
+		qint64 before = stages.expanded();
+		while (!queue.empty()) {
+			QPoint p = queue.front();
+			queue.pop_front();
+			if (p == Target) {
+				result.found = true;
+				break;
+			}
+
+			static const int dx[] = { -1, 1, 0, 0 };
+			static const int dy[] = { 0, 0, -1, 1 };
+			for (int i = 0; i < 4; i++) {
+				QPoint next(p.x() + dx[i], p.y() + dy[i]);
+				if (!bound.contains(next) || wall(next.x(), next.y())) continue;
+				if (seen[next.y() * Size + next.x()]) continue;
+
+				seen[next.y() * Size + next.x()] = true;
+				queue.push_back(next);
+			}
+			if (!stages.expand()) break;
+		}
+		result.stageNodes << stages.expanded() - before;
+
+		if (result.found || !stages.bounded()) break;
+
+		stages.widen(false);
+	}
+
+	result.overBudget = stages.overBudget();
+	result.stage = stages.stage();
+	return result;
+}
+
+BOOST_AUTO_TEST_CASE( searchstages_unlimited )
+{
+	Result result = search(0);
+	BOOST_CHECK(result.found);
+	BOOST_CHECK(!result.overBudget);
+	BOOST_CHECK_EQUAL(result.stage, 1);
+	BOOST_REQUIRE_EQUAL(result.stageNodes.count(), 2);
+	BOOST_CHECK(result.stageNodes.at(0) > 0);
+	BOOST_CHECK(result.stageNodes.at(1) > result.stageNodes.at(0));
+}
+
+BOOST_AUTO_TEST_CASE( searchstages_corridor_fails_board_routes )
+{
+	Result unlimited = search(0);
+	qint64 corridorNodes = unlimited.stageNodes.at(0);
+	qint64 boardNodes = unlimited.stageNodes.at(1);
+
+	// enough for the whole board on its own, though not for the corridor and the whole board together
+	qint64 budget = boardNodes + 1;
+	BOOST_REQUIRE(corridorNodes + boardNodes >= budget);
+	Result result = search(budget);
+	BOOST_CHECK(result.found);
+	BOOST_CHECK(!result.overBudget);
+	BOOST_CHECK_EQUAL(result.stage, 1);
+
+	// a corridor that runs out of budget widens rather than giving up
+	budget = corridorNodes / 2;
+	result = search(budget);
+	BOOST_CHECK_EQUAL(result.stage, 1);
+	BOOST_CHECK_EQUAL(result.stageNodes.at(0), budget);
+}
+
+BOOST_AUTO_TEST_CASE( searchstages_board_over_budget )
+{
+	Result unlimited = search(0);
+	qint64 budget = unlimited.stageNodes.at(1) / 2;
+	Result result = search(budget);
+	BOOST_CHECK(!result.found);
+	BOOST_CHECK(result.overBudget);
+	BOOST_CHECK_EQUAL(result.stageNodes.at(1), budget);
+}
@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+# usage:
+#   bench_mazerouter.py --fritzing <binary> [--out <dir>] [--baseline <json>] [--tolerance <percent>]
+#
+#   Autoroute a fixed corpus of the bundled sketches with the headless -autoroute service mode
+#   and pinned settings, and record per sketch: wall time per router phase (makeMasters, routeNets,
+#   createTraces, optimizeTraces), peak process memory, peak grid bytes, nodes expanded,
+#   routed connections, vias and jumpers, and how many connections fell out of each search bound.
+#
+#   Writes <out>/bench_mazerouter.json and <out>/bench_mazerouter.csv.  With --baseline, compares
+#   against an earlier bench_mazerouter.json and exits with 1 if any sketch routes fewer connections,
+#   needs more vias or jumpers, or is more than --tolerance percent slower in the routing phase.
+#
+#   Each run gets an empty settings directory, so router settings (workers, frontier, strategy...)
+#   are the defaults unless given with --setting key=value.  On macOS QSettings ignores
+#   XDG_CONFIG_HOME, so there the user's own autorouter settings apply.
+
+import argparse, csv, json, os, subprocess, sys, tempfile
+
+CORPUS = [
+    "Button.fzz",
+    "AnalogInputPot.fzz",
+    "Relay.fzz",
+    "Op-amp.fzz",
+    "LCD.fzz",
+    "TrafficLight.fzz",
+    "ArduinoISP.fzz",
+    "Stepper_Motor.fzz",
+    "LED-Matrix.fzz",
+    "Countdown.fzz",
+    "Shift_Register_2x.fzz",
+    "Timer.fzz",
+]
+
+KEEPOUT = "10mil"
+MAX_CYCLES = 20
+
+FIELDS = ["sketch", "ok", "connections", "routed", "vias", "jumpers", "wallTimeMs",
+          "makeMastersMs", "routeMs", "createTracesMs", "optimizeTracesMs",
+          "nodesExpanded", "corridorFallbacks", "regionFallbacks", "budgetHits",
+          "peakGridBytes", "gridTileSpills", "peakRssBytes", "error"]
+
+
+def parse_summary(stdout):
+    # the service prints one JSON object; anything before it is not ours
+    start = stdout.find("{")
+    if start < 0:
+        return None
+    try:
+        return json.loads(stdout[start:])
+    except ValueError:
+        return None
+
+
+def write_settings(configDir, settings):
+    if not settings:
+        return
+    folder = os.path.join(configDir, "Fritzing")
+    os.makedirs(folder, exist_ok=True)
+    groups = {}
+    for key, value in settings:
+        group, _, name = key.rpartition("/")
+        groups.setdefault(group or "General", []).append((name, value))
+    with open(os.path.join(folder, "Fritzing.conf"), "w") as f:
+        for group, values in groups.items():
+            f.write("[%s]\n" % group)
+            for name, value in values:
+                f.write("%s=%s\n" % (name, value))
+
+
+def run_one(binary, sketch, workDir, settings, cycles):
+    name = os.path.basename(sketch)
+    output = os.path.join(workDir, "routed-" + name)
+    configDir = tempfile.mkdtemp(dir=workDir)
+    write_settings(configDir, settings)
+    env = dict(os.environ)
+    env["QT_QPA_PLATFORM"] = "offscreen"
+    env["XDG_CONFIG_HOME"] = configDir
+
+    command = [binary, "-autoroute", sketch, output, "-keepout", KEEPOUT,
+               "-maxcycles", str(cycles), "-bothsides", "yes"]
+    process = subprocess.Popen(command, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, env=env)
+    stdout = process.stdout.read().decode("utf-8", "replace")
+    process.stdout.close()
+    _, status, usage = os.wait4(process.pid, 0)
+
+    # ru_maxrss is kilobytes on Linux and bytes on macOS
+    peakRss = usage.ru_maxrss if sys.platform == "darwin" else usage.ru_maxrss * 1024
+
+    record = dict.fromkeys(FIELDS, "")
+    record["sketch"] = name
+    record["peakRssBytes"] = peakRss
+    summary = parse_summary(stdout)
+    if summary is None:
+        record["ok"] = False
+        record["error"] = "no summary (exit status %d)" % status
+        return record
+
+    for key in FIELDS:
+        if key in summary:
+            record[key] = summary[key]
+    for key, value in summary.get("phases", {}).items():
+        record[key] = value
+    for key, value in summary.get("bounds", {}).items():
+        if key in FIELDS:
+            # per region size, smallest first
+            record[key] = "/".join(str(v) for v in value) if isinstance(value, list) else value
+    return record
+
+
+def compare(records, baselinePath, tolerance):
+    with open(baselinePath) as f:
+        baseline = {r["sketch"]: r for r in json.load(f)["results"]}
+
+    regressions = []
+    for record in records:
+        before = baseline.get(record["sketch"])
+        if before is None or not before.get("ok"):
+            continue
+        if not record.get("ok"):
+            regressions.append("%s: failed (%s)" % (record["sketch"], record.get("error")))
+            continue
+        if record["routed"] < before["routed"]:
+            regressions.append("%s: routed %d, was %d" % (record["sketch"], record["routed"], before["routed"]))
+        if record["vias"] > before["vias"]:
+            regressions.append("%s: %d vias, was %d" % (record["sketch"], record["vias"], before["vias"]))
+        if record["jumpers"] > before["jumpers"]:
+            regressions.append("%s: %d jumpers, was %d" % (record["sketch"], record["jumpers"], before["jumpers"]))
+        limit = before["routeMs"] * (1 + tolerance / 100.0)
+        if record["routeMs"] > limit and record["routeMs"] - before["routeMs"] > 50:
+            regressions.append("%s: routing took %d ms, was %d ms" % (record["sketch"], record["routeMs"], before["routeMs"]))
+    return regressions
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description="Benchmark the maze autorouter over bundled sketches.")
+    parser.add_argument("--fritzing", required=True, help="path to the Fritzing binary")
+    parser.add_argument("--sketches", default=os.path.join(here, "..", "..", "sketches", "core"))
+    parser.add_argument("--out", default=".")
+    parser.add_argument("--baseline", help="bench_mazerouter.json from an earlier run")
+    parser.add_argument("--tolerance", type=float, default=25.0, help="allowed routing slowdown, percent")
+    parser.add_argument("--cycles", type=int, default=MAX_CYCLES)
+    parser.add_argument("--setting", action="append", default=[], help="key=value, e.g. cmrouter/workers=4")
+    parser.add_argument("--only", action="append", default=[], help="run just this corpus sketch")
+    args = parser.parse_args()
+
+    settings = []
+    for setting in args.setting:
+        key, sep, value = setting.partition("=")
+        if not sep:
+            parser.error("--setting expects key=value, got '%s'" % setting)
+        settings.append((key, value))
+
+    corpus = args.only or CORPUS
+    os.makedirs(args.out, exist_ok=True)
+    records = []
+    with tempfile.TemporaryDirectory() as workDir:
+        for name in corpus:
+            record = run_one(os.path.abspath(args.fritzing), os.path.abspath(os.path.join(args.sketches, name)), workDir, settings, args.cycles)
+            records.append(record)
+            print("%-24s %s routed %s/%s vias %s route %s ms" % (name, "ok  " if record["ok"] else "FAIL",
+                  record["routed"], record["connections"], record["vias"], record["routeMs"]))
+
+    result = {"keepout": KEEPOUT, "cycles": args.cycles, "settings": dict(settings), "results": records}
+    with open(os.path.join(args.out, "bench_mazerouter.json"), "w") as f:
+        json.dump(result, f, indent=2)
+    with open(os.path.join(args.out, "bench_mazerouter.csv"), "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=FIELDS)
+        writer.writeheader()
+        writer.writerows(records)
+
+    if args.baseline:
+        regressions = compare(records, args.baseline, args.tolerance)
+        for regression in regressions:
+            print("REGRESSION " + regression)
+        if regressions:
+            sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()